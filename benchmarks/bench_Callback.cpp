@@ -0,0 +1,219 @@
+/**
+ * Throughput of many concurrent requests completed through futures and
+ * through the callback overload of MCurlHttpClient::makeRequest.
+ *
+ * With futures every request in flight parks a thread on get(), so the
+ * baseline keeps `concurrency` threads each sending its requests in a loop.
+ * With callbacks the same number of requests is kept in flight by a pool of
+ * `threads` threads, the executor of the callbacks, each completion reading
+ * the body and sending the next request. The transfers share the connections
+ * of the client in both cases.
+ *
+ * Usage: bench_Callback [requests] [concurrency] [threads] [url]
+ *
+ * Without a url the responses are served by a local stand-in server started
+ * by the benchmark.
+ */
+#include <darabonba/Core.hpp>
+#include <darabonba/Stream.hpp>
+#include <darabonba/http/MCurlHttpClient.hpp>
+#include <darabonba/http/MCurlResponse.hpp>
+#include <darabonba/http/Request.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LoopbackServer.hpp"
+
+using namespace Darabonba;
+using namespace Darabonba::Http;
+
+namespace {
+
+// Answers every request of a keep-alive connection with a small body
+std::string smallResponse() {
+  std::string payload(256, 'r');
+  return "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\n"
+         "Content-Length: " +
+         std::to_string(payload.size()) + "\r\n\r\n" + payload;
+}
+
+// A fixed pool of threads running the callbacks
+class ThreadPool {
+public:
+  explicit ThreadPool(int threads) {
+    for (int i = 0; i < threads; ++i) {
+      workers_.emplace_back([this]() { work(); });
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto &t : workers_) {
+      t.join();
+    }
+  }
+
+  void post(std::function<void()> task) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+  }
+
+private:
+  void work() {
+    for (;;) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+        if (tasks_.empty())
+          return;
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+      task();
+    }
+  }
+
+  std::vector<std::thread> workers_;
+  std::deque<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_ = false;
+};
+
+size_t drain(const std::shared_ptr<MCurlResponse> &response) {
+  if (!response || response->getStatusCode() != 200) {
+    std::fprintf(stderr, "request failed\n");
+    std::exit(1);
+  }
+  return Stream::readAsString(response->getBody()).size();
+}
+
+// The blocking baseline, a thread parked on get() per request in flight
+double runFutures(MCurlHttpClient &client, const std::string &url,
+                  int requests, int concurrency) {
+  std::atomic<int> next = {0};
+  std::atomic<size_t> bytes = {0};
+  auto begin = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < concurrency; ++i) {
+    threads.emplace_back([&]() {
+      while (next++ < requests) {
+        Request request(url);
+        bytes += drain(client.makeRequest(request, RequestConfig()).get());
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+  if (bytes == 0) {
+    std::fprintf(stderr, "no data received\n");
+    std::exit(1);
+  }
+  return requests / std::chrono::duration<double>(end - begin).count();
+}
+
+double runCallbacks(MCurlHttpClient &client, const std::string &url,
+                    int requests, int concurrency, int threads) {
+  std::atomic<int> next = {0};
+  std::atomic<int> completed = {0};
+  std::atomic<size_t> bytes = {0};
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::function<void()> send;
+  // joined before the state above, which its tasks use, is destroyed
+  ThreadPool pool(threads);
+  MCurlHttpClient::Executor executor = [&pool](std::function<void()> task) {
+    pool.post(std::move(task));
+  };
+
+  send = [&]() {
+    if (next++ >= requests)
+      return;
+    Request request(url);
+    client.makeRequest(
+        request, RequestConfig(),
+        [&](std::shared_ptr<MCurlResponse> response, std::exception_ptr) {
+          bytes += drain(response);
+          send();
+          if (++completed == requests) {
+            std::lock_guard<std::mutex> lock(mutex);
+            cv.notify_all();
+          }
+        },
+        executor);
+  };
+
+  auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < concurrency; ++i) {
+    send();
+  }
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&]() { return completed == requests; });
+  }
+  auto end = std::chrono::steady_clock::now();
+  if (bytes == 0) {
+    std::fprintf(stderr, "no data received\n");
+    std::exit(1);
+  }
+  return requests / std::chrono::duration<double>(end - begin).count();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int requests = argc > 1 ? std::atoi(argv[1]) : 20000;
+  int concurrency = argc > 2 ? std::atoi(argv[2]) : 1000;
+  int threads = argc > 3 ? std::atoi(argv[3]) : 4;
+  if (requests <= 0 || concurrency <= 0 || threads <= 0) {
+    std::fprintf(stderr, "usage: %s [requests] [concurrency] [threads] [url]\n",
+                 argv[0]);
+    return 1;
+  }
+  std::unique_ptr<Testing::LoopbackServer> server;
+  std::string url;
+  if (argc > 4) {
+    url = argv[4];
+  } else {
+    server.reset(new Testing::LoopbackServer(
+        Testing::LoopbackServer::respond(smallResponse()), true));
+    url = server->url();
+  }
+
+  {
+    MCurlHttpClient client;
+    client.start();
+    std::printf("%d requests, %d in flight\n", requests, concurrency);
+    std::printf("%-8s %22s %22s\n", "round",
+                (std::to_string(concurrency) + " threads(req/s)").c_str(),
+                (std::to_string(threads) + " threads+cb(req/s)").c_str());
+    for (int round = 1; round <= 3; ++round) {
+      double futures = runFutures(client, url, requests, concurrency);
+      double callbacks =
+          runCallbacks(client, url, requests, concurrency, threads);
+      std::printf("%-8d %22.0f %22.0f\n", round, futures, callbacks);
+    }
+    client.stop();
+  }
+  return 0;
+}
@@ -0,0 +1,123 @@
+/**
+ * Cost of the host -> client lookup of Core::doAction under many threads.
+ *
+ * Compares the previous global mutex + std::map lookup, which also reapplied
+ * the ConnectionPoolConfig on every call, with Http::ClientRegistry. The
+ * config never changes, so the registry stays on its lock-free path.
+ *
+ * Usage: bench_ClientRegistry [lookups per thread] [hosts]
+ */
+#include <darabonba/Core.hpp>
+#include <darabonba/http/ClientRegistry.hpp>
+#include <darabonba/http/MCurlHttpClient.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Darabonba;
+using namespace Darabonba::Http;
+
+namespace {
+
+using ClientPtr = std::shared_ptr<MCurlHttpClient>;
+
+class MutexMap {
+public:
+  ClientPtr get(const std::string &host, const ConnectionPoolConfig &config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = clients_.find(host);
+    if (it == clients_.end()) {
+      auto client = std::make_shared<MCurlHttpClient>();
+      client->setConnectionPoolConfig(config);
+      clients_[host] = client;
+      return client;
+    }
+    it->second->setConnectionPoolConfig(config);
+    return it->second;
+  }
+
+private:
+  std::mutex mutex_;
+  std::map<std::string, ClientPtr> clients_;
+};
+
+class Registry {
+public:
+  Registry()
+      : registry_([](const ConnectionPoolConfig &) {
+                    return std::make_shared<MCurlHttpClient>();
+                  },
+                  [](MCurlHttpClient &client,
+                     const ConnectionPoolConfig &config) {
+                    client.setConnectionPoolConfig(config);
+                  }) {}
+
+  ClientPtr get(const std::string &host, const ConnectionPoolConfig &config) {
+    return registry_.get(host, config);
+  }
+
+private:
+  ClientRegistry registry_;
+};
+
+template <typename Map>
+double run(int threads, int lookups, const std::vector<std::string> &hosts) {
+  Map map;
+  ConnectionPoolConfig config;
+  std::atomic<bool> go(false);
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t]() {
+      while (!go) {
+        std::this_thread::yield();
+      }
+      size_t index = static_cast<size_t>(t);
+      for (int i = 0; i < lookups; ++i) {
+        auto client = map.get(hosts[index % hosts.size()], config);
+        if (!client) {
+          std::abort();
+        }
+        ++index;
+      }
+    });
+  }
+  auto begin = std::chrono::steady_clock::now();
+  go = true;
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+  double ns = std::chrono::duration<double, std::nano>(end - begin).count();
+  // average wall time per lookup over all the threads
+  return ns / (static_cast<double>(threads) * lookups);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int lookups = argc > 1 ? std::atoi(argv[1]) : 200000;
+  int hostCount = argc > 2 ? std::atoi(argv[2]) : 32;
+  if (lookups <= 0 || hostCount <= 0) {
+    std::fprintf(stderr, "usage: %s [lookups per thread] [hosts]\n", argv[0]);
+    return 1;
+  }
+  std::vector<std::string> hosts;
+  for (int i = 0; i < hostCount; ++i) {
+    hosts.push_back("ecs-" + std::to_string(i) + ".cn-hangzhou.aliyuncs.com");
+  }
+
+  std::printf("%8s %16s %16s\n", "threads", "mutex+map(ns)", "registry(ns)");
+  for (int threads = 1; threads <= 64; threads *= 2) {
+    double baseline = run<MutexMap>(threads, lookups, hosts);
+    double registry = run<Registry>(threads, lookups, hosts);
+    std::printf("%8d %16.1f %16.1f\n", threads, baseline, registry);
+  }
+  return 0;
+}
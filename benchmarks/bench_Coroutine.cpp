@@ -0,0 +1,186 @@
+/**
+ * Completion time of many requests in flight at once, each with a thread
+ * blocked in get() and read(), and each as a coroutine awaiting asyncRequest
+ * and asyncReadSome.
+ *
+ * Every request of a round is started at once, the round ends when the body
+ * of the last one has been read. The coroutines are resumed on the perform
+ * thread, so the second round runs on the single thread of the client.
+ *
+ * Usage: bench_Coroutine [requests] [url]
+ *
+ * Without a url the responses are served by a local stand-in server started
+ * by the benchmark. The thread round needs a limit of processes and of
+ * memory maps above the number of requests.
+ */
+#include <darabonba/Core.hpp>
+#include <darabonba/http/Coroutine.hpp>
+#include <darabonba/http/MCurlHttpClient.hpp>
+#include <darabonba/http/MCurlResponse.hpp>
+#include <darabonba/http/Request.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LoopbackServer.hpp"
+
+#ifndef DARABONBA_HAS_COROUTINES
+#error "bench_Coroutine needs a compiler with C++20 coroutines"
+#endif
+
+using namespace Darabonba;
+using namespace Darabonba::Http;
+
+namespace {
+
+// Answers every request of a keep-alive connection with a small body
+std::string smallResponse() {
+  std::string payload(256, 'r');
+  return "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\n"
+         "Content-Length: " +
+         std::to_string(payload.size()) + "\r\n\r\n" + payload;
+}
+
+// A coroutine started at once and never awaited
+struct DetachedTask {
+  struct promise_type {
+    DetachedTask get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+class Counter {
+public:
+  explicit Counter(int target) : target_(target) {}
+
+  void add(size_t bytes) {
+    bytes_ += bytes;
+    if (++count_ == target_) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      cv_.notify_all();
+    }
+  }
+
+  size_t wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]() { return count_ == target_; });
+    return bytes_;
+  }
+
+private:
+  const int target_;
+  std::atomic<int> count_ = {0};
+  std::atomic<size_t> bytes_ = {0};
+  std::mutex mutex_;
+  std::condition_variable cv_;
+};
+
+void fail() {
+  std::fprintf(stderr, "request failed\n");
+  std::exit(1);
+}
+
+// The blocking baseline, a thread per request in flight
+double runThreads(MCurlHttpClient &client, const std::string &url,
+                  int requests) {
+  Counter counter(requests);
+  auto begin = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  threads.reserve(static_cast<size_t>(requests));
+  for (int i = 0; i < requests; ++i) {
+    threads.emplace_back([&]() {
+      Request request(url);
+      auto response = client.makeRequest(request, RequestConfig()).get();
+      if (!response || response->getStatusCode() != 200)
+        fail();
+      auto body = response->getBody();
+      char buffer[4096];
+      size_t size, total = 0;
+      while ((size = body->read(buffer, sizeof(buffer))) > 0) {
+        total += size;
+      }
+      counter.add(total);
+    });
+  }
+  auto bytes = counter.wait();
+  auto end = std::chrono::steady_clock::now();
+  for (auto &t : threads) {
+    t.join();
+  }
+  if (bytes == 0)
+    fail();
+  return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+DetachedTask fetch(MCurlHttpClient &client, const std::string &url,
+                   Counter &counter) {
+  Request request(url);
+  auto response = co_await asyncRequest(client, request);
+  if (!response || response->getStatusCode() != 200)
+    fail();
+  auto body = response->getBody();
+  char buffer[4096];
+  size_t size, total = 0;
+  while ((size = co_await asyncReadSome(*body, buffer, sizeof(buffer))) > 0) {
+    total += size;
+  }
+  counter.add(total);
+}
+
+double runCoroutines(MCurlHttpClient &client, const std::string &url,
+                     int requests) {
+  Counter counter(requests);
+  auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < requests; ++i) {
+    fetch(client, url, counter);
+  }
+  auto bytes = counter.wait();
+  auto end = std::chrono::steady_clock::now();
+  if (bytes == 0)
+    fail();
+  return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int requests = argc > 1 ? std::atoi(argv[1]) : 10000;
+  if (requests <= 0) {
+    std::fprintf(stderr, "usage: %s [requests] [url]\n", argv[0]);
+    return 1;
+  }
+  std::unique_ptr<Testing::LoopbackServer> server;
+  std::string url;
+  if (argc > 2) {
+    url = argv[2];
+  } else {
+    server.reset(new Testing::LoopbackServer(
+        Testing::LoopbackServer::respond(smallResponse()), true));
+    url = server->url();
+  }
+
+  {
+    MCurlHttpClient client;
+    client.start();
+    std::printf("%d requests in flight\n", requests);
+    std::printf("%-8s %18s %18s\n", "round", "threads(ms)", "coroutines(ms)");
+    for (int round = 1; round <= 3; ++round) {
+      double threads = runThreads(client, url, requests);
+      double coroutines = runCoroutines(client, url, requests);
+      std::printf("%-8d %18.1f %18.1f\n", round, threads, coroutines);
+    }
+    client.stop();
+  }
+  return 0;
+}
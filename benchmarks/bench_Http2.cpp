@@ -0,0 +1,155 @@
+/**
+ * Connection count and latency of concurrent requests with and without the
+ * HTTP/2 mode of ConnectionPoolConfig.
+ *
+ * Every request of a round is submitted at once, the latency of a request
+ * is measured from makeRequest until its body is complete. The HTTP/2 round
+ * limits the connections to requests / max_concurrent_streams.
+ *
+ * Usage: bench_Http2 <url> [requests] [h2|h2c]
+ *
+ * A local stand-in server can be started with nghttpd, for example
+ *   nghttpd --no-tls 8080 -d <docroot>          (h2c, plain http)
+ *   nghttpd 8443 key.pem cert.pem -d <docroot>  (h2 over TLS with ALPN)
+ */
+#include <darabonba/Core.hpp>
+#include <darabonba/http/MCurlHttpClient.hpp>
+#include <darabonba/http/MCurlResponse.hpp>
+#include <darabonba/http/Request.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Darabonba;
+using namespace Darabonba::Http;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+  size_t ok = 0;
+  uint64_t connects = 0;
+  double p50 = 0;
+  double p99 = 0;
+  double seconds = 0;
+};
+
+Result run(const std::string &url, int requests,
+           const ConnectionPoolConfig &config) {
+  MCurlHttpClient client;
+  client.setConnectionPoolConfig(config);
+  client.start();
+
+  Darabonba::Json options = {{"ignoreSSL", true},
+                             {"connectTimeout", 10000},
+                             {"readTimeout", 60000}};
+  std::vector<std::future<std::shared_ptr<MCurlResponse>>> futures;
+  std::vector<std::shared_ptr<MCurlResponse>> responses(requests);
+  std::vector<Clock::time_point> starts;
+  std::vector<double> latencies;
+  futures.reserve(requests);
+  starts.reserve(requests);
+
+  auto begin = Clock::now();
+  for (int i = 0; i < requests; ++i) {
+    Request request(url);
+    starts.push_back(Clock::now());
+    futures.push_back(client.makeRequest(request, options));
+  }
+
+  Result result;
+  std::vector<bool> finished(requests, false);
+  int remaining = requests;
+  std::vector<char> buffer(64 * 1024);
+  while (remaining > 0) {
+    for (int i = 0; i < requests; ++i) {
+      if (finished[i])
+        continue;
+      if (!responses[i]) {
+        if (futures[i].wait_for(std::chrono::seconds(0)) !=
+            std::future_status::ready)
+          continue;
+        try {
+          responses[i] = futures[i].get();
+        } catch (const std::exception &e) {
+          std::fprintf(stderr, "request %d failed: %s\n", i, e.what());
+        }
+        if (!responses[i]) {
+          finished[i] = true;
+          --remaining;
+          continue;
+        }
+      }
+      auto body = responses[i]->getBody();
+      // drain what has arrived so far without blocking
+      while (body->getReadableSize() > 0) {
+        body->read(buffer.data(), buffer.size());
+      }
+      if (body->getDone() && body->getReadableSize() == 0) {
+        latencies.push_back(
+            std::chrono::duration<double, std::milli>(Clock::now() - starts[i])
+                .count());
+        finished[i] = true;
+        --remaining;
+        ++result.ok;
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  result.seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+  result.connects = client.getConnectCount();
+  client.stop();
+
+  if (!latencies.empty()) {
+    std::sort(latencies.begin(), latencies.end());
+    result.p50 = latencies[latencies.size() / 2];
+    result.p99 = latencies[latencies.size() * 99 / 100];
+  }
+  return result;
+}
+
+void print(const char *mode, const Result &r) {
+  std::printf("%-8s %8zu %10llu %10.1f %10.1f %10.2f\n", mode, r.ok,
+              static_cast<unsigned long long>(r.connects), r.p50, r.p99,
+              r.seconds);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    std::fprintf(stderr, "usage: %s <url> [requests] [h2|h2c]\n", argv[0]);
+    return 1;
+  }
+  std::string url = argv[1];
+  int requests = argc > 2 ? std::atoi(argv[2]) : 1000;
+  bool h2c = argc > 3 && std::strcmp(argv[3], "h2c") == 0;
+  if (requests <= 0) {
+    std::fprintf(stderr, "requests must be positive\n");
+    return 1;
+  }
+
+  std::printf("%-8s %8s %10s %10s %10s %10s\n", "mode", "ok", "connects",
+              "p50(ms)", "p99(ms)", "total(s)");
+
+  ConnectionPoolConfig http1;
+  print("http/1.1", run(url, requests, http1));
+
+  ConnectionPoolConfig http2;
+  http2.http2 = true;
+  http2.http2_prior_knowledge = h2c;
+  // a few connections carry all the streams, PIPEWAIT alone does not stop
+  // a burst of transfers from opening max_host_connections connections
+  http2.max_host_connections =
+      (static_cast<size_t>(requests) + http2.max_concurrent_streams - 1) /
+      http2.max_concurrent_streams;
+  print(h2c ? "h2c" : "h2", run(url, requests, http2));
+  return 0;
+}
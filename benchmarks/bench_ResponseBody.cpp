@@ -0,0 +1,128 @@
+/**
+ * Streaming throughput of a response body between the perform thread and a
+ * reader.
+ *
+ * Compares the SpinLock + RingBuffer + condition variable scheme
+ * MCurlResponseBody used to have, which locks and notifies on every write,
+ * with MCurlResponseBody on its SPSC pipe. One thread writes curl sized
+ * chunks, another one reads until the body ends.
+ *
+ * Usage: bench_ResponseBody [MB per run]
+ */
+#include <darabonba/buffer/RingBuffer.hpp>
+#include <darabonba/http/MCurlResponse.hpp>
+#include <darabonba/lock/SpinLock.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace Darabonba;
+
+namespace {
+
+// The previous body, kept here as the baseline
+class LockedBody {
+public:
+  size_t write(char *buffer, size_t expectSize) {
+    {
+      std::lock_guard<Lock::SpinLock> lock(bufferLock_);
+      buffer_.write(buffer, expectSize);
+    }
+    {
+      std::lock_guard<std::mutex> lock(streamMutex_);
+      readableSize_ += expectSize;
+    }
+    streamCV_.notify_one();
+    return expectSize;
+  }
+
+  size_t read(char *buffer, size_t expectSize) {
+    for (;;) {
+      auto realSize = (std::min)(expectSize, readableSize_.load());
+      if (realSize != 0) {
+        {
+          std::lock_guard<Lock::SpinLock> lock(bufferLock_);
+          realSize = buffer_.read(buffer, realSize);
+        }
+        readableSize_ -= realSize;
+        return realSize;
+      }
+      if (done_)
+        return 0;
+      std::unique_lock<std::mutex> lock(streamMutex_);
+      streamCV_.wait(lock, [this]() { return done_ || readableSize_ > 0; });
+    }
+  }
+
+  void finish() {
+    {
+      std::lock_guard<std::mutex> lock(streamMutex_);
+      done_ = true;
+    }
+    streamCV_.notify_one();
+  }
+
+private:
+  Lock::SpinLock bufferLock_;
+  Buffer::RingBuffer buffer_;
+  std::atomic<size_t> readableSize_ = {0};
+  std::atomic<bool> done_ = {false};
+  std::mutex streamMutex_;
+  std::condition_variable streamCV_;
+};
+
+class PipeBody : public Http::MCurlResponseBody {
+public:
+  using MCurlResponseBody::finish;
+};
+
+template <typename Body> double run(size_t total, size_t chunkSize) {
+  Body body;
+  std::vector<char> chunk(chunkSize, 'b');
+  auto begin = std::chrono::steady_clock::now();
+  std::thread producer([&]() {
+    for (size_t sent = 0; sent < total; sent += chunkSize) {
+      body.write(chunk.data(), chunkSize);
+    }
+    body.finish();
+  });
+  std::vector<char> out(64 * 1024);
+  size_t received = 0;
+  size_t n = 0;
+  while ((n = body.read(out.data(), out.size())) > 0) {
+    received += n;
+  }
+  producer.join();
+  auto end = std::chrono::steady_clock::now();
+  if (received != total) {
+    std::fprintf(stderr, "lost data: %zu of %zu\n", received, total);
+    std::exit(1);
+  }
+  return static_cast<double>(total) / (1024.0 * 1024.0) /
+         std::chrono::duration<double>(end - begin).count();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int mb = argc > 1 ? std::atoi(argv[1]) : 256;
+  if (mb <= 0) {
+    std::fprintf(stderr, "usage: %s [MB per run]\n", argv[0]);
+    return 1;
+  }
+  size_t total = static_cast<size_t>(mb) * 1024 * 1024;
+  std::printf("%-10s %14s %14s\n", "chunk", "locked(MB/s)", "pipe(MB/s)");
+  for (size_t chunkSize = 1024; chunkSize <= 64 * 1024; chunkSize *= 4) {
+    // MAX_SIZE is not enforced here, the reader keeps up or the data waits
+    double locked = run<LockedBody>(total, chunkSize);
+    double pipe = run<PipeBody>(total, chunkSize);
+    std::printf("%-10zu %14.0f %14.0f\n", chunkSize, locked, pipe);
+  }
+  return 0;
+}
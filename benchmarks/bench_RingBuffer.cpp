@@ -0,0 +1,132 @@
+/**
+ * Cost of small reads from Buffer::RingBuffer holding a large body.
+ *
+ * Compares the std::list based ring RingBuffer used to be, where every size
+ * query walks the segments, with the current segment array. The buffer is
+ * filled with the 10 MB a response body may hold, then drained with reads of
+ * 1 B to 64 KB the way Stream::readAsBytes and user code read a body.
+ *
+ * Usage: bench_RingBuffer [buffered MB]
+ */
+#include <darabonba/buffer/RingBuffer.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <list>
+#include <vector>
+
+using namespace Darabonba;
+
+namespace {
+
+// The list based ring, kept here as the baseline
+class ListRing {
+public:
+  explicit ListRing(size_t segmentSize) : segmentSize_(segmentSize) {
+    data_.emplace_back(segmentSize_);
+    writeIter_ = data_.begin();
+  }
+
+  size_t readableSize() const {
+    return segmentSize_ * std::distance(data_.cbegin(),
+                                        decltype(data_.cbegin())(writeIter_)) +
+           nWrite_ - nRead_;
+  }
+
+  size_t writableSize() const {
+    return std::distance(std::next(decltype(data_.begin())(writeIter_)),
+                         data_.cend()) *
+               segmentSize_ +
+           (segmentSize_ - nWrite_);
+  }
+
+  size_t read(char *buffer, size_t expectSize) {
+    auto realSize = (std::min)(expectSize, readableSize());
+    for (auto remain = realSize; remain > 0;) {
+      auto cnt = (std::min)(remain, segmentSize_ - nRead_);
+      memcpy(buffer, data_.front().data() + nRead_, cnt);
+      buffer += cnt;
+      remain -= cnt;
+      nRead_ += cnt;
+      if (nRead_ == segmentSize_) {
+        data_.splice(data_.end(), data_, data_.begin());
+        nRead_ = 0;
+      }
+    }
+    return realSize;
+  }
+
+  size_t write(const char *buffer, size_t expectSize) {
+    auto remain = writableSize();
+    if (remain <= expectSize) {
+      for (size_t i = (expectSize - remain) / segmentSize_ + 1; i > 0; --i)
+        data_.emplace_back(segmentSize_);
+    }
+    for (auto left = expectSize; left > 0;) {
+      auto cnt = (std::min)(left, segmentSize_ - nWrite_);
+      memcpy(writeIter_->data() + nWrite_, buffer, cnt);
+      buffer += cnt;
+      left -= cnt;
+      nWrite_ += cnt;
+      if (nWrite_ == segmentSize_) {
+        ++writeIter_;
+        nWrite_ = 0;
+      }
+    }
+    return expectSize;
+  }
+
+private:
+  size_t segmentSize_;
+  std::list<std::vector<char>> data_;
+  std::list<std::vector<char>>::iterator writeIter_;
+  size_t nRead_ = 0;
+  size_t nWrite_ = 0;
+};
+
+template <typename Ring>
+double run(Ring &ring, size_t buffered, size_t readSize) {
+  std::vector<char> chunk(64 * 1024, 'x');
+  for (size_t left = buffered; left > 0;) {
+    auto n = (std::min)(left, chunk.size());
+    ring.write(chunk.data(), n);
+    left -= n;
+  }
+  std::vector<char> out(readSize);
+  // small reads only drain a bounded amount, the buffer stays large
+  size_t reads = (std::min)(buffered / readSize, size_t(200000));
+  auto begin = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < reads; ++i) {
+    ring.read(out.data(), readSize);
+  }
+  auto end = std::chrono::steady_clock::now();
+  while (ring.read(out.data(), out.size()) > 0) {
+  }
+  return std::chrono::duration<double, std::nano>(end - begin).count() /
+         static_cast<double>(reads);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int mb = argc > 1 ? std::atoi(argv[1]) : 10;
+  if (mb <= 0) {
+    std::fprintf(stderr, "usage: %s [buffered MB]\n", argv[0]);
+    return 1;
+  }
+  size_t buffered = static_cast<size_t>(mb) * 1024 * 1024;
+  std::printf("%-10s %14s %14s %10s\n", "read size", "list(ns/read)",
+              "array(ns/read)", "speedup");
+  for (size_t readSize = 1; readSize <= 64 * 1024; readSize *= 4) {
+    ListRing list(4 * 1024);
+    Buffer::RingBuffer array(4 * 1024);
+    double listNs = run(list, buffered, readSize);
+    double arrayNs = run(array, buffered, readSize);
+    std::printf("%-10zu %14.1f %14.1f %9.1fx\n", readSize, listNs, arrayNs,
+                listNs / arrayNs);
+  }
+  return 0;
+}
@@ -0,0 +1,157 @@
+/**
+ * Decoding throughput of a server-sent event stream read through
+ * MCurlHttpClient.
+ *
+ * Compares the usual hand-written loop, which appends every read to a string,
+ * searches it from the start for the blank line ending an event and splits
+ * the event into lines with std::getline, with SSEReader, which decodes the
+ * chunks of MCurlResponseBody in place. Each event carries an id, a type and
+ * a small JSON delta, like the token stream of an LLM endpoint.
+ *
+ * Usage: bench_SSE [events] [url]
+ *
+ * Without a url the events are served by a local stand-in server started by
+ * the benchmark.
+ */
+#include <darabonba/Core.hpp>
+#include <darabonba/http/MCurlHttpClient.hpp>
+#include <darabonba/http/MCurlResponse.hpp>
+#include <darabonba/http/Request.hpp>
+#include <darabonba/http/SSEParser.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LoopbackServer.hpp"
+
+using namespace Darabonba;
+using namespace Darabonba::Http;
+
+namespace {
+
+std::string makePayload(int events) {
+  std::string payload;
+  for (int i = 0; i < events; ++i) {
+    payload += "id: " + std::to_string(i) +
+               "\nevent: delta\ndata: {\"index\":" + std::to_string(i) +
+               ",\"content\":\"token\"}\n\n";
+  }
+  return payload;
+}
+
+// The stream the local server answers every request with
+std::string eventResponse(int events) {
+  auto payload = makePayload(events);
+  return "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n"
+         "Content-Length: " +
+         std::to_string(payload.size()) + "\r\n\r\n" + payload;
+}
+
+std::shared_ptr<MCurlResponseBody> openStream(MCurlHttpClient &client,
+                                              const std::string &url) {
+  Request request(url);
+  auto response = client.makeRequest(request, RequestConfig()).get();
+  if (!response || response->getStatusCode() != 200) {
+    std::fprintf(stderr, "request failed\n");
+    std::exit(1);
+  }
+  return std::dynamic_pointer_cast<MCurlResponseBody>(response->getBody());
+}
+
+// The hand-written loop, kept here as the baseline
+size_t splitLines(const std::shared_ptr<MCurlResponseBody> &body,
+                  size_t &checksum) {
+  size_t count = 0;
+  std::string pending;
+  std::vector<char> buffer(16 * 1024);
+  size_t n;
+  while ((n = body->read(buffer.data(), buffer.size())) > 0) {
+    pending.append(buffer.data(), n);
+    size_t end;
+    while ((end = pending.find("\n\n")) != std::string::npos) {
+      std::istringstream block(pending.substr(0, end));
+      pending.erase(0, end + 2);
+      SSEEvent event;
+      std::string line, data;
+      while (std::getline(block, line)) {
+        auto colon = line.find(':');
+        auto name = line.substr(0, colon);
+        auto value = colon == std::string::npos ? "" : line.substr(colon + 1);
+        if (!value.empty() && value[0] == ' ')
+          value.erase(0, 1);
+        if (name == "id") {
+          event.setId(value);
+        } else if (name == "event") {
+          event.setEvent(value);
+        } else if (name == "data") {
+          data += data.empty() ? value : "\n" + value;
+        }
+      }
+      event.setData(data);
+      checksum += event.getData().size();
+      ++count;
+    }
+  }
+  return count;
+}
+
+size_t decode(const std::shared_ptr<MCurlResponseBody> &body,
+              size_t &checksum) {
+  SSEReader reader(body);
+  return reader.forEach([&checksum](const SSEEvent &event) {
+    checksum += event.getData().size();
+  });
+}
+
+template <typename Parse>
+double run(MCurlHttpClient &client, const std::string &url, int events,
+           Parse parse) {
+  auto begin = std::chrono::steady_clock::now();
+  auto body = openStream(client, url);
+  size_t checksum = 0;
+  auto count = parse(body, checksum);
+  auto end = std::chrono::steady_clock::now();
+  if (count != static_cast<size_t>(events) || checksum == 0) {
+    std::fprintf(stderr, "decoded %zu events out of %d\n", count, events);
+    std::exit(1);
+  }
+  return static_cast<double>(count) /
+         std::chrono::duration<double>(end - begin).count();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int events = argc > 1 ? std::atoi(argv[1]) : 1000000;
+  if (events <= 0) {
+    std::fprintf(stderr, "usage: %s [events] [url]\n", argv[0]);
+    return 1;
+  }
+  std::unique_ptr<Testing::LoopbackServer> server;
+  std::string url;
+  if (argc > 2) {
+    url = argv[2];
+  } else {
+    server.reset(new Testing::LoopbackServer(
+        Testing::LoopbackServer::respond(eventResponse(events))));
+    url = server->url("/events");
+  }
+
+  MCurlHttpClient client;
+  client.start();
+  std::printf("%-8s %18s %18s\n", "round", "getline(events/s)",
+              "SSEReader(events/s)");
+  for (int round = 1; round <= 3; ++round) {
+    double baseline = run(client, url, events, splitLines);
+    double reader = run(client, url, events, decode);
+    std::printf("%-8d %18.0f %18.0f\n", round, baseline, reader);
+  }
+  client.stop();
+  return 0;
+}
@@ -0,0 +1,172 @@
+/**
+ * Submit latency of the perform loop queues under producer contention.
+ *
+ * Compares the SpinLock + std::list queue MCurlHttpClient used to have with
+ * Lock::MPSCQueue. Every producer pushes a pre-allocated element per
+ * operation, a single consumer drains the queue the way the perform thread
+ * does.
+ *
+ * Usage: bench_SubmitQueue [ops per producer]
+ */
+#include <darabonba/lock/MPSCQueue.hpp>
+#include <darabonba/lock/SpinLock.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace Darabonba;
+
+namespace {
+
+struct Item {
+  int value = 0;
+};
+
+using ItemPtr = std::unique_ptr<Item>;
+
+class ListQueue {
+public:
+  void push(ItemPtr item) {
+    std::lock_guard<Lock::SpinLock> guard(lock_);
+    queue_.emplace_back(std::move(item));
+    ++size_;
+  }
+
+  size_t drain() {
+    if (!size_)
+      return 0;
+    std::list<ItemPtr> queue;
+    {
+      std::lock_guard<Lock::SpinLock> guard(lock_);
+      queue = std::move(queue_);
+      size_ = 0;
+    }
+    return queue.size();
+  }
+
+private:
+  Lock::SpinLock lock_;
+  std::list<ItemPtr> queue_;
+  std::atomic<size_t> size_ = {0};
+};
+
+class RingQueue {
+public:
+  void push(ItemPtr item) { queue_.push(std::move(item)); }
+
+  size_t drain() {
+    size_t n = 0;
+    ItemPtr item;
+    while (queue_.pop(item)) {
+      ++n;
+    }
+    return n;
+  }
+
+private:
+  Lock::MPSCQueue<ItemPtr> queue_;
+};
+
+struct Result {
+  double mean;
+  double p50;
+  double p99;
+  double mops;
+};
+
+template <typename Queue> Result run(int producers, int opsPerProducer) {
+  Queue queue;
+  std::atomic<bool> go(false);
+  std::atomic<int> finished(0);
+  std::vector<std::vector<uint64_t>> latencies(producers);
+  std::vector<std::thread> threads;
+
+  for (int p = 0; p < producers; ++p) {
+    threads.emplace_back([&, p]() {
+      std::vector<ItemPtr> items;
+      items.reserve(opsPerProducer);
+      for (int i = 0; i < opsPerProducer; ++i) {
+        items.emplace_back(new Item());
+      }
+      auto &lat = latencies[p];
+      lat.reserve(opsPerProducer);
+      while (!go) {
+        std::this_thread::yield();
+      }
+      for (int i = 0; i < opsPerProducer; ++i) {
+        auto begin = std::chrono::steady_clock::now();
+        queue.push(std::move(items[i]));
+        auto end = std::chrono::steady_clock::now();
+        lat.push_back(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin)
+                .count()));
+      }
+      ++finished;
+    });
+  }
+
+  const size_t total = static_cast<size_t>(producers) * opsPerProducer;
+  size_t consumed = 0;
+  auto begin = std::chrono::steady_clock::now();
+  go = true;
+  while (consumed < total) {
+    size_t n = queue.drain();
+    consumed += n;
+    if (n == 0 && finished.load() == producers) {
+      // the last elements may become visible a little later
+      std::this_thread::yield();
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  std::vector<uint64_t> all;
+  all.reserve(total);
+  for (auto &lat : latencies) {
+    all.insert(all.end(), lat.begin(), lat.end());
+  }
+  std::sort(all.begin(), all.end());
+  double sum = 0;
+  for (auto v : all) {
+    sum += static_cast<double>(v);
+  }
+  double seconds = std::chrono::duration<double>(end - begin).count();
+  Result result;
+  result.mean = sum / static_cast<double>(all.size());
+  result.p50 = static_cast<double>(all[all.size() / 2]);
+  result.p99 = static_cast<double>(all[all.size() * 99 / 100]);
+  result.mops = static_cast<double>(total) / seconds / 1e6;
+  return result;
+}
+
+void print(const char *name, int producers, const Result &r) {
+  std::printf("%-14s %9d %10.1f %10.1f %10.1f %10.2f\n", name, producers,
+              r.mean, r.p50, r.p99, r.mops);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int ops = argc > 1 ? std::atoi(argv[1]) : 20000;
+  if (ops <= 0) {
+    std::fprintf(stderr, "usage: %s [ops per producer]\n", argv[0]);
+    return 1;
+  }
+  std::printf("%-14s %9s %10s %10s %10s %10s\n", "queue", "producers",
+              "mean(ns)", "p50(ns)", "p99(ns)", "Mops/s");
+  for (int producers = 1; producers <= 64; producers *= 2) {
+    print("spinlock+list", producers, run<ListQueue>(producers, ops));
+    print("mpsc", producers, run<RingQueue>(producers, ops));
+  }
+  return 0;
+}
@@ -0,0 +1,194 @@
+/**
+ * Throughput of a file upload through MCurlHttpClient.
+ *
+ * Compares the body of Stream::readFromFilePath, an ifstream read through
+ * curl's read callback in the chunks of its filebuf, with the MMapIStream of
+ * Stream::readFromFileMapped, which curl sends straight from the mapping.
+ * Both are sent with their Content-Length.
+ * The file is read from the page cache, so the client side cost dominates.
+ *
+ * Usage: bench_Upload [MB] [url]
+ *
+ * Without a url the file is POSTed to a local stand-in server started by the
+ * benchmark, which reads and discards the request bodies.
+ */
+#include <darabonba/Core.hpp>
+#include <darabonba/http/MCurlHttpClient.hpp>
+#include <darabonba/http/MCurlResponse.hpp>
+#include <darabonba/http/Request.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LoopbackServer.hpp"
+
+using namespace Darabonba;
+using namespace Darabonba::Http;
+
+namespace {
+
+// The script of the local server, reads and discards the request bodies
+struct Conn {
+  int fd;
+  std::vector<char> buf = std::vector<char>(256 * 1024);
+  size_t begin = 0;
+  size_t end = 0;
+
+  bool fill() {
+    if (begin == end) {
+      begin = end = 0;
+    }
+    auto n = recv(fd, buf.data() + end, buf.size() - end, 0);
+    if (n <= 0)
+      return false;
+    end += static_cast<size_t>(n);
+    return true;
+  }
+
+  bool line(std::string &out) {
+    for (;;) {
+      auto first = buf.data() + begin;
+      auto last = static_cast<char *>(memchr(first, '\n', end - begin));
+      if (last) {
+        out.assign(first, last);
+        if (!out.empty() && out.back() == '\r')
+          out.pop_back();
+        begin += static_cast<size_t>(last - first) + 1;
+        return true;
+      }
+      if (begin > 0) {
+        memmove(buf.data(), first, end - begin);
+        end -= begin;
+        begin = 0;
+      }
+      if (!fill())
+        return false;
+    }
+  }
+
+  bool skip(size_t size) {
+    while (size > 0) {
+      if (begin == end && !fill())
+        return false;
+      auto n = (std::min)(size, end - begin);
+      begin += n;
+      size -= n;
+    }
+    return true;
+  }
+};
+
+bool discardRequest(Conn &conn) {
+  std::string line;
+  if (!conn.line(line))
+    return false;
+  size_t length = 0;
+  bool chunked = false;
+  bool expect = false;
+  while (conn.line(line) && !line.empty()) {
+    for (auto &c : line) {
+      c = static_cast<char>(tolower(c));
+    }
+    if (line.compare(0, 15, "content-length:") == 0) {
+      length = std::strtoull(line.c_str() + 15, nullptr, 10);
+    } else if (line.find("transfer-encoding: chunked") == 0) {
+      chunked = true;
+    } else if (line.find("expect: 100-continue") == 0) {
+      expect = true;
+    }
+  }
+  if (expect) {
+    static const char cont[] = "HTTP/1.1 100 Continue\r\n\r\n";
+    send(conn.fd, cont, sizeof(cont) - 1, 0);
+  }
+  if (chunked) {
+    for (;;) {
+      if (!conn.line(line))
+        return false;
+      auto size = std::strtoull(line.c_str(), nullptr, 16);
+      if (size == 0) {
+        conn.line(line);
+        break;
+      }
+      if (!conn.skip(size + 2))
+        return false;
+    }
+  } else if (!conn.skip(length)) {
+    return false;
+  }
+  static const char ok[] = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+  return send(conn.fd, ok, sizeof(ok) - 1, 0) > 0;
+}
+
+void discard(int fd) {
+  Conn conn;
+  conn.fd = fd;
+  while (discardRequest(conn)) {
+  }
+}
+
+double upload(MCurlHttpClient &client, const std::string &url,
+              std::shared_ptr<IStream> body, size_t size) {
+  Request request(url);
+  request.setMethod("POST");
+  request.setBody(body);
+  auto begin = std::chrono::steady_clock::now();
+  auto response = client.makeRequest(request, RequestConfig()).get();
+  auto end = std::chrono::steady_clock::now();
+  if (!response || response->getStatusCode() != 200) {
+    std::fprintf(stderr, "upload failed\n");
+    std::exit(1);
+  }
+  return static_cast<double>(size) / (1024.0 * 1024.0) /
+         std::chrono::duration<double>(end - begin).count();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int mb = argc > 1 ? std::atoi(argv[1]) : 1024;
+  if (mb <= 0) {
+    std::fprintf(stderr, "usage: %s [MB] [url]\n", argv[0]);
+    return 1;
+  }
+  size_t size = static_cast<size_t>(mb) * 1024 * 1024;
+  std::string path = "bench_upload.bin";
+  {
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    std::vector<char> chunk(1024 * 1024);
+    for (size_t i = 0; i < chunk.size(); ++i) {
+      chunk[i] = static_cast<char>(i * 31);
+    }
+    for (int i = 0; i < mb; ++i) {
+      ofs.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+    }
+  }
+
+  std::unique_ptr<Testing::LoopbackServer> server;
+  std::string url;
+  if (argc > 2) {
+    url = argv[2];
+  } else {
+    server.reset(new Testing::LoopbackServer(discard));
+    url = server->url("/upload");
+  }
+
+  MCurlHttpClient client;
+  client.start();
+  std::printf("%-8s %14s %14s\n", "round", "ifstream(MB/s)", "mmap(MB/s)");
+  for (int round = 1; round <= 3; ++round) {
+    double stream = upload(client, url, Stream::readFromFilePath(path), size);
+    double mapped =
+        upload(client, url, Stream::readFromFileMapped(path), size);
+    std::printf("%-8d %14.0f %14.0f\n", round, stream, mapped);
+  }
+  client.stop();
+  std::remove(path.c_str());
+  return 0;
+}
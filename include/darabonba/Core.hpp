@@ -36,6 +36,15 @@ struct ConnectionPoolConfig {
   bool pipelining = false;           // Enable HTTP pipelining
   size_t max_host_connections = 128;   // Max connections per host (CURLMOPT_MAX_HOST_CONNECTIONS)
   bool keep_alive = true;            // Enable TCP keep-alive
+  size_t io_threads = 0;             // Number of perform loops, each with its own CURLM (0 = default: 1 for a client of its own, a few shared by the hosts of Core::doAction)
+  size_t easy_handle_pool_size = 16; // Idle easy handles kept by a client for reuse (0 disables recycling)
+  bool share_cache = false;          // Share DNS and TLS sessions across hosts (Http::CurlShare::shared())
+  bool http2 = false;                // Negotiate HTTP/2 via ALPN and multiplex requests over shared connections (CURLPIPE_MULTIPLEX, CURLOPT_PIPEWAIT)
+  bool http2_prior_knowledge = false; // Speak HTTP/2 without negotiation, also over plain http (h2c), implies http2
+  size_t max_concurrent_streams = 100; // Max streams per HTTP/2 connection (CURLMOPT_MAX_CONCURRENT_STREAMS, the largest of its hosts on a shared reactor)
+  bool event_driven = false;         // Drive the perform loops with curl_multi_socket_action on epoll, only active sockets are serviced (Linux, poll elsewhere)
+  size_t max_buffered_bytes = 0;     // Budget of the response data buffered by the bodies of a client, the largest holders are paused above it (0 = no limit)
+  bool share_buffer_budget = false;  // Account the bodies in the process-wide Http::BufferBudget::shared(), max_buffered_bytes then sets its limit
 
   // Compare operator for map keys
   bool operator<(const ConnectionPoolConfig& other) const {
@@ -44,6 +53,15 @@ struct ConnectionPoolConfig {
     if (connection_idle_timeout != other.connection_idle_timeout) return connection_idle_timeout < other.connection_idle_timeout;
     if (pipelining != other.pipelining) return pipelining < other.pipelining;
     if (keep_alive != other.keep_alive) return keep_alive < other.keep_alive;
+    if (io_threads != other.io_threads) return io_threads < other.io_threads;
+    if (easy_handle_pool_size != other.easy_handle_pool_size) return easy_handle_pool_size < other.easy_handle_pool_size;
+    if (share_cache != other.share_cache) return share_cache < other.share_cache;
+    if (http2 != other.http2) return http2 < other.http2;
+    if (http2_prior_knowledge != other.http2_prior_knowledge) return http2_prior_knowledge < other.http2_prior_knowledge;
+    if (max_concurrent_streams != other.max_concurrent_streams) return max_concurrent_streams < other.max_concurrent_streams;
+    if (event_driven != other.event_driven) return event_driven < other.event_driven;
+    if (max_buffered_bytes != other.max_buffered_bytes) return max_buffered_bytes < other.max_buffered_bytes;
+    if (share_buffer_budget != other.share_buffer_budget) return share_buffer_budget < other.share_buffer_budget;
     return max_host_connections < other.max_host_connections;
   }
 };
@@ -55,11 +73,14 @@ struct ConnectionPoolConfig {
 struct RequestConfig {
   int64_t connect_timeout_ms = 5000L;   // Per-request connection timeout
   int64_t read_timeout_ms = 10000L;         // Per-request read timeout
+  int64_t idle_timeout_ms = 0;       // Abort a transfer which receives nothing for this long (CURLOPT_LOW_SPEED_TIME, rounded up to seconds, 0 = none)
   bool ignore_ssl = false;           // Per-request SSL verification
   std::string http_proxy;            // Per-request proxy
   std::string https_proxy;           // Per-request HTTPS proxy
   std::string no_proxy;              // Per-request no-proxy list
   std::string credential;            // Per-request credentials
+  size_t buffer_high_watermark = 10 * 1024 * 1024; // Pause the transfer once the response body buffers this much
+  size_t buffer_low_watermark = 0;   // Resume it when the reader drains the body to this size (0 = half of the high watermark)
 };
 
 class Core {
@@ -74,7 +95,8 @@ public:
   
   /**
    * @brief Clear a specific connection pool configuration
-   * @param config The configuration to clear
+   * @param config The configuration to clear, its host, io_threads and
+   *        event_driven select the client
    */
   static void ClearHttpClient(const ConnectionPoolConfig &config);
   
@@ -32,6 +32,12 @@ public:
 
   static std::shared_ptr<IStream> readFromFilePath(const std::string &path);
 
+  /**
+   * @brief Read a file through a memory mapping, see MMapIStream.
+   * @note Prefer it to readFromFilePath for the uploads of large files.
+   */
+  static std::shared_ptr<IStream> readFromFileMapped(const std::string &path);
+
   static std::shared_ptr<IStream> readFromBytes(Bytes &raw);
 
   static std::shared_ptr<IStream> readFromString(const std::string &raw);
@@ -67,6 +73,43 @@ public:
   virtual size_t read(char *buffer, size_t expectSize) = 0;
   virtual bool isFinished() const = 0;
   virtual ~IStream() = default;
+
+  /**
+   * @brief Whether seek() is supported, the request body is then replayed by
+   * curl on a retry or a redirect instead of failing the transfer.
+   * @note curl replays a body from offset 0, so a request body should be
+   *       handed over unread.
+   */
+  virtual bool isSeekable() const { return false; }
+
+  /**
+   * @brief Move the next read to an offset from the start of the stream.
+   * @return false if the stream cannot seek or the offset is out of range.
+   */
+  virtual bool seek(uint64_t offset) {
+    (void)offset;
+    return false;
+  }
+
+  bool rewind() { return seek(0); }
+
+  /**
+   * @brief The size of the data left to read, which is the total size of an
+   * unread stream, -1 if unknown.
+   * @note A request body of a known size is sent with its Content-Length
+   *       instead of chunked encoding.
+   */
+  virtual int64_t remainingSize() const { return -1; }
+
+  /**
+   * @brief The data left to read when it is held in one block of memory,
+   * remainingSize() bytes long, nullptr otherwise.
+   * @note A request body held in memory is handed to curl as is, without
+   *       being copied through the read callback. The block stays valid until
+   *       the stream is modified or destroyed, and reading it does not move
+   *       the stream.
+   */
+  virtual const char *contiguousData() const { return nullptr; }
 };
 
 class ISStream : public IStream, protected std::istringstream {
@@ -99,13 +142,10 @@ public:
     return *this;
   }
 
-  ISStream(const ISStream &other)
-      : std::basic_ios<char>(nullptr), std::istringstream() {
-    std::ostringstream oss;
-    oss << other.rdbuf();
-    std::istringstream tempStream(oss.str());
-    std::istringstream::swap(tempStream);
-  }
+  /**
+   * @brief Copy the data left to read, the other stream is not moved.
+   */
+  ISStream(const ISStream &other);
 
   ISStream(ISStream &&other) noexcept { std::istringstream::swap(other); }
 
@@ -120,6 +160,14 @@ public:
   virtual size_t read(char *buffer, size_t expectSize) override;
 
   virtual bool isFinished() const override { return eof(); }
+
+  virtual bool isSeekable() const override { return true; }
+
+  virtual bool seek(uint64_t offset) override;
+
+  virtual int64_t remainingSize() const override;
+
+  virtual const char *contiguousData() const override;
 };
 
 class IFStream : public IStream, protected std::ifstream {
@@ -193,6 +241,12 @@ public:
 
   virtual bool isFinished() const override { return eof(); }
 
+  virtual bool isSeekable() const override { return isOpen(); }
+
+  virtual bool seek(uint64_t offset) override;
+
+  virtual int64_t remainingSize() const override;
+
   // Public wrapper for protected is_open()
   bool isOpen() const { return std::ifstream::is_open(); }
 
@@ -201,6 +255,128 @@ private:
   std::ios_base::openmode m_openmode;
 };
 
+/**
+ * @brief A read-only stream over a memory mapped file.
+ * @note read() copies straight from the mapping in chunks as large as the
+ *       caller asks for, without the per-call overhead of an ifstream, and
+ *       the kernel is told the file is read sequentially. An upload of the
+ *       stream is sent by curl straight from the mapping. The file must not
+ *       be truncated while it is mapped.
+ */
+class MMapIStream : public IStream {
+public:
+  explicit MMapIStream(const std::string &path);
+
+  virtual ~MMapIStream();
+
+  MMapIStream(const MMapIStream &) = delete;
+  MMapIStream &operator=(const MMapIStream &) = delete;
+
+  virtual size_t read(char *buffer, size_t expectSize) override;
+
+  virtual bool isFinished() const override { return position_ >= size_; }
+
+  virtual bool isSeekable() const override { return opened_; }
+
+  virtual bool seek(uint64_t offset) override;
+
+  virtual int64_t remainingSize() const override {
+    return opened_ ? static_cast<int64_t>(size_ - position_) : -1;
+  }
+
+  virtual const char *contiguousData() const override {
+    return data_ ? data_ + position_ : nullptr;
+  }
+
+  bool isOpen() const { return opened_; }
+
+  /**
+   * @brief The size of the file.
+   */
+  uint64_t size() const { return size_; }
+
+  /**
+   * @brief The mapped content, nullptr for an empty file.
+   */
+  const char *data() const { return data_; }
+
+  /**
+   * @brief The offset of the next read.
+   */
+  uint64_t position() const { return position_; }
+
+protected:
+  void unmap();
+
+  char *data_ = nullptr;
+  uint64_t size_ = 0;
+  uint64_t position_ = 0;
+  bool opened_ = false;
+#ifdef _WIN32
+  void *mapping_ = nullptr;
+#endif
+};
+
+/**
+ * @brief A stream reading a sequence of streams and memory blocks one after
+ * the other, to compose a request body of several parts without copying them
+ * into one string.
+ * @note The size is known when the sizes of all the parts are, and the stream
+ *       is seekable when all its parts are, so that curl can send it with a
+ *       Content-Length and replay it. The streams should be appended unread.
+ *       A memory block appended by pointer must outlive the stream.
+ */
+class ChainIStream : public IStream {
+public:
+  ChainIStream() = default;
+
+  virtual ~ChainIStream() = default;
+
+  ChainIStream(const ChainIStream &) = delete;
+  ChainIStream &operator=(const ChainIStream &) = delete;
+
+  ChainIStream &append(std::shared_ptr<IStream> stream);
+
+  /**
+   * @brief Append a memory block without copying it.
+   */
+  ChainIStream &append(const char *data, size_t size);
+
+  /**
+   * @brief Append a memory block owned by the stream.
+   */
+  ChainIStream &append(std::string data);
+
+  size_t partCount() const { return parts_.size(); }
+
+  virtual size_t read(char *buffer, size_t expectSize) override;
+
+  virtual bool isFinished() const override { return index_ >= parts_.size(); }
+
+  virtual bool isSeekable() const override;
+
+  virtual bool seek(uint64_t offset) override;
+
+  virtual int64_t remainingSize() const override;
+
+  virtual const char *contiguousData() const override;
+
+protected:
+  struct Part {
+    std::shared_ptr<IStream> stream;
+    std::shared_ptr<std::string> owned;
+    const char *data = nullptr;
+    // The size of a stream when it was appended, -1 if unknown
+    int64_t size = 0;
+  };
+
+  std::vector<Part> parts_;
+  // The part read now
+  size_t index_ = 0;
+  // The offset of the next read in the memory block of parts_[index_]
+  size_t offset_ = 0;
+};
+
 class OStream : public Stream {
 public:
   OStream() = default;
@@ -3,7 +3,9 @@
 #include <algorithm>
 #include <cstring>
 #include <darabonba/buffer/IOBuffer.hpp>
-#include <list>
+#include <darabonba/buffer/SegmentPool.hpp>
+#include <iterator>
+#include <vector>
 
 namespace Darabonba {
 namespace Buffer {
@@ -13,21 +15,26 @@ protected:
   enum { DEFAULT_SEGMENT_SIZE = 4 * 1024 };
   class Segment {
   public:
-    Segment(size_t capacity) : cap(capacity) { data = new char[capacity]; }
+    Segment(size_t capacity, SegmentPool *pool)
+        : cap(capacity), pool(pool) {
+      data = pool->acquire(capacity);
+    }
     Segment(const Segment &) = delete;
-    Segment(Segment &&obj) noexcept : data(obj.data), cap(obj.cap) {
+    Segment(Segment &&obj) noexcept
+        : data(obj.data), cap(obj.cap), pool(obj.pool) {
       obj.data = nullptr;
       obj.cap = 0;
     }
-    ~Segment() { delete[] data; }
+    ~Segment() { pool->release(data, cap); }
 
     Segment &operator=(const Segment &) = delete;
     Segment &operator=(Segment &&obj) {
       if (&obj == this)
         return *this;
-      delete[] data;
+      pool->release(data, cap);
       data = obj.data;
       cap = obj.cap;
+      pool = obj.pool;
       obj.data = nullptr;
       obj.cap = 0;
       return *this;
@@ -35,6 +42,8 @@ protected:
 
     size_t capacity() const { return cap; }
 
+    const char *begin() const { return data; }
+
     size_t read(char *buffer, size_t expectSize, size_t offset = 0) {
       if (data == nullptr)
         return 0;
@@ -54,60 +63,91 @@ protected:
   protected:
     char *data = nullptr;
     size_t cap = 0;
+    SegmentPool *pool = nullptr;
   };
 
 public:
-  RingBuffer(size_t segmentSize = DEFAULT_SEGMENT_SIZE)
-      : segmentSize_(segmentSize) {
-    writeIter_ = data_.begin();
+  /**
+   * @param pool The pool of the segments, SegmentPool::global() by default.
+   * @note The segments are kept in a contiguous array used as a ring, the
+   *       readable and writable sizes are maintained by read() and write(),
+   *       so no query walks the segments.
+   */
+  RingBuffer(size_t segmentSize = DEFAULT_SEGMENT_SIZE,
+             SegmentPool *pool = nullptr)
+      : segmentSize_(segmentSize),
+        pool_(pool ? pool : &SegmentPool::global()) {
     addSegment(1);
   }
   RingBuffer(const RingBuffer &) = delete;
   RingBuffer(RingBuffer &&obj)
-      : data_(std::move(obj.data_)), writeIter_(obj.writeIter_),
-        nRead_(obj.nRead_), nWrite_(obj.nWrite_) {
-    obj.nRead_ = obj.nWrite_ = 0;
-    obj.writeIter_ = obj.data_.begin();
+      : segmentSize_(obj.segmentSize_), pool_(obj.pool_),
+        data_(std::move(obj.data_)), readSeg_(obj.readSeg_),
+        writeSeg_(obj.writeSeg_), nRead_(obj.nRead_), nWrite_(obj.nWrite_),
+        readable_(obj.readable_), writable_(obj.writable_) {
+    obj.reset();
   }
   virtual ~RingBuffer() = default;
 
   RingBuffer &operator=(const RingBuffer &) = delete;
   RingBuffer &operator=(RingBuffer &&obj) {
+    if (&obj == this)
+      return *this;
+    segmentSize_ = obj.segmentSize_;
+    pool_ = obj.pool_;
     data_ = std::move(obj.data_);
-    writeIter_ = obj.writeIter_;
+    readSeg_ = obj.readSeg_;
+    writeSeg_ = obj.writeSeg_;
     nRead_ = obj.nRead_;
     nWrite_ = obj.nWrite_;
-    obj.nRead_ = obj.nWrite_ = 0;
-    obj.writeIter_ = obj.data_.begin();
+    readable_ = obj.readable_;
+    writable_ = obj.writable_;
+    obj.reset();
     return *this;
   }
 
-  virtual size_t readableSize() const override {
-    if (data_.empty())
-      return 0;
-    return segmentSize_ * std::distance(data_.cbegin(),
-                                        decltype(data_.cbegin())(writeIter_)) +
-           nWrite_ - nRead_;
+  virtual size_t readableSize() const override { return readable_; }
+
+  virtual size_t writableSize() const override { return writable_; }
+
+  virtual size_t read(char *buffer, size_t expectSize) override {
+    auto realSize = (std::min)(expectSize, readable_);
+    for (auto remain = realSize; remain > 0;) {
+      auto cnt = data_[readSeg_].read(buffer, remain, nRead_);
+      buffer += cnt;
+      remain -= cnt;
+      advanceReader(cnt);
+    }
+    return realSize;
   }
 
-  virtual size_t writableSize() const override {
-    if (data_.empty())
+  /**
+   * @brief Borrow the readable data at the front of the buffer.
+   * @param data Set to the first readable byte.
+   * @return The size of the contiguous data at data, it may be less than
+   * readableSize() when the data continues in the next segment.
+   * @note The data stays valid until it is consumed.
+   */
+  size_t peek(const char **data) const {
+    if (readable_ == 0) {
+      *data = nullptr;
       return 0;
-    return std::distance(std::next(decltype(data_.begin())(writeIter_)),
-                         data_.cend()) *
-               segmentSize_ +
-           (segmentSize_ - nWrite_);
+    }
+    const auto &seg = data_[readSeg_];
+    *data = seg.begin() + nRead_;
+    return (std::min)(readable_, seg.capacity() - nRead_);
   }
 
-  virtual size_t read(char *buffer, size_t expectSize) override {
-    auto realSize = (std::min)(expectSize, readableSize());
+  /**
+   * @brief Drop data from the front of the buffer without copying it.
+   * @return The size of data dropped.
+   */
+  size_t consume(size_t expectSize) {
+    auto realSize = (std::min)(expectSize, readable_);
     for (auto remain = realSize; remain > 0;) {
-      auto cnt = data_.front().read(buffer, remain, nRead_);
-      buffer += cnt;
+      auto cnt = (std::min)(remain, segmentSize_ - nRead_);
       remain -= cnt;
-      nRead_ += cnt;
-      if (nRead_ == data_.front().capacity())
-        forwardReader();
+      advanceReader(cnt);
     }
     return realSize;
   }
@@ -115,57 +155,114 @@ public:
   virtual size_t write(char *buffer, size_t expectSize) override {
     ensureWritable(expectSize);
     for (auto remain = expectSize; remain > 0;) {
-      auto cnt = writeIter_->write(buffer, remain, nWrite_);
+      auto cnt = data_[writeSeg_].write(buffer, remain, nWrite_);
       buffer += cnt;
       remain -= cnt;
       nWrite_ += cnt;
-      if (nWrite_ == writeIter_->capacity())
+      readable_ += cnt;
+      writable_ -= cnt;
+      if (nWrite_ == segmentSize_)
         forwardWriter();
     }
     return expectSize;
   }
 
+  size_t segmentSize() const { return segmentSize_; }
+
+  /**
+   * @brief Change the size of the segments, e.g. once the size of the data
+   * is known.
+   * @return false if the buffer holds data.
+   */
+  bool setSegmentSize(size_t segmentSize) {
+    if (segmentSize == 0 || readable_ != 0)
+      return false;
+    if (segmentSize == segmentSize_)
+      return true;
+    data_.clear();
+    reset();
+    segmentSize_ = segmentSize;
+    addSegment(1);
+    return true;
+  }
+
   void ensureWritable(size_t size) {
-    auto remain = writableSize();
     // Make sure there is always space left
-    if (remain > size)
+    if (writable_ > size)
       return;
-    size_t cnt = (size - remain) / segmentSize_ + 1;
+    size_t cnt = (size - writable_) / segmentSize_ + 1;
     addSegment(cnt);
   }
 
 protected:
-  void forwardReader() {
-    auto seg = std::move(data_.front());
-    data_.pop_front();
-    data_.emplace_back(std::move(seg));
-    nRead_ = 0;
+  void reset() {
+    readSeg_ = writeSeg_ = 0;
+    nRead_ = nWrite_ = 0;
+    readable_ = writable_ = 0;
+  }
+
+  size_t next(size_t index) const {
+    return index + 1 == data_.size() ? 0 : index + 1;
+  }
+
+  void advanceReader(size_t cnt) {
+    nRead_ += cnt;
+    readable_ -= cnt;
+    if (readable_ == 0 && readSeg_ == writeSeg_) {
+      // empty, write from the start of the segment again
+      writable_ += nWrite_;
+      nRead_ = nWrite_ = 0;
+    } else if (nRead_ == segmentSize_) {
+      // the drained segment becomes writable
+      readSeg_ = next(readSeg_);
+      nRead_ = 0;
+      writable_ += segmentSize_;
+    }
   }
 
   void forwardWriter() {
-    if (nWrite_ == 0)
-      return;
-    ++writeIter_;
-    if (writeIter_ == data_.end())
+    if (next(writeSeg_) == readSeg_)
       addSegment(1);
+    writeSeg_ = next(writeSeg_);
     nWrite_ = 0;
   }
 
-  bool addSegment(size_t n) {
-    bool isEnd = writeIter_ == data_.end();
-    if (isEnd)
-      writeIter_ = data_.emplace(writeIter_, Segment(segmentSize_));
-    for (size_t i = isEnd ? 1 : 0; i < n; ++i)
-      data_.emplace_back(Segment(segmentSize_));
-    return true;
+  /**
+   * @brief Insert empty segments right after the segment being written.
+   */
+  void addSegment(size_t n) {
+    if (data_.empty()) {
+      data_.reserve(n);
+      for (size_t i = 0; i < n; ++i)
+        data_.emplace_back(segmentSize_, pool_);
+      writable_ = n * segmentSize_;
+      return;
+    }
+    std::vector<Segment> added;
+    added.reserve(n);
+    for (size_t i = 0; i < n; ++i)
+      added.emplace_back(segmentSize_, pool_);
+    auto pos = writeSeg_ + 1;
+    data_.insert(data_.begin() + static_cast<std::ptrdiff_t>(pos),
+                 std::make_move_iterator(added.begin()),
+                 std::make_move_iterator(added.end()));
+    if (readSeg_ >= pos)
+      readSeg_ += n;
+    writable_ += n * segmentSize_;
   }
 
   size_t segmentSize_ = DEFAULT_SEGMENT_SIZE;
-  std::list<Segment> data_;
+  SegmentPool *pool_ = nullptr;
+  std::vector<Segment> data_;
 
-  decltype(data_)::iterator writeIter_;
+  // The segments from readSeg_ to writeSeg_ hold the data, the others are
+  // free
+  size_t readSeg_ = 0;
+  size_t writeSeg_ = 0;
   size_t nRead_ = 0;
   size_t nWrite_ = 0;
+  size_t readable_ = 0;
+  size_t writable_ = 0;
 };
 
 } // namespace Buffer
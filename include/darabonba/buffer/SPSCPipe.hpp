@@ -0,0 +1,204 @@
+#ifndef DARBONBACORE_SPSCPIPE_H_
+#define DARBONBACORE_SPSCPIPE_H_
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <darabonba/buffer/SegmentPool.hpp>
+#include <new>
+
+namespace Darabonba {
+namespace Buffer {
+
+/**
+ * @brief An unbounded single-producer/single-consumer byte pipe.
+ * @note write() and setSegmentSize() may only be called by the producer,
+ *       read(), peek() and consume() only by the consumer; they never wait
+ *       for each other. The data is kept in a linked list of segments taken
+ *       from a SegmentPool, the producer publishes what it wrote with a
+ *       release store and the consumer gives the drained segments back to
+ *       the pool.
+ */
+class SPSCPipe {
+public:
+  enum { DEFAULT_SEGMENT_SIZE = 4 * 1024 };
+
+  /**
+   * @param pool The pool of the segments, SegmentPool::global() by default.
+   */
+  explicit SPSCPipe(size_t segmentSize = DEFAULT_SEGMENT_SIZE,
+                    SegmentPool *pool = nullptr)
+      : segmentSize_(segmentSize),
+        pool_(pool ? pool : &SegmentPool::global()) {}
+
+  ~SPSCPipe() {
+    auto block = head_ ? head_ : first_.load(std::memory_order_acquire);
+    while (block) {
+      auto next = block->next.load(std::memory_order_acquire);
+      freeBlock(block);
+      block = next;
+    }
+  }
+
+  SPSCPipe(const SPSCPipe &) = delete;
+  SPSCPipe &operator=(const SPSCPipe &) = delete;
+
+  /**
+   * @brief The size of the data written but not consumed yet, may be called
+   * from any thread.
+   */
+  size_t readableSize() const {
+    // seq_cst, see write(). read_ is loaded first, the data it counts was
+    // already counted in written_
+    auto read = read_.load();
+    return written_.load() - read;
+  }
+
+  /**
+   * @brief Change the size of the segments before the first write.
+   * @return false if data has already been written.
+   */
+  bool setSegmentSize(size_t segmentSize) {
+    if (tail_ != nullptr || segmentSize <= sizeof(Block))
+      return false;
+    segmentSize_ = segmentSize;
+    return true;
+  }
+
+  size_t segmentSize() const { return segmentSize_; }
+
+  size_t write(const char *buffer, size_t expectSize) {
+    if (expectSize == 0)
+      return 0;
+    for (auto remain = expectSize; remain > 0;) {
+      if (tail_ == nullptr) {
+        tail_ = newBlock();
+        first_.store(tail_, std::memory_order_release);
+      }
+      auto pos = tail_->written.load(std::memory_order_relaxed);
+      if (pos == tail_->capacity) {
+        auto block = newBlock();
+        tail_->next.store(block, std::memory_order_release);
+        tail_ = block;
+        pos = 0;
+      }
+      auto cnt = (std::min)(remain, tail_->capacity - pos);
+      memcpy(tail_->data() + pos, buffer, cnt);
+      // counted before it is published, the consumer can't read_ more than
+      // written_ and readableSize() never goes below 0. seq_cst, a consumer
+      // about to park either sees the data or is seen waiting by the producer
+      written_.fetch_add(cnt);
+      tail_->written.store(pos + cnt, std::memory_order_release);
+      buffer += cnt;
+      remain -= cnt;
+    }
+    return expectSize;
+  }
+
+  /**
+   * @brief Borrow the next contiguous readable data.
+   * @return The size of the data at data, 0 if the pipe is empty.
+   * @note The data stays valid until it is consumed.
+   */
+  size_t peek(const char **data) {
+    *data = nullptr;
+    if (head_ == nullptr) {
+      head_ = first_.load(std::memory_order_acquire);
+      if (head_ == nullptr)
+        return 0;
+    }
+    for (;;) {
+      auto written = head_->written.load(std::memory_order_acquire);
+      if (readPos_ < written) {
+        *data = head_->data() + readPos_;
+        return written - readPos_;
+      }
+      if (readPos_ < head_->capacity)
+        return 0;
+      auto next = head_->next.load(std::memory_order_acquire);
+      if (next == nullptr)
+        return 0;
+      freeBlock(head_);
+      head_ = next;
+      readPos_ = 0;
+    }
+  }
+
+  /**
+   * @brief Drop data from the front of the pipe without copying it.
+   * @return The size of data dropped.
+   */
+  size_t consume(size_t expectSize) {
+    size_t done = 0;
+    const char *data = nullptr;
+    while (done < expectSize) {
+      auto size = peek(&data);
+      if (size == 0)
+        break;
+      auto cnt = (std::min)(size, expectSize - done);
+      readPos_ += cnt;
+      done += cnt;
+    }
+    read_.fetch_add(done, std::memory_order_release);
+    return done;
+  }
+
+  size_t read(char *buffer, size_t expectSize) {
+    size_t done = 0;
+    const char *data = nullptr;
+    while (done < expectSize) {
+      auto size = peek(&data);
+      if (size == 0)
+        break;
+      auto cnt = (std::min)(size, expectSize - done);
+      memcpy(buffer + done, data, cnt);
+      readPos_ += cnt;
+      done += cnt;
+    }
+    read_.fetch_add(done, std::memory_order_release);
+    return done;
+  }
+
+protected:
+  static constexpr size_t kCacheLine = 64;
+
+  // The header of a segment, placed at the start of its memory
+  struct Block {
+    explicit Block(size_t size) : size(size), capacity(size - sizeof(Block)) {}
+
+    char *data() { return reinterpret_cast<char *>(this + 1); }
+
+    std::atomic<size_t> written = {0};
+    std::atomic<Block *> next = {nullptr};
+    const size_t size;
+    const size_t capacity;
+  };
+
+  Block *newBlock() {
+    auto memory = pool_->acquire(segmentSize_);
+    return new (memory) Block(segmentSize_);
+  }
+
+  void freeBlock(Block *block) {
+    auto size = block->size;
+    block->~Block();
+    pool_->release(reinterpret_cast<char *>(block), size);
+  }
+
+  size_t segmentSize_;
+  SegmentPool *pool_;
+  std::atomic<Block *> first_ = {nullptr};
+
+  // keep the producer and consumer positions on separate cache lines
+  char firstPad_[kCacheLine];
+  Block *tail_ = nullptr;
+  std::atomic<size_t> written_ = {0};
+  char tailPad_[kCacheLine - sizeof(Block *) - sizeof(std::atomic<size_t>)];
+  Block *head_ = nullptr;
+  size_t readPos_ = 0;
+  std::atomic<size_t> read_ = {0};
+};
+
+} // namespace Buffer
+} // namespace Darabonba
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef DARBONBACORE_SEGMENTPOOL_H_
+#define DARBONBACORE_SEGMENTPOOL_H_
+#include <atomic>
+#include <cstddef>
+#include <darabonba/lock/SpinLock.hpp>
+#include <vector>
+
+namespace Darabonba {
+namespace Buffer {
+
+/**
+ * @brief A pool of the fixed-size memory blocks used as RingBuffer segments.
+ * @note The sizes are powers of two from MIN_SEGMENT_SIZE to
+ *       MAX_SEGMENT_SIZE, each size has its own free list. Blocks of other
+ *       sizes are allocated and freed directly. Released blocks are kept
+ *       until the idle bytes reach the limit of the pool.
+ *       All the methods are thread safe, a block may be released by another
+ *       thread than the one which acquired it.
+ */
+class SegmentPool {
+public:
+  enum {
+    MIN_SEGMENT_SIZE = 4 * 1024,
+    MAX_SEGMENT_SIZE = 64 * 1024,
+    DEFAULT_MAX_IDLE_BYTES = 32 * 1024 * 1024
+  };
+
+  struct Metrics {
+    // Blocks allocated from the heap
+    size_t allocations = 0;
+    // Blocks handed out from a free list
+    size_t reuses = 0;
+    // Blocks freed because the pool was full
+    size_t frees = 0;
+    // Blocks currently kept in the free lists
+    size_t idleCount = 0;
+    size_t idleBytes = 0;
+  };
+
+  explicit SegmentPool(size_t maxIdleBytes = DEFAULT_MAX_IDLE_BYTES)
+      : maxIdleBytes_(maxIdleBytes) {}
+
+  ~SegmentPool() { trim(); }
+
+  SegmentPool(const SegmentPool &) = delete;
+  SegmentPool &operator=(const SegmentPool &) = delete;
+
+  /**
+   * @brief The pool used by the RingBuffers which are not given one.
+   */
+  static SegmentPool &global();
+
+  /**
+   * @brief The segment size for a body of the expected size, about 1/16 of
+   * it, rounded up to a pooled size.
+   */
+  static size_t segmentSizeFor(size_t expectedSize);
+
+  char *acquire(size_t size);
+
+  /**
+   * @param size The size given to acquire().
+   */
+  void release(char *data, size_t size);
+
+  /**
+   * @brief Free all the idle blocks.
+   */
+  void trim();
+
+  Metrics getMetrics() const;
+
+protected:
+  enum { CLASS_COUNT = 5 };
+
+  /**
+   * @return The index of the free list of the size, -1 if it is not pooled.
+   */
+  static int classOf(size_t size);
+
+  struct FreeList {
+    Lock::SpinLock lock;
+    std::vector<char *> blocks;
+  };
+
+  FreeList lists_[CLASS_COUNT];
+
+  const size_t maxIdleBytes_;
+
+  std::atomic<size_t> idleBytes_ = {0};
+  std::atomic<size_t> idleCount_ = {0};
+  std::atomic<size_t> allocations_ = {0};
+  std::atomic<size_t> reuses_ = {0};
+  std::atomic<size_t> frees_ = {0};
+};
+
+} // namespace Buffer
+} // namespace Darabonba
+
+#endif
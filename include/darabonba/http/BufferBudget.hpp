@@ -0,0 +1,107 @@
+#ifndef DARABONBA_HTTP_BUFFER_BUDGET_H_
+#define DARABONBA_HTTP_BUFFER_BUDGET_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <darabonba/lock/SpinLock.hpp>
+#include <memory>
+#include <vector>
+
+namespace Darabonba {
+namespace Http {
+
+class MCurlResponseBody;
+
+/**
+ * @brief The memory budget of the response data buffered and not read yet,
+ * shared by the bodies of one client or of many.
+ * @note Once the limit is reached the transfers whose bodies hold at least
+ *       the average share are paused, so the slowest readers are throttled
+ *       first while the others keep going. Past a quarter above the limit
+ *       every body holding data is paused. The paused transfers are resumed
+ *       when the readers have drained the budget to 3/4 of the limit, or
+ *       their own body to its low watermark. A body without data is never
+ *       paused. All the methods are thread safe.
+ */
+class BufferBudget {
+  friend class MCurlResponseBody;
+  friend class MCurlHttpClient;
+
+public:
+  struct Metrics {
+    // Bytes buffered by the bodies now
+    size_t current = 0;
+    // The highest value of current since the last resetPeak()
+    size_t peak = 0;
+    // 0 for no limit
+    size_t limit = 0;
+    // Bodies holding data
+    size_t holders = 0;
+    // Transfers paused because the budget was exceeded
+    uint64_t pauses = 0;
+  };
+
+  /**
+   * @param limit 0 for no limit, the data is only accounted.
+   */
+  explicit BufferBudget(size_t limit = 0) : limit_(limit) {}
+
+  BufferBudget(const BufferBudget &) = delete;
+  BufferBudget &operator=(const BufferBudget &) = delete;
+
+  /**
+   * @brief The budget of the clients of Core::doAction when
+   * ConnectionPoolConfig::share_buffer_budget is enabled.
+   */
+  static std::shared_ptr<BufferBudget> shared();
+
+  void setLimit(size_t limit);
+
+  size_t getLimit() const { return limit_; }
+
+  size_t getCurrent() const { return current_; }
+
+  size_t getPeak() const { return peak_; }
+
+  void resetPeak() { peak_ = current_.load(); }
+
+  bool exceeded() const {
+    auto limit = limit_.load();
+    return limit > 0 && current_ >= limit;
+  }
+
+  Metrics getMetrics() const;
+
+protected:
+  void add(size_t size);
+
+  void sub(size_t size);
+
+  /**
+   * @brief Whether a body holding held bytes should be paused.
+   */
+  bool shouldPause(size_t held) const;
+
+  /**
+   * @brief Keep a paused body to resume it once the budget is drained.
+   */
+  void park(const std::shared_ptr<MCurlResponseBody> &body);
+
+  void resumeParked();
+
+  std::atomic<size_t> limit_;
+  std::atomic<size_t> current_ = {0};
+  std::atomic<size_t> peak_ = {0};
+  std::atomic<size_t> holders_ = {0};
+  std::atomic<uint64_t> pauses_ = {0};
+
+  Lock::SpinLock parkedLock_;
+  std::vector<std::weak_ptr<MCurlResponseBody>> parked_;
+  std::atomic<size_t> parkedSize_ = {0};
+};
+
+} // namespace Http
+} // namespace Darabonba
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef DARABONBA_HTTP_CLIENT_REGISTRY_H_
+#define DARABONBA_HTTP_CLIENT_REGISTRY_H_
+
+#include <darabonba/Core.hpp>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Darabonba {
+namespace Http {
+
+class MCurlHttpClient;
+
+/**
+ * @brief A read-mostly map from host to MCurlHttpClient.
+ * @note The hosts are spread over shards, each shard publishes an immutable
+ *       snapshot of its map. A lookup only registers itself as a reader of
+ *       the current epoch and loads the snapshot: it takes no lock,
+ *       allocates nothing and does not touch the client when the
+ *       ConnectionPoolConfig is unchanged. A writer copies the map of one
+ *       shard under its mutex, publishes it, and frees the old snapshot once
+ *       the readers of the previous epoch are gone.
+ */
+class ClientRegistry {
+public:
+  using ClientPtr = std::shared_ptr<MCurlHttpClient>;
+
+  // Create the client of a host, it is configured before being published,
+  // config.host is set
+  using CreateFunc = std::function<ClientPtr(const ConnectionPoolConfig &)>;
+
+  // Apply a new or changed config to the client, config.host is set
+  using ConfigureFunc =
+      std::function<void(MCurlHttpClient &, const ConnectionPoolConfig &)>;
+
+  ClientRegistry(CreateFunc create, ConfigureFunc configure)
+      : create_(std::move(create)), configure_(std::move(configure)) {}
+
+  ClientRegistry(const ClientRegistry &) = delete;
+  ClientRegistry &operator=(const ClientRegistry &) = delete;
+
+  /**
+   * @brief Get the client of the host, create it on first use.
+   * @param config The pool config of the request, its host is ignored.
+   */
+  ClientPtr get(const std::string &host, const ConnectionPoolConfig &config);
+
+  bool erase(const std::string &host);
+
+  void clear();
+
+  size_t size() const;
+
+protected:
+  enum { SHARD_COUNT = 16 };
+
+  struct Entry {
+    ClientPtr client;
+    // the config last applied, without host
+    ConnectionPoolConfig config;
+  };
+
+  using Map = std::unordered_map<std::string, Entry>;
+
+  struct Shard {
+    Shard() : map(new Map()) {
+      readers[0] = 0;
+      readers[1] = 0;
+    }
+    ~Shard() { delete map.load(); }
+
+    // serializes the writers
+    std::mutex mutex;
+    std::atomic<const Map *> map;
+    std::atomic<unsigned> epoch = {0};
+    // readers of the even and odd epochs
+    std::atomic<size_t> readers[2];
+  };
+
+  /**
+   * @brief Keeps the snapshot of a shard alive while it is read.
+   */
+  class ReadGuard {
+  public:
+    explicit ReadGuard(Shard &shard);
+    ~ReadGuard() { shard_.readers[index_].fetch_sub(1); }
+
+    ReadGuard(const ReadGuard &) = delete;
+    ReadGuard &operator=(const ReadGuard &) = delete;
+
+    const Map &map() const { return *shard_.map.load(); }
+
+  private:
+    Shard &shard_;
+    unsigned index_ = 0;
+  };
+
+  Shard &shardOf(const std::string &host) {
+    return shards_[std::hash<std::string>()(host) % SHARD_COUNT];
+  }
+
+  /**
+   * @brief Publish a new map of the shard, must be called under its mutex.
+   * @return the old map, no reader refers to it any more
+   */
+  static std::unique_ptr<const Map> publish(Shard &shard,
+                                            std::unique_ptr<Map> map);
+
+  static bool sameConfig(const ConnectionPoolConfig &a,
+                         const ConnectionPoolConfig &b) {
+    return !(a < b) && !(b < a);
+  }
+
+  CreateFunc create_;
+
+  ConfigureFunc configure_;
+
+  mutable Shard shards_[SHARD_COUNT];
+};
+
+} // namespace Http
+} // namespace Darabonba
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef DARABONBA_HTTP_COROUTINE_H_
+#define DARABONBA_HTTP_COROUTINE_H_
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+#define DARABONBA_HAS_COROUTINES 1
+#endif
+
+#ifdef DARABONBA_HAS_COROUTINES
+
+#include <coroutine>
+#include <darabonba/http/MCurlHttpClient.hpp>
+#include <darabonba/http/MCurlResponse.hpp>
+#include <darabonba/http/Request.hpp>
+#include <exception>
+#include <memory>
+
+namespace Darabonba {
+namespace Http {
+
+/**
+ * @brief Awaits the response of a request without blocking a thread.
+ * @note The coroutine is resumed on a perform thread of the client, or by
+ *       the executor given, and then runs among the transfers of the loop:
+ *       it must not block until it awaits again. A network error is thrown
+ *       from co_await as a ResponseException.
+ */
+class RequestAwaitable {
+public:
+  RequestAwaitable(MCurlHttpClient &client, const Request &request,
+                   const RequestConfig &config,
+                   MCurlHttpClient::Executor executor)
+      : client_(client), request_(request), config_(config),
+        executor_(std::move(executor)) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    auto executor = std::move(executor_);
+    if (!executor) {
+      auto &client = client_;
+      executor = [&client](std::function<void()> task) {
+        // a stopped client completes at once, resumed by the caller
+        if (!client.post(task))
+          task();
+      };
+    }
+    // the coroutine may be resumed, and this awaitable destroyed, before
+    // makeRequest returns
+    client_.makeRequest(
+        request_, config_,
+        [this, handle](std::shared_ptr<MCurlResponse> response,
+                       std::exception_ptr error) {
+          response_ = std::move(response);
+          error_ = error;
+          handle.resume();
+        },
+        std::move(executor));
+  }
+
+  std::shared_ptr<MCurlResponse> await_resume() {
+    if (error_)
+      std::rethrow_exception(error_);
+    return std::move(response_);
+  }
+
+private:
+  MCurlHttpClient &client_;
+  Request request_;
+  RequestConfig config_;
+  MCurlHttpClient::Executor executor_;
+  std::shared_ptr<MCurlResponse> response_;
+  std::exception_ptr error_;
+};
+
+/**
+ * @brief Awaits the next data of a response body, the counterpart of
+ * MCurlResponseBody::read() which suspends instead of parking the thread.
+ * @note The coroutine is resumed on the perform thread of the transfer. The
+ *       result is 0 once the body has been fully read.
+ */
+class ReadAwaitable {
+public:
+  ReadAwaitable(MCurlResponseBody &body, char *buffer, size_t size)
+      : body_(body), buffer_(buffer), size_(size) {}
+
+  bool await_ready() const { return size_ == 0 || body_.isReadable(); }
+
+  bool await_suspend(std::coroutine_handle<> handle) {
+    // false if the data came meanwhile, the coroutine goes on at once
+    return body_.notifyWhenReadable([handle]() { handle.resume(); });
+  }
+
+  size_t await_resume() { return size_ == 0 ? 0 : body_.read(buffer_, size_); }
+
+private:
+  MCurlResponseBody &body_;
+  char *buffer_;
+  size_t size_;
+};
+
+/**
+ * @brief co_await asyncRequest(client, request) resolves to the response.
+ * @param executor Resumes the coroutine, nullptr for a perform thread.
+ */
+inline RequestAwaitable
+asyncRequest(MCurlHttpClient &client, const Request &request,
+             const RequestConfig &config = RequestConfig(),
+             MCurlHttpClient::Executor executor = nullptr) {
+  return RequestAwaitable(client, request, config, std::move(executor));
+}
+
+/**
+ * @brief co_await asyncReadSome(body, buffer, size) resolves to the size
+ * read, at most size.
+ */
+inline ReadAwaitable asyncReadSome(MCurlResponseBody &body, char *buffer,
+                                   size_t size) {
+  return ReadAwaitable(body, buffer, size);
+}
+
+} // namespace Http
+} // namespace Darabonba
+
+#endif
+
+#endif
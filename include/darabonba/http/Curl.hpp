@@ -12,6 +12,12 @@ namespace Http {
 
 namespace Curl {
 
+/**
+ * @brief The size of the reads of curl from a large request body of a known
+ * size, CURLOPT_UPLOAD_BUFFERSIZE is 64 KB by default.
+ */
+enum { UPLOAD_BUFFER_SIZE = 256 * 1024 };
+
 /**
  * @note The header callback will be called once for each header and only
  * complete header lines are passed on to the callback. Do not assume that the
@@ -22,6 +28,12 @@ size_t writeHeader(char *buffer, size_t size, size_t nitems, void *userdata);
 
 size_t readIStream(char *buffer, size_t size, size_t nitems, void *userdata);
 
+/**
+ * @brief The CURLOPT_SEEKFUNCTION of a seekable request body, called by curl
+ * to replay the body on a retry, a redirect or an authentication round.
+ */
+int seekIStream(void *userdata, curl_off_t offset, int origin);
+
 size_t readFileFiled(char *buffer, size_t size, size_t nitems, void *userdata);
 
 void closeIStream(void *userdata);
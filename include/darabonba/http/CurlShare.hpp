@@ -0,0 +1,65 @@
+#ifndef DARABONBA_HTTP_CURL_SHARE_H_
+#define DARABONBA_HTTP_CURL_SHARE_H_
+
+#include <curl/curl.h>
+#include <memory>
+#include <mutex>
+
+namespace Darabonba {
+namespace Http {
+
+/**
+ * @brief A CURLSH shared by the easy handles of many clients, so that DNS
+ * results and TLS sessions are reused across hosts and perform loops.
+ * @note The easy handles attached to the share may run on different perform
+ *       threads, every kind of shared data is guarded by its own mutex.
+ *       Connections are not shared: a connection cache shared by several
+ *       multi handles would let one perform loop use a connection another
+ *       loop is driving, each loop keeps its own pool instead.
+ *       The share must outlive the easy handles attached to it, so clients
+ *       keep a reference while they own handles.
+ */
+class CurlShare {
+public:
+  enum Data {
+    DNS = 1 << 0,
+    SSL_SESSION = 1 << 1,
+    ALL = DNS | SSL_SESSION
+  };
+
+  explicit CurlShare(int data = ALL);
+  ~CurlShare();
+
+  CurlShare(const CurlShare &) = delete;
+  CurlShare &operator=(const CurlShare &) = delete;
+
+  /**
+   * @brief The share attached to the clients of Core::doAction when
+   * ConnectionPoolConfig::share_cache is enabled.
+   */
+  static std::shared_ptr<CurlShare> shared();
+
+  CURLSH *handle() const { return share_; }
+
+  /**
+   * @brief Whether the kind of data is actually shared.
+   */
+  bool shares(Data data) const { return (data_ & data) != 0; }
+
+protected:
+  static void lock(CURL *handle, curl_lock_data data, curl_lock_access access,
+                   void *userptr);
+
+  static void unlock(CURL *handle, curl_lock_data data, void *userptr);
+
+  CURLSH *share_ = nullptr;
+
+  int data_ = 0;
+
+  std::mutex mutexes_[CURL_LOCK_DATA_LAST];
+};
+
+} // namespace Http
+} // namespace Darabonba
+
+#endif
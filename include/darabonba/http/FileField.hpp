@@ -3,6 +3,7 @@
 
 #include <algorithm>
 #include <cstring>
+#include <map>
 #include <darabonba/Core.hpp>
 #include <darabonba/Model.hpp>
 #include <darabonba/Stream.hpp>
@@ -91,13 +92,18 @@ protected:
 
 class FileFormStream : public IStream {
 public:
-  FileFormStream() = default;
+  FileFormStream() { build(); }
   FileFormStream(const Json obj) : form_(obj) {
     if (form_.is_object()) {
       for (auto it = form_.begin(); it != form_.end(); ++it) {
         keys_.push_back(it.key());
+        if (isFileFiled(it.value())) {
+          contents_[it.key()] =
+              it.value()["content"].get<std::shared_ptr<IStream>>();
+        }
       }
     }
+    build();
   }
 
   virtual ~FileFormStream() { curl_mime_free(mime_); }
@@ -110,94 +116,47 @@ public:
   std::shared_ptr<FileField> getFileField() const { return fileField_; }
 
   /**
-   * @note This is a specail IStream class whose read method is implemented by
-   * libcurl
+   * @note The multipart body is read through a ChainIStream of the part
+   * headers and the contents of the files, the files are streamed from their
+   * own streams instead of being copied.
    */
   virtual size_t read(char *buffer, size_t expectSize) override {
     if (buffer == nullptr || expectSize == 0) {
       return 0;
     }
+    return body_->read(buffer, expectSize);
+  }
 
-    // 如果正在流式读取文件内容
-    if (streaming_ && streamingStream_) {
-      size_t bytesRead = streamingStream_->read(buffer, expectSize);
-      if (bytesRead > 0) {
-        return bytesRead;
-      }
-      // 文件读取完成,添加\r\n
-      streaming_ = false;
-      streamingStream_ = nullptr;
-      const char *fileEnd = "\r\n";
-      size_t endLen = 2;
-      if (endLen <= expectSize) {
-        std::memcpy(buffer, fileEnd, endLen);
-        index_++;
-        return endLen;
-      }
-      return 0;
-    }
+  virtual bool isFinished() const override { return body_->isFinished(); }
 
-    // 读取表单字段
-    if (index_ < keys_.size()) {
-      std::string name = keys_[index_];
-      const auto &fieldValue = form_[name];
-
-      // 检查是否为文件字段
-      if (isFileFiled(fieldValue)) {
-        streaming_ = true;
-        streamingStream_ =
-            fieldValue["content"].get<std::shared_ptr<IStream>>();
-        std::string filename = fieldValue["filename"].get<std::string>();
-        std::string contentType = fieldValue["contentType"].get<std::string>();
-
-        std::ostringstream oss;
-        oss << "--" << boundary_ << "\r\n"
-            << "Content-Disposition: form-data; name=\"" << name
-            << "\"; filename=\"" << filename << "\"\r\n"
-            << "Content-Type: " << contentType << "\r\n\r\n";
-        std::string header = oss.str();
-
-        size_t copyLen = std::min(header.size(), expectSize);
-        std::memcpy(buffer, header.c_str(), copyLen);
-        return copyLen;
-      } else {
-        std::ostringstream oss;
-        oss << "--" << boundary_ << "\r\n"
-            << "Content-Disposition: form-data; name=\"" << name << "\"\r\n\r\n"
-            << fieldValue.dump() << "\r\n";
-        std::string formField = oss.str();
-
-        size_t copyLen = std::min(formField.size(), expectSize);
-        std::memcpy(buffer, formField.c_str(), copyLen);
-        index_++;
-        return copyLen;
-      }
-    } else if (index_ == keys_.size()) {
-      std::string endStr = "--" + boundary_ + "--\r\n";
-      size_t copyLen = std::min(endStr.size(), expectSize);
-      std::memcpy(buffer, endStr.c_str(), copyLen);
-      index_++;
-      return copyLen;
-    } else {
-      return 0;
-    }
-  }
+  virtual bool isSeekable() const override { return body_->isSeekable(); }
+
+  virtual bool seek(uint64_t offset) override { return body_->seek(offset); }
 
-  virtual bool isFinished() const override { return index_ > keys_.size(); }
+  virtual int64_t remainingSize() const override {
+    return body_->remainingSize();
+  }
 
   const Json &getForm() const { return form_; }
   curl_mime *getMime() const { return mime_; }
   void setMine(curl_mime *mine) { mime_ = mine; }
-  void setBoundary(const std::string &boundary) { boundary_ = boundary; }
+  void setBoundary(const std::string &boundary) {
+    boundary_ = boundary;
+    build();
+  }
 
 protected:
+  /**
+   * @brief Compose the multipart body of the form with the boundary.
+   */
+  void build();
+
   curl_mime *mime_ = nullptr;
   Json form_ = nullptr;
   std::string boundary_;
   std::vector<std::string> keys_;
-  size_t index_ = 0;
-  bool streaming_ = false;
-  std::shared_ptr<IStream> streamingStream_ = nullptr;
+  std::map<std::string, std::shared_ptr<IStream>> contents_;
+  std::shared_ptr<ChainIStream> body_;
   std::shared_ptr<FileField> fileField_ = nullptr;
 };
 
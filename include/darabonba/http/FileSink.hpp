@@ -0,0 +1,59 @@
+#ifndef DARABONBA_HTTP_FILE_SINK_H_
+#define DARABONBA_HTTP_FILE_SINK_H_
+
+#include <atomic>
+#include <cstdint>
+#include <darabonba/Stream.hpp>
+#include <string>
+
+namespace Darabonba {
+namespace Http {
+
+/**
+ * @brief A response body sink writing straight to a file descriptor.
+ * @note Every chunk is handed to the kernel by the perform thread, there is
+ *       no user space buffer to flush, so the file is complete as soon as
+ *       MCurlResponseBody::waitForDone() returns. The file is truncated when
+ *       opened.
+ */
+class FileSink : public OStream {
+public:
+  explicit FileSink(const std::string &path);
+
+  virtual ~FileSink();
+
+  FileSink(const FileSink &) = delete;
+  FileSink &operator=(const FileSink &) = delete;
+
+  bool isOpen() const { return fd_ >= 0; }
+
+  const std::string &getPath() const { return path_; }
+
+  /**
+   * @return The size of the data accepted, less than expectSize on a write
+   *         error, which aborts the transfer writing to the sink.
+   */
+  virtual size_t write(char *buffer, size_t expectSize) override;
+
+  /**
+   * @brief Reserve the disk blocks of the expected size ahead of the writes.
+   * @note The size of the file is not changed, a shorter body leaves no
+   *       trailing zeros. Only done on Linux, a no-op elsewhere.
+   * @return false if the space could not be reserved.
+   */
+  bool preallocate(uint64_t size);
+
+  uint64_t getWrittenSize() const { return written_; }
+
+  void close();
+
+protected:
+  std::string path_;
+  int fd_ = -1;
+  std::atomic<uint64_t> written_ = {0};
+};
+
+} // namespace Http
+} // namespace Darabonba
+
+#endif
@@ -1,16 +1,26 @@
+#ifndef DARABONBA_HTTP_MCURL_HTTP_CLIENT_H_
+#define DARABONBA_HTTP_MCURL_HTTP_CLIENT_H_
+
 #include <darabonba/Core.hpp>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <darabonba/Runtime.hpp>
+#include <darabonba/http/BufferBudget.hpp>
+#include <darabonba/http/CurlShare.hpp>
 #include <darabonba/http/MCurlResponse.hpp>
 #include <darabonba/http/Request.hpp>
+#include <darabonba/lock/MPSCQueue.hpp>
 #include <darabonba/lock/SpinLock.hpp>
+#include <exception>
+#include <functional>
 #include <future>
 #include <list>
 #include <memory>
 #include <mutex>
 #include <thread>
 #include <unordered_map>
+#include <vector>
 
 namespace Darabonba {
 namespace Http {
@@ -21,31 +31,213 @@ class MCurlResponseBody;
 class MCurlHttpClient {
   friend class MCurlResponseBody;
 
+protected:
+  class PerformLoop;
+
 public:
-  MCurlHttpClient() 
-    : mCurl_(curl_multi_init()),
-      poolConfig_(std::make_shared<ConnectionPoolConfig>()) {}
+  /**
+   * @brief Called once per request, with the response when it is ready or
+   * with the error which ended the request.
+   * @note The error is a ResponseException for a network error, and a
+   *       std::future_error (broken_promise) for a request dropped by stop().
+   *       Both are null with a null response when the request could not be
+   *       sent, as the future would hold a nullptr.
+   */
+  using ResponseCallback = std::function<void(
+      std::shared_ptr<MCurlResponse> response, std::exception_ptr error)>;
+
+  /**
+   * @brief Run a task on some other thread, e.g. by posting it to a pool.
+   */
+  using Executor = std::function<void(std::function<void()> task)>;
+
+  /**
+   * @brief A group of perform loops which can be shared by many clients.
+   * @note A client created with a shared reactor does not own any thread, it
+   *       only submits its transfers to the loops of the reactor.
+   */
+  class Reactor {
+    friend class MCurlHttpClient;
+
+  public:
+    explicit Reactor(size_t loopCount = 1,
+                     const ConnectionPoolConfig &config = ConnectionPoolConfig());
+    ~Reactor();
+
+    Reactor(const Reactor &) = delete;
+    Reactor &operator=(const Reactor &) = delete;
+
+    /**
+     * @brief The process-wide reactor used by Core::doAction.
+     * @note It is created on first use with a bounded number of loops and is
+     *       never stopped explicitly.
+     */
+    static std::shared_ptr<Reactor> shared() { return shared(0); }
+
+    /**
+     * @brief The process-wide reactor with the given number of loops, engine
+     * and multiplexing, there is one per combination asked for.
+     * @param loopCount 0 for the bounded default of shared().
+     * @param eventDriven Run the loops on epoll, see isEventDriven().
+     * @param http2 Multiplex the transfers, for the clients with http2. The
+     *        transfers of the others keep a connection each.
+     */
+    static std::shared_ptr<Reactor> shared(size_t loopCount,
+                                           bool eventDriven = false,
+                                           bool http2 = false);
+
+    bool start();
+
+    bool stop();
+
+    bool isRunning() const { return running_; }
+
+    size_t getLoopCount() const { return loops_.size(); }
+
+    /**
+     * @brief Whether the loops run on epoll and curl_multi_socket_action.
+     * @note ConnectionPoolConfig::event_driven is only a request, the loops
+     *       keep curl_multi_poll where epoll is not available.
+     */
+    bool isEventDriven() const;
+
+    /**
+     * @brief Get the number of transfers submitted but not yet completed
+     */
+    size_t getOutstandingCount() const;
+
+    /**
+     * @note Only the settings of the CURLM (total connections, connections per
+     *       host and pipelining) are taken from this config.
+     */
+    void setConnectionPoolConfig(const ConnectionPoolConfig &config) {
+      std::atomic_store(&poolConfig_,
+                        std::make_shared<ConnectionPoolConfig>(config));
+      ++configVersion_;
+    }
+
+    ConnectionPoolConfig getConnectionPoolConfig() const {
+      auto configPtr = std::atomic_load(&poolConfig_);
+      return configPtr ? *configPtr : ConnectionPoolConfig();
+    }
+
+    /**
+     * @brief Raise CURLMOPT_MAX_CONCURRENT_STREAMS of the loops to at least
+     * streams, it is never lowered.
+     * @note Called by the clients with http2 attached to the reactor, so the
+     *       limit is the largest one asked by them.
+     */
+    void raiseMaxConcurrentStreams(size_t streams);
+
+  protected:
+    enum { MAX_SHARED_LOOPS = 4 };
+
+    /**
+     * @brief Pick the loop with the least outstanding transfers.
+     */
+    size_t selectLoop();
+
+    std::vector<std::unique_ptr<PerformLoop>> loops_;
+
+    std::atomic<size_t> nextLoop_ = {0};
+
+    std::atomic<bool> running_ = {false};
+
+    // Bumped by setConnectionPoolConfig, each loop applies the new config when
+    // it observes a version it has not applied yet
+    std::atomic<uint64_t> configVersion_ = {0};
+
+    std::shared_ptr<ConnectionPoolConfig> poolConfig_;
+  };
+
+  MCurlHttpClient()
+      : poolConfig_(std::make_shared<ConnectionPoolConfig>()),
+        ownBudget_(std::make_shared<BufferBudget>()),
+        bufferBudget_(ownBudget_) {}
+
+  /**
+   * @brief Create a client which submits its transfers to a shared reactor.
+   * @note ConnectionPoolConfig::max_host_connections is enforced by the
+   *       client as a limit of in-flight transfers, since the CURLM of the
+   *       reactor is shared with other hosts.
+   */
+  explicit MCurlHttpClient(std::shared_ptr<Reactor> reactor)
+      : poolConfig_(std::make_shared<ConnectionPoolConfig>()),
+        ownBudget_(std::make_shared<BufferBudget>()),
+        bufferBudget_(ownBudget_), reactor_(std::move(reactor)), sharedReactor_(reactor_ != nullptr) {}
+
   ~MCurlHttpClient() {
     stop();
-    if (performThread_.joinable()) {
-      performThread_.join();
-    }
-    clearQueue();
-    curl_multi_cleanup(mCurl_);
-    mCurl_ = nullptr;
+    reactor_.reset();
   }
 
+  /**
+   * @param options The runtime options (connectTimeout, readTimeout,
+   * ignoreSSL, httpProxy, httpsProxy and noProxy), they are converted to a
+   * RequestConfig on every call.
+   */
   std::future<std::shared_ptr<MCurlResponse>>
   makeRequest(const Request &request, const Darabonba::Json &options = {});
 
   /**
-   * @brief Start a background thread to handle network IO
+   * @brief Make a request with typed per-request options.
+   * @note No Json is built or parsed, a RequestConfig can be prepared once
+   *       and reused by all the requests sharing the same options.
+   */
+  std::future<std::shared_ptr<MCurlResponse>>
+  makeRequest(const Request &request, const RequestConfig &config);
+
+  /**
+   * @brief Make a request whose body is written to a sink by the perform
+   * thread, nothing is buffered and no reader is needed.
+   * @note The response is ready with the first data, use
+   *       MCurlResponseBody::waitForDone() to wait for the end of the body.
+   *       With a FileSink the disk space is reserved from Content-Length.
+   */
+  std::future<std::shared_ptr<MCurlResponse>>
+  makeRequest(const Request &request, const RequestConfig &config,
+              std::shared_ptr<OStream> sink);
+
+  /**
+   * @brief Make a request whose body is downloaded to a file through a
+   * FileSink.
+   * @return A nullptr response if the file cannot be created.
+   */
+  std::future<std::shared_ptr<MCurlResponse>>
+  makeRequest(const Request &request, const RequestConfig &config,
+              const std::string &filePath);
+
+  /**
+   * @brief Make a request whose completion is pushed to a callback, no
+   * promise is allocated and no thread waits for the response.
+   * @param executor Runs the callback, nullptr to run it on the perform
+   *                 thread once the loop is done with the transfer.
+   * @note A callback run on the perform thread must not block: the body
+   *       is ready with the first data, and reading more of it from the
+   *       perform thread waits for a transfer that thread drives. Give an
+   *       executor to read the body in the callback.
+   */
+  void makeRequest(const Request &request, const RequestConfig &config,
+                   ResponseCallback callback, Executor executor = nullptr);
+
+  /**
+   * @brief Run a task on a perform thread, outside of any curl callback.
+   * @return false if the client is not running, the task is not kept.
+   * @note The task must not block, the transfers of the loop wait for it.
+   */
+  bool post(std::function<void()> task);
+
+  /**
+   * @brief Start the background perform loops to handle network IO
+   * @note The number of loops is taken from ConnectionPoolConfig::io_threads
+   *       the first time the client is started. A client created with a
+   *       shared reactor does not start any thread.
    */
   bool start();
 
   /**
-   * @brief Stop the backgroud thread.
-   * @note All existing connections will be removed.
+   * @brief Stop the backgroud perform loops.
+   * @note All existing transfers of this client will be removed.
    */
   bool stop();
 
@@ -53,13 +245,22 @@ public:
    * @brief Set connection pool configuration
    * @param config The connection pool configuration to apply
    * @note Thread-safe: uses atomic store for lock-free concurrent access.
-   *       The actual CURL multi handle update is deferred to the perform thread
-   *       to avoid calling curl_multi_setopt during curl_multi_perform.
+   *       The actual CURL multi handle update is deferred to the perform
+   *       threads to avoid calling curl_multi_setopt during
+   *       curl_multi_perform.
    */
   void setConnectionPoolConfig(const ConnectionPoolConfig &config) {
-    std::atomic_store(&poolConfig_, std::make_shared<ConnectionPoolConfig>(config));
-    // Signal that config needs to be applied in perform thread
-    configNeedsUpdate_.store(true);
+    auto configPtr = std::make_shared<ConnectionPoolConfig>(config);
+    std::atomic_store(&poolConfig_, configPtr);
+    ownBudget_->setLimit(config.max_buffered_bytes);
+    // The CURLM settings only belong to the client when it owns the reactor,
+    // a shared one only takes the streams per connection
+    auto reactor = std::atomic_load(&reactor_);
+    if (reactor && !sharedReactor_) {
+      reactor->setConnectionPoolConfig(config);
+    } else if (reactor && (config.http2 || config.http2_prior_knowledge)) {
+      reactor->raiseMaxConcurrentStreams(config.max_concurrent_streams);
+    }
   }
 
   /**
@@ -71,6 +272,87 @@ public:
     return configPtr ? *configPtr : ConnectionPoolConfig();
   }
 
+  /**
+   * @brief Get the number of perform loops created by start()
+   */
+  size_t getPerformLoopCount() const {
+    auto reactor = std::atomic_load(&reactor_);
+    return reactor ? reactor->getLoopCount() : 0;
+  }
+
+  /**
+   * @brief Get the number of transfers of this client submitted but not yet
+   * completed
+   */
+  size_t getOutstandingCount() const { return inflight_ + pendingSize_; }
+
+  std::shared_ptr<Reactor> getReactor() const {
+    return std::atomic_load(&reactor_);
+  }
+
+  /**
+   * @brief Attach the easy handles of the next requests to a share, nullptr
+   * to stop sharing.
+   * @note The in-flight transfers keep the share they were started with.
+   */
+  void setCurlShare(std::shared_ptr<CurlShare> share) {
+    std::atomic_store(&curlShare_, std::move(share));
+  }
+
+  std::shared_ptr<CurlShare> getCurlShare() const {
+    return std::atomic_load(&curlShare_);
+  }
+
+  /**
+   * @brief Metrics of the easy handles recycled by a client
+   */
+  struct EasyHandlePoolMetrics {
+    // idle handles kept in the pool
+    size_t size = 0;
+    // ConnectionPoolConfig::easy_handle_pool_size
+    size_t capacity = 0;
+    // requests served by a recycled handle
+    uint64_t hits = 0;
+    // requests which had to create a new handle
+    uint64_t misses = 0;
+
+    double hitRate() const {
+      auto total = hits + misses;
+      return total ? static_cast<double>(hits) / static_cast<double>(total)
+                   : 0.0;
+    }
+  };
+
+  EasyHandlePoolMetrics getEasyHandlePoolMetrics() const;
+
+  /**
+   * @brief Get the number of connections opened by the transfers of this
+   * client, with HTTP/2 multiplexing it stays far below the request count.
+   */
+  uint64_t getConnectCount() const { return connectCount_; }
+
+  /**
+   * @brief Account the bodies of the next requests in a budget shared with
+   * other clients, nullptr to go back to the budget of the client.
+   * @note The budget of the client is limited by
+   *       ConnectionPoolConfig::max_buffered_bytes, a shared one keeps its
+   *       own limit. The existing bodies stay in the budget they started
+   *       with.
+   */
+  void setBufferBudget(std::shared_ptr<BufferBudget> budget) {
+    std::atomic_store(&bufferBudget_, budget ? std::move(budget) : ownBudget_);
+  }
+
+  std::shared_ptr<BufferBudget> getBufferBudget() const {
+    return std::atomic_load(&bufferBudget_);
+  }
+
+  /**
+   * @brief Get the response data buffered by the bodies of the budget of
+   * this client and not read yet.
+   */
+  size_t getBufferedBytes() const { return getBufferBudget()->getCurrent(); }
+
 protected:
   enum { WAIT_MS = 2000 };
 
@@ -85,52 +367,280 @@ protected:
     std::shared_ptr<MCurlResponse> resp;
 
     std::unique_ptr<std::promise<std::shared_ptr<MCurlResponse>>> promise;
+
+    MCurlHttpClient *client;
+
+    // keep the share alive while the easy handle is attached to it
+    std::shared_ptr<CurlShare> share;
+
+    // set instead of the promise by the callback overload of makeRequest
+    ResponseCallback callback;
+    Executor executor;
+
+    // the loop driving the transfer, runs the callback without an executor
+    PerformLoop *loop;
+
+    /**
+     * @brief A request dropped before its response was ready completes with
+     * broken_promise, like the future of a destroyed promise.
+     */
+    ~CurlStorage();
+
+    bool isPending() const { return promise || callback; }
+
+    /**
+     * @brief Fulfill the promise or run the callback, only the first call
+     * has an effect.
+     */
+    void complete(std::shared_ptr<MCurlResponse> response,
+                  std::exception_ptr error);
   };
 
-  void perform();
+  /**
+   * @brief A perform thread driving its own CURLM.
+   * @note Transfers are pinned to the loop they were submitted to, so every
+   *       curl call for an easy handle happens on the same thread.
+   */
+  class PerformLoop {
+  public:
+    explicit PerformLoop(Reactor *reactor)
+        : reactor_(reactor), mCurl_(curl_multi_init()) {}
+    ~PerformLoop();
 
-  bool addContinueReadingHandle(CURL *easyHandle);
+    PerformLoop(const PerformLoop &) = delete;
+    PerformLoop &operator=(const PerformLoop &) = delete;
 
-  static size_t recvBody(char *buffer, size_t size, size_t nmemb,
-                         void *userdata);
+    bool start();
 
-  static bool setResponseReady(CurlStorage *curlStorage);
+    bool stop();
 
-  void clearQueue();
+    void submit(std::unique_ptr<CurlStorage> storage);
 
-  // Apply connection pool settings to curl multi handle
-  void applyConnectionPoolSettings();
+    bool addContinueReadingHandle(CURL *easyHandle);
 
-  std::thread performThread_;
+    /**
+     * @brief Run a task on the perform thread, between two rounds of
+     * curl_multi_perform.
+     * @return false if the loop is not running.
+     */
+    bool post(std::function<void()> task);
 
-  std::atomic<bool> running_ = {false};
+    /**
+     * @brief Remove all the transfers of the client from this loop.
+     * @note Blocks until the perform thread has processed the request.
+     */
+    void detach(MCurlHttpClient *client);
+
+    /**
+     * @brief The number of transfers queued or running in this loop
+     */
+    size_t getOutstanding() const { return outstanding_.load(); }
+
+    bool valid() const { return mCurl_ != nullptr; }
+
+    /**
+     * @brief Whether the loop runs on curl_multi_socket_action and epoll
+     * instead of curl_multi_poll.
+     */
+    bool isEventDriven() const { return eventDriven_; }
+
+  protected:
+    enum { MAX_EVENTS = 256 };
+
+    void perform();
+
+    // Wake the perform thread up from curl_multi_poll or epoll_wait
+    void wakeup();
+
+    // One round of curl_multi_poll and curl_multi_perform over all handles
+    void pollOnce();
+
+    // One round of epoll_wait, only the sockets with events are serviced
+    void socketActionOnce();
+
+    // Finish the transfers reported by curl_multi_info_read
+    void processMessages();
+
+    /**
+     * @brief Create the epoll instance and register the socket and timer
+     * callbacks of mCurl_.
+     * @return false if not supported, the loop then falls back to
+     *         curl_multi_poll
+     */
+    bool openEventEngine();
+
+    void closeEventEngine();
+
+    static int socketCallback(CURL *easyHandle, curl_socket_t socket, int what,
+                              void *userp, void *socketp);
+
+    static int timerCallback(CURLM *multi, long timeoutMs, void *userp);
+
+    // Move the submitted transfers from reqQueue_ to mCurl_
+    void addQueuedTransfers();
+
+    // Run the tasks of taskQueue_
+    void runTasks();
+
+    void clearQueue();
+
+    void removeTransfers(MCurlHttpClient *client);
+
+    // Apply connection pool settings to curl multi handle
+    void applyConnectionPoolSettings();
+
+    Reactor *reactor_;
+
+    std::thread performThread_;
+
+    std::atomic<bool> running_ = {false};
+
+    /**
+     * @note reqQueue_ and continueReadingQueue_ are consumed by
+     *       performThread_, or under detachMutex_ once it has exited.
+     */
+    Lock::MPSCQueue<std::unique_ptr<CurlStorage>> reqQueue_;
+    Lock::MPSCQueue<CURL *> continueReadingQueue_;
+    // Drained by the perform thread, or by clearQueue() once it has exited
+    Lock::MPSCQueue<std::function<void()>> taskQueue_;
+
+    std::mutex detachMutex_;
+    std::condition_variable detachCV_;
+    std::list<MCurlHttpClient *> detachQueue_;
+    std::atomic<size_t> detachQueueSize_ = {0};
+
+    CURLM *mCurl_ = nullptr;
+
+    /**
+     * @note runningCurl_ can be accessed in performThread_
+     */
+    std::unordered_map<CURL *, std::unique_ptr<CurlStorage>> runningCurl_;
 
-  Lock::SpinLock reqLock_;
-  std::list<std::unique_ptr<CurlStorage>> reqQueue_;
-  std::atomic<size_t> reqQueueSize_ = {0};
+    std::atomic<size_t> outstanding_ = {0};
 
-  Lock::SpinLock continueReadingLock_;
-  std::list<CURL *> continueReadingQueue_;
-  std::atomic<size_t> continueReadingQueueSize_ = {0};
+    // The configVersion_ of the reactor last applied to mCurl_
+    uint64_t appliedConfigVersion_ = 0;
 
-  CURLM *mCurl_ = nullptr;
+    std::atomic<bool> eventDriven_ = {false};
+
+    // epoll instance and eventfd used by wakeup() in event driven mode
+    int epollFd_ = -1;
+    int wakeFd_ = -1;
+
+    // Deadline requested by timerCallback, only accessed in performThread_
+    bool timerArmed_ = false;
+    std::chrono::steady_clock::time_point timerDeadline_;
+
+    std::mutex stopMutex_;
+    std::condition_variable stopCV_;
+    // true while no perform thread is running
+    std::atomic<bool> stop_ = {true};
+  };
+
+  /**
+   * @param requestConfig The per-request options, nullptr to keep the
+   * defaults of libcurl.
+   * @param sink The sink of the body, nullptr to buffer it.
+   */
+  std::future<std::shared_ptr<MCurlResponse>>
+  doRequest(const Request &request, const RequestConfig *requestConfig,
+            std::shared_ptr<OStream> sink = nullptr);
+
+  /**
+   * @brief Set up the easy handle and the storage of a request, its
+   * completion is left to the caller.
+   * @return nullptr if the client is not running or no handle is available.
+   */
+  std::unique_ptr<CurlStorage>
+  prepareRequest(const Request &request, const RequestConfig *requestConfig,
+                 std::shared_ptr<OStream> sink);
+
+  bool addContinueReadingHandle(CURL *easyHandle, size_t loopIndex);
+
+  bool post(size_t loopIndex, std::function<void()> task);
+
+  /**
+   * @brief Take an idle easy handle from the pool, or create a new one.
+   */
+  CURL *acquireEasyHandle();
+
+  /**
+   * @brief Reset a finished easy handle and keep it for the next request.
+   * @note curl_easy_reset keeps the connection, DNS and TLS session caches
+   *       of the handle. The handle is detached from its share first, and is
+   *       cleaned up if the pool is full or the client has been stopped.
+   */
+  void releaseEasyHandle(CURL *easyHandle);
+
+  void clearEasyHandlePool();
+
+  /**
+   * @brief Hand the transfer to a loop of the reactor, or keep it pending
+   * when the client already has max_host_connections transfers in flight.
+   */
+  void dispatch(std::unique_ptr<CurlStorage> storage);
+
+  /**
+   * @brief Called by the perform thread when a transfer of this client ends.
+   */
+  void onTransferDone();
+
+  void submit(std::unique_ptr<CurlStorage> storage);
 
   /**
-   * @note runningCurl_ can be accessed in performThread_
+   * @brief Size the segments of the body buffer, or reserve the space of a
+   * FileSink, from Content-Length before the first data is written.
    */
-  std::unordered_map<CURL *, std::unique_ptr<CurlStorage>> runningCurl_;
+  static void adaptToContentLength(CurlStorage *curlStorage);
+
+  static size_t recvBody(char *buffer, size_t size, size_t nmemb,
+                         void *userdata);
+
+  static bool setResponseReady(CurlStorage *curlStorage);
+
+  std::atomic<bool> running_ = {false};
+
+  // Transfers handed to the reactor and not finished yet
+  std::atomic<size_t> inflight_ = {0};
+
+  // Transfers waiting for a free slot of max_host_connections
+  Lock::SpinLock pendingLock_;
+  std::list<std::unique_ptr<CurlStorage>> pending_;
+  std::atomic<size_t> pendingSize_ = {0};
 
-  std::mutex stopMutex_;
-  std::condition_variable stopCV_;
-  std::atomic<bool> stop_ = {false};
+  // Idle easy handles, reset and ready to be reused
+  mutable Lock::SpinLock handlePoolLock_;
+  std::vector<CURL *> handlePool_;
+  std::atomic<uint64_t> handlePoolHits_ = {0};
+  std::atomic<uint64_t> handlePoolMisses_ = {0};
 
-  // Flag to indicate config needs update in perform thread
-  std::atomic<bool> configNeedsUpdate_{false};
+  // New connections reported by CURLINFO_NUM_CONNECTS
+  std::atomic<uint64_t> connectCount_ = {0};
+
+  // Access with atomic_load/atomic_store
+  std::shared_ptr<CurlShare> curlShare_;
 
   // Connection pool configuration (atomic for lock-free concurrent access)
   // Use atomic_load/atomic_store for thread-safe read/write
   std::shared_ptr<ConnectionPoolConfig> poolConfig_;
+
+  // Limited by ConnectionPoolConfig::max_buffered_bytes
+  const std::shared_ptr<BufferBudget> ownBudget_;
+
+  // Access with atomic_load/atomic_store, shared with the bodies which may
+  // outlive the client
+  std::shared_ptr<BufferBudget> bufferBudget_;
+
+  /**
+   * @note Access with atomic_load/atomic_store, the reactor is created by
+   *       start() unless a shared one is given to the constructor.
+   */
+  std::shared_ptr<Reactor> reactor_;
+
+  const bool sharedReactor_ = false;
 };
 
 } // namespace Http
-} // namespace Darabonba
\ No newline at end of file
+} // namespace Darabonba
+
+#endif
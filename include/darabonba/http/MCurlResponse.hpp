@@ -4,10 +4,12 @@
 #include <condition_variable>
 #include <curl/curl.h>
 #include <darabonba/Stream.hpp>
-#include <darabonba/buffer/RingBuffer.hpp>
+#include <darabonba/buffer/SPSCPipe.hpp>
+#include <darabonba/http/BufferBudget.hpp>
 #include <darabonba/http/Header.hpp>
 #include <darabonba/http/ResponseBase.hpp>
 #include <darabonba/lock/SpinLock.hpp>
+#include <functional>
 #include <memory>
 #include <mutex>
 
@@ -19,18 +21,43 @@ class MCurlHttpClient;
 class MCurlResponseBody : public IOStream {
 
   friend class MCurlHttpClient;
+  friend class BufferBudget;
 
 public:
   MCurlResponseBody &operator=(const MCurlResponseBody &) = delete;
 
   MCurlResponseBody &operator=(MCurlResponseBody &&) = delete;
 
-  virtual ~MCurlResponseBody() = default;
+  virtual ~MCurlResponseBody();
 
-  size_t getMaxSize() const { return maxSize_; }
-  // size_t setMaxSize(size_t maxSize) { maxSize_ = maxSize; }
+  /**
+   * @brief The high watermark, curl is paused once this much data is
+   * buffered.
+   */
+  size_t getMaxSize() const { return highWatermark_; }
+
+  /**
+   * @brief Set the high watermark, the low watermark becomes half of it.
+   */
+  void setMaxSize(size_t maxSize) { setWatermarks(maxSize, 0); }
+
+  /**
+   * @brief The buffered size under which a paused transfer is resumed.
+   */
+  size_t getLowWatermark() const { return lowWatermark_; }
 
-  size_t getReadableSize() const { return readableSize_; }
+  /**
+   * @brief Set the flow control of the body.
+   * @param high Curl is paused once this much data is buffered.
+   * @param low A paused transfer is resumed when the reader has drained the
+   *            buffer to this size, 0 or a value not below high for half of
+   *            high.
+   * @note The gap between the two keeps a slow reader from pausing and
+   *       resuming the transfer on every chunk.
+   */
+  void setWatermarks(size_t high, size_t low);
+
+  size_t getReadableSize() const { return pipe_.readableSize(); }
 
   /**
    * @note This method is thread safe.
@@ -39,17 +66,64 @@ public:
   virtual size_t read(char *buffer, size_t expectSize) override;
 
   virtual bool isFinished() const override {
-    if (done_ && readableSize_ == 0) {
+    if (done_ && pipe_.readableSize() == 0) {
       return true;
     }
     return false;
   };
 
+  /**
+   * @brief Borrow the next contiguous readable data without copying it.
+   * @param data Set to the first readable byte.
+   * @return The size of the data at data, 0 if the body has been fully read.
+   * @note The calling thread will be blocked if there is no data in the buffer.
+   * @note The data stays valid until consume() is called, peek() and consume()
+   *       must not be mixed with read() from other threads.
+   */
+  size_t peek(const char **data);
+
+  /**
+   * @brief Release the data borrowed by peek().
+   */
+  void consume(size_t size);
+
+  /**
+   * @brief Whether read() or peek() would return without waiting.
+   */
+  bool isReadable() const { return done_ || pipe_.readableSize() > 0; }
+
+  /**
+   * @brief Run a callback once the body is readable, instead of parking the
+   * reader.
+   * @return false if the body is already readable, the callback is dropped.
+   * @note The callback runs once, on the perform thread of the transfer
+   *       outside of the curl callbacks, and must not block. Only one
+   *       callback can be pending.
+   */
+  bool notifyWhenReadable(std::function<void()> callback);
+
   /**
    * @brief This method is thread safe.
+   * @note With a sink the data bypasses the buffer and goes to the sink.
    */
   virtual size_t write(char *buffer, size_t expectSize) override;
 
+  /**
+   * @brief Deliver the rest of the body to a sink instead of the buffer.
+   * @note The buffered data is moved to the sink first, the following data is
+   *       written to the sink from the buffer of curl by the perform thread,
+   *       so no copy is kept in the body. A sink which accepts less data than
+   *       it is given aborts the transfer. Use waitForDone() to wait for the
+   *       end of the body.
+   * @return false if a sink was already set
+   */
+  bool setSink(std::shared_ptr<OStream> sink);
+
+  std::shared_ptr<OStream> getSink() const {
+    std::lock_guard<std::mutex> lock(sinkMutex_);
+    return sink_;
+  }
+
   void waitForDone();
 
   /**
@@ -57,6 +131,12 @@ public:
    */
   bool getDone() const { return done_; }
 
+  /**
+   * @brief Whether the body ended before all of its data was received,
+   * because the transfer failed or was dropped by stop().
+   */
+  bool isAborted() const { return aborted_; }
+
   /**
    * @brief Indicate whether http response body is ready to receive.
    */
@@ -74,24 +154,105 @@ protected:
   /**
    * @brief The maximum size of data stored in the body
    */
-  std::atomic<size_t> maxSize_ = {MAX_SIZE};
+  std::atomic<size_t> highWatermark_ = {MAX_SIZE};
+  std::atomic<size_t> lowWatermark_ = {MAX_SIZE / 2};
+  // Set by the perform thread when it pauses the transfer, cleared with
+  // handleLock_ held when the transfer finishes
+  std::atomic<bool> paused_ = {false};
   std::atomic<bool> done_ = {false};
+  // Set before done_ when the body ends without the rest of its data
+  std::atomic<bool> aborted_ = {false};
   std::atomic<bool> ready_ = {false};
 
+  /**
+   * @brief Whether the perform thread should pause the transfer instead of
+   * writing more data, called by the perform thread before every chunk.
+   * @note An empty body always takes the next chunk, so a reader waiting for
+   *       data is never starved by the other bodies of the budget.
+   */
+  bool shouldPause();
+
+  /**
+   * @brief Account the data taken out of the buffer and resume the paused
+   * transfer under the low watermark.
+   */
+  void drained(size_t size);
+
+  /**
+   * @brief Resume the transfer if the perform thread paused it.
+   * @return false if it was not paused or has already finished.
+   */
+  bool resume();
+
+  /**
+   * @brief Mark the end of the body, called by the perform thread.
+   */
+  void finish();
+
+  /**
+   * @brief End the body of a transfer which failed or was dropped, called by
+   * the perform thread before the easy handle is freed.
+   * @note The readers are woken up like by finish() and see isAborted().
+   */
+  void detach();
+
+  /**
+   * @brief Park the reader until data is written or the body ends.
+   */
+  void waitForData();
+
+  /**
+   * @brief Wake the parked readers, only called when there are some.
+   */
+  void wakeReaders();
+
+  /**
+   * @brief Hand the callback of notifyWhenReadable() to the perform loop of
+   * the transfer, or run it at once without one.
+   */
+  static void runReadableCallback(std::function<void()> callback,
+                                  MCurlHttpClient *client, size_t loopIndex);
+
+  /**
+   * @brief Move the data of the pipe to sink_, sinkMutex_ must be held.
+   */
+  void flushToSink();
+
   // 用于等待整个数据接受完毕
   mutable std::mutex doneMutex_;
   std::condition_variable doneCV_;
 
-  std::atomic<size_t> readableSize_ = {0};
-
+  // Only used to park the readers when the pipe is empty
   mutable std::mutex streamMutex_;
   std::condition_variable streamCV_;
-
-  Lock::SpinLock bufferlock_;
-  Buffer::RingBuffer buffer_;
-
+  std::atomic<int> waitingReaders_ = {0};
+  // Set by notifyWhenReadable(), counted in waitingReaders_ while set
+  std::function<void()> readableCallback_;
+
+  // The pipe has one producer and one consumer, these locks only serialize
+  // concurrent writers or concurrent readers among themselves and are not
+  // contended by a single reader
+  Lock::SpinLock writeLock_;
+  Lock::SpinLock readLock_;
+  Buffer::SPSCPipe pipe_;
+
+  // Set once by setSink()
+  mutable std::mutex sinkMutex_;
+  std::shared_ptr<OStream> sink_;
+  std::atomic<bool> hasSink_ = {false};
+
+  // The data buffered by all the bodies of the client, shared with it
+  std::shared_ptr<BufferBudget> budget_;
+  // Whether the body is counted as a holder of budget_
+  std::atomic<bool> holding_ = {false};
+
+  // Guards the transfer below, finish() clears it on the perform thread
+  // before the easy handle is recycled for another transfer
+  mutable Lock::SpinLock handleLock_;
   MCurlHttpClient *client_ = nullptr;
   CURL *easyHandle_ = nullptr;
+  // The perform loop of client_ which drives easyHandle_
+  size_t loopIndex_ = 0;
 };
 
 class MCurlResponse : public ResponseBase {
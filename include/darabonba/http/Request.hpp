@@ -7,6 +7,7 @@
 #include <darabonba/http/URL.hpp>
 #include <memory>
 #include <string>
+#include <type_traits>
 
 namespace Darabonba {
 namespace Http {
@@ -133,7 +134,12 @@ public:
     body_ = body;
     return *this;
   }
-  template <typename T> Request &setBody(T &&obj) {
+  // a shared_ptr to any IStream is taken as is, not copied into an ISStream
+  template <typename T,
+            typename std::enable_if<
+                !std::is_convertible<T, std::shared_ptr<IStream>>::value,
+                int>::type = 0>
+  Request &setBody(T &&obj) {
     auto p = new ISStream(std::forward<T>(obj));
     body_ = std::shared_ptr<IStream>(p);
     return *this;
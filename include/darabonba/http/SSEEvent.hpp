@@ -1,6 +1,7 @@
 #ifndef SSE_EVENT_HPP
 #define SSE_EVENT_HPP
 
+#include <cstdint>
 #include <darabonba/Model.hpp>
 #include <darabonba/Type.hpp>
 #include <string>
@@ -9,33 +10,33 @@ using json = nlohmann::json;
 
 namespace Darabonba {
 namespace Http {
+
+/**
+ * @brief A server-sent event.
+ * @note The fields are held by value with a flag telling whether each one is
+ *       set, so a small event lives in the object itself through the small
+ *       string optimization instead of costing an allocation per field. The
+ *       Json of the Model interface is only built by toMap().
+ */
 class SSEEvent : public Darabonba::Model {
 public:
-  friend void to_json(Darabonba::Json &j, const SSEEvent &obj) {
-    DARABONBA_PTR_TO_JSON(id, id_);
-    DARABONBA_PTR_TO_JSON(data, event_);
-    DARABONBA_PTR_TO_JSON(data, data_);
-    DARABONBA_PTR_TO_JSON(retry, retry_);
-  };
+  friend void to_json(Darabonba::Json &j, const SSEEvent &obj);
 
-  friend void from_json(const Darabonba::Json &j, SSEEvent &obj) {
-    DARABONBA_PTR_FROM_JSON(id, id_);
-    DARABONBA_PTR_FROM_JSON(event, event_);
-    DARABONBA_PTR_FROM_JSON(data, data_);
-    DARABONBA_PTR_FROM_JSON(retry, retry_);
-  };
+  friend void from_json(const Darabonba::Json &j, SSEEvent &obj);
 
-  SSEEvent(const std::string &id = "", const std::string &event = "",
+  SSEEvent() = default;
+
+  /**
+   * @note The fields left empty or 0 stay unset.
+   */
+  SSEEvent(const std::string &id, const std::string &event = "",
            const std::string &data = "", int retry = 0);
 
   SSEEvent(const Darabonba::Json &obj) { from_json(obj, *this); };
 
   void validate() const override {};
 
-  virtual bool empty() const override {
-    return id_ == nullptr && event_ == nullptr && data_ == nullptr &&
-           retry_ == nullptr;
-  };
+  virtual bool empty() const override { return flags_ == 0; };
 
   virtual Darabonba::Json toMap() const override {
     Darabonba::Json obj;
@@ -48,28 +49,77 @@ public:
     validate();
   };
 
-  // Accessor methods
-  const std::string &getId() const;
+  /**
+   * @brief Unset every field, the memory of the strings is kept.
+   */
+  void clear();
+
+  // Accessor methods, an unset field reads as empty or 0
+  bool hasId() const { return (flags_ & HAS_ID) != 0; }
+
+  const std::string &getId() const { return id_; }
+
+  void setId(const std::string &id) { set(id_, id, HAS_ID); }
+
+  void setId(std::string &&id) { set(id_, std::move(id), HAS_ID); }
 
-  void setId(const std::string &id);
+  /**
+   * @brief Whether the id was given by an id field of this event, an event
+   * without one carries the last id of the stream.
+   */
+  bool isIdFromField() const { return (flags_ & ID_FROM_FIELD) != 0; }
 
-  const std::string &getEvent() const;
+  void setIdFromField(bool fromField) {
+    flags_ = fromField ? (flags_ | ID_FROM_FIELD)
+                       : static_cast<uint8_t>(flags_ & ~ID_FROM_FIELD);
+  }
 
-  void setEvent(const std::string &event);
+  bool hasEvent() const { return (flags_ & HAS_EVENT) != 0; }
 
-  const std::string &getData() const;
+  const std::string &getEvent() const { return event_; }
 
-  void setData(const std::string &data);
+  void setEvent(const std::string &event) { set(event_, event, HAS_EVENT); }
 
-  int getRetry() const;
+  void setEvent(std::string &&event) {
+    set(event_, std::move(event), HAS_EVENT);
+  }
 
-  void setRetry(int retry);
+  bool hasData() const { return (flags_ & HAS_DATA) != 0; }
+
+  const std::string &getData() const { return data_; }
+
+  void setData(const std::string &data) { set(data_, data, HAS_DATA); }
+
+  void setData(std::string &&data) { set(data_, std::move(data), HAS_DATA); }
+
+  bool hasRetry() const { return (flags_ & HAS_RETRY) != 0; }
+
+  int getRetry() const { return retry_; }
+
+  void setRetry(int retry) {
+    retry_ = retry;
+    flags_ |= HAS_RETRY;
+  }
 
 private:
-  std::shared_ptr<std::string> id_;
-  std::shared_ptr<std::string> event_;
-  std::shared_ptr<std::string> data_;
-  std::shared_ptr<int> retry_;
+  enum : uint8_t {
+    HAS_ID = 1,
+    HAS_EVENT = 2,
+    HAS_DATA = 4,
+    HAS_RETRY = 8,
+    ID_FROM_FIELD = 16
+  };
+
+  template <typename T> void set(std::string &field, T &&value, uint8_t flag) {
+    field = std::forward<T>(value);
+    flags_ |= flag;
+  }
+
+  std::string id_;
+  std::string event_;
+  std::string data_;
+  int retry_ = 0;
+  uint8_t flags_ = 0;
 };
 } // namespace Http
 } // namespace Darabonba
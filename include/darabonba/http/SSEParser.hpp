@@ -0,0 +1,204 @@
+#ifndef DARABONBA_HTTP_SSE_PARSER_H_
+#define DARABONBA_HTTP_SSE_PARSER_H_
+
+#include <cstddef>
+#include <darabonba/Stream.hpp>
+#include <darabonba/http/SSEEvent.hpp>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Darabonba {
+namespace Http {
+
+/**
+ * @brief An incremental decoder of a text/event-stream.
+ * @note The stream is fed in chunks of any size, a line or a CRLF may be
+ *       split across chunks. Every byte is looked at once: the complete lines
+ *       of a chunk are decoded in place, only the unterminated tail is kept
+ *       until the next chunk. The fields follow the HTML Living Standard: a
+ *       line starting with ':' is a comment, the data lines of an event are
+ *       joined with '\n', the id is kept for the following events until
+ *       another id is received, and an event without data is not dispatched.
+ *       The type of an event without an event field is left empty.
+ */
+class SSEParser {
+public:
+  using Callback = std::function<void(const SSEEvent &event)>;
+
+  /**
+   * @brief A parser queueing the events, to be taken with next().
+   */
+  SSEParser() = default;
+
+  /**
+   * @brief A parser handing every event to the callback as it is decoded.
+   */
+  explicit SSEParser(Callback callback) : callback_(std::move(callback)) {}
+
+  /**
+   * @brief Decode a chunk of the stream.
+   * @return The number of events completed by the chunk.
+   */
+  size_t feed(const char *data, size_t size);
+
+  size_t feed(const std::string &data) {
+    return feed(data.data(), data.size());
+  }
+
+  /**
+   * @brief The end of the stream, an event not terminated by an empty line is
+   * discarded.
+   */
+  void finish();
+
+  /**
+   * @brief Take the oldest queued event.
+   * @return false if no event is queued.
+   */
+  bool next(SSEEvent &event);
+
+  size_t pendingEvents() const { return events_.size(); }
+
+  /**
+   * @brief The id of the last event, sent as Last-Event-ID on a reconnection.
+   */
+  const std::string &getLastEventId() const { return lastEventId_; }
+
+  void setLastEventId(const std::string &id) { lastEventId_ = id; }
+
+  /**
+   * @brief The reconnection time in milliseconds last set by the server, -1
+   * if none.
+   */
+  int getRetry() const { return retry_; }
+
+  /**
+   * @brief Forget the state of the stream, except the callback.
+   */
+  void reset();
+
+  /**
+   * @brief Continue the stream on a new connection: the event being decoded
+   * is discarded, the last event id and the reconnection time are kept.
+   */
+  void restart();
+
+protected:
+  void processLine(const char *line, size_t size);
+
+  void processField(const char *name, size_t nameSize, const char *value,
+                    size_t valueSize);
+
+  void dispatch();
+
+  Callback callback_;
+  std::deque<SSEEvent> events_;
+
+  // The unterminated line of the previous chunks
+  std::string line_;
+  // The previous chunk ended with a CR, a LF starting this one ends no line
+  bool skipLF_ = false;
+  bool started_ = false;
+
+  // The fields of the event being decoded
+  std::string data_;
+  std::string eventType_;
+  std::string lastEventId_;
+  // The event being decoded has an id field of its own
+  bool hasIdField_ = false;
+  int eventRetry_ = -1;
+  bool hasData_ = false;
+  int retry_ = -1;
+  // Events completed by the current feed()
+  size_t dispatched_ = 0;
+};
+
+/**
+ * @brief Pull the events of a response body one at a time.
+ * @note An MCurlResponseBody is decoded straight from its buffer with
+ *       peek()/consume(), other streams are read in chunks. next() blocks
+ *       until an event is complete or the body ends.
+ *
+ *       for (auto &event : SSEReader(response->getBody())) { ... }
+ */
+class SSEReader {
+public:
+  explicit SSEReader(std::shared_ptr<IStream> body);
+
+  /**
+   * @return false once the body has ended and every event was taken.
+   */
+  bool next(SSEEvent &event);
+
+  /**
+   * @brief Hand every event to the callback until the body ends.
+   * @return The number of events.
+   */
+  size_t forEach(const SSEParser::Callback &callback);
+
+  const SSEParser &getParser() const { return parser_; }
+
+  SSEParser &getParser() { return parser_; }
+
+  /**
+   * @brief Continue reading the stream from the body of a new connection,
+   * see SSEParser::restart().
+   */
+  void setBody(std::shared_ptr<IStream> body);
+
+  class Iterator {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = SSEEvent;
+    using difference_type = std::ptrdiff_t;
+    using pointer = SSEEvent *;
+    using reference = SSEEvent &;
+
+    Iterator() = default;
+    explicit Iterator(SSEReader *reader) : reader_(reader) { ++*this; }
+
+    SSEEvent &operator*() { return event_; }
+    SSEEvent *operator->() { return &event_; }
+
+    Iterator &operator++() {
+      if (reader_ && !reader_->next(event_))
+        reader_ = nullptr;
+      return *this;
+    }
+
+    bool operator==(const Iterator &other) const {
+      return reader_ == other.reader_;
+    }
+    bool operator!=(const Iterator &other) const { return !(*this == other); }
+
+  private:
+    SSEReader *reader_ = nullptr;
+    SSEEvent event_;
+  };
+
+  Iterator begin() { return Iterator(this); }
+  Iterator end() { return Iterator(); }
+
+protected:
+  /**
+   * @brief Feed the next chunk of the body to the parser.
+   * @return false at the end of the body.
+   */
+  bool fill();
+
+  enum { CHUNK_SIZE = 16 * 1024 };
+
+  std::shared_ptr<IStream> body_;
+  SSEParser parser_;
+  std::vector<char> buffer_;
+  bool ended_ = false;
+};
+
+} // namespace Http
+} // namespace Darabonba
+
+#endif
@@ -0,0 +1,170 @@
+#ifndef DARABONBA_HTTP_SSE_SESSION_H_
+#define DARABONBA_HTTP_SSE_SESSION_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <darabonba/http/MCurlHttpClient.hpp>
+#include <darabonba/http/Request.hpp>
+#include <darabonba/http/SSEParser.hpp>
+#include <darabonba/policy/Retry.hpp>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+namespace Darabonba {
+namespace Http {
+
+/**
+ * @brief A server-sent event stream which survives the loss of its
+ * connection.
+ * @note When the body ends, because the server or a load balancer closed the
+ *       connection or a network error broke it, the request is sent again
+ *       through the same client, so on a connection of its pool, with the id
+ *       of the last event as Last-Event-ID. A seekable request body is
+ *       rewound first. The delay before reconnecting is the retry time sent
+ *       by the server, 3s by default, or the delay of the BackoffPolicy set
+ *       on the session if it is longer. A server resuming the stream may
+ *       replay events up to the last id, the events of a new connection whose
+ *       id was already delivered are dropped until an event with a new id
+ *       comes. The stream ends with a 204 or a client error status, with
+ *       close(), or after maxReconnects connections in a row failed or ended
+ *       without an event.
+ */
+class SSESession {
+public:
+  enum {
+    DEFAULT_RETRY = 3000,
+    DEFAULT_MAX_RECONNECTS = 5,
+    // The ids remembered to recognize the replayed events
+    DEDUP_WINDOW = 256
+  };
+
+  /**
+   * @param config The read_timeout_ms of the config limits how long the
+   *        stream may stay silent, as an idle timeout, not its length.
+   */
+  SSESession(std::shared_ptr<MCurlHttpClient> client, const Request &request,
+             const RequestConfig &config = defaultConfig());
+
+  /**
+   * @brief A RequestConfig without a read timeout, a stream lasts as long as
+   * the server keeps it open.
+   */
+  static RequestConfig defaultConfig() {
+    RequestConfig config;
+    config.read_timeout_ms = 0;
+    return config;
+  }
+
+  SSESession(const SSESession &) = delete;
+  SSESession &operator=(const SSESession &) = delete;
+
+  /**
+   * @brief The policy of the delays between the reconnections, the retry
+   * time of the server is still honored as a minimum.
+   * @note The RetryPolicyContext passed to the policy holds the number of
+   *       connections in a row which failed.
+   */
+  void setBackoffPolicy(std::shared_ptr<Policy::BackoffPolicy> backoff) {
+    backoff_ = std::move(backoff);
+  }
+
+  /**
+   * @param max The connections in a row which may fail or end without an
+   *            event before the stream ends, -1 for no limit.
+   */
+  void setMaxReconnects(int max) { maxReconnects_ = max; }
+
+  /**
+   * @brief Resume a stream from an event received before, sent as
+   * Last-Event-ID on the first connection.
+   */
+  void setLastEventId(const std::string &id) {
+    reader_.getParser().setLastEventId(id);
+  }
+
+  /**
+   * @brief Wait for the next event, reconnecting as needed.
+   * @return false once the stream has ended.
+   */
+  bool next(SSEEvent &event);
+
+  /**
+   * @brief End the stream, a reader waiting for a reconnection returns at
+   * once. This method is thread safe.
+   */
+  void close();
+
+  const std::string &getLastEventId() const {
+    return reader_.getParser().getLastEventId();
+  }
+
+  /**
+   * @brief The delay in milliseconds before the next reconnection.
+   */
+  int getReconnectDelay() const;
+
+  /**
+   * @brief The status code of the last response, 0 before any.
+   */
+  int64_t getStatusCode() const { return statusCode_; }
+
+  uint64_t getReconnects() const { return reconnects_; }
+
+  /**
+   * @brief The replayed events dropped.
+   */
+  uint64_t getDuplicates() const { return duplicates_; }
+
+protected:
+  /**
+   * @return false if no body to read was received.
+   */
+  bool connect();
+
+  /**
+   * @return false if the session was closed while waiting.
+   */
+  bool waitToReconnect();
+
+  bool isDuplicate(const SSEEvent &event);
+
+  void remember(const std::string &id);
+
+  std::shared_ptr<MCurlHttpClient> client_;
+  Request request_;
+  RequestConfig config_;
+  std::shared_ptr<Policy::BackoffPolicy> backoff_;
+  // Used without a policy set and a retry time from the server
+  Policy::FixedBackoffPolicy defaultBackoff_;
+  int maxReconnects_ = DEFAULT_MAX_RECONNECTS;
+
+  SSEReader reader_;
+  bool connected_ = false;
+  // No more connection is made
+  bool ended_ = false;
+  // Connections in a row which failed or ended without an event
+  int failures_ = 0;
+  bool delivered_ = false;
+  uint64_t connections_ = 0;
+  uint64_t reconnects_ = 0;
+  uint64_t duplicates_ = 0;
+  int64_t statusCode_ = 0;
+
+  // The connection may replay the events before the last id
+  bool replaying_ = false;
+  std::deque<std::string> recentIds_;
+  std::unordered_set<std::string> seenIds_;
+
+  std::atomic<bool> closed_ = {false};
+  std::mutex closeMutex_;
+  std::condition_variable closeCV_;
+};
+
+} // namespace Http
+} // namespace Darabonba
+
+#endif
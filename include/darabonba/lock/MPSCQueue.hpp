@@ -0,0 +1,172 @@
+#ifndef MPSC_QUEUE_H_
+#define MPSC_QUEUE_H_
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace Darabonba {
+namespace Lock {
+
+/**
+ * @brief A lock-free multi-producer/single-consumer queue.
+ * @note push() may be called from any thread, pop() only from the consumer.
+ *       Elements go to a bounded ring first; when the ring is full they fall
+ *       back to a linked list of nodes, so push() never fails or blocks.
+ *       Elements of one producer keep their order within each path, but an
+ *       element that overflowed may be popped after a later one in the ring.
+ */
+template <typename T> class MPSCQueue {
+public:
+  explicit MPSCQueue(size_t capacity = 1024)
+      : capacity_(roundUp(capacity)), mask_(capacity_ - 1),
+        cells_(new Cell[capacity_]), overflowHead_(&stub_),
+        overflowTail_(&stub_) {
+    for (size_t i = 0; i < capacity_; ++i) {
+      cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  ~MPSCQueue() {
+    T value;
+    while (pop(value)) {
+    }
+    if (overflowHead_ != &stub_) {
+      delete static_cast<ValueNode *>(overflowHead_);
+    }
+  }
+
+  MPSCQueue(const MPSCQueue &) = delete;
+
+  MPSCQueue(MPSCQueue &&other) = delete;
+
+  MPSCQueue &operator=(const MPSCQueue &) = delete;
+
+  MPSCQueue &operator=(MPSCQueue &&) = delete;
+
+  void push(T value) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell &cell = cells_[pos & mask_];
+      size_t seq = cell.seq.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(seq - pos);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+          new (cell.data()) T(std::move(value));
+          cell.seq.store(pos + 1, std::memory_order_release);
+          return;
+        }
+      } else if (diff < 0) {
+        // the ring is full
+        pushOverflow(std::move(value));
+        return;
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * @brief Take the next element. Must only be called by the consumer.
+   * @return false if no element is visible yet
+   */
+  bool pop(T &value) {
+    size_t pos = head_.load(std::memory_order_relaxed);
+    Cell &cell = cells_[pos & mask_];
+    if (cell.seq.load(std::memory_order_acquire) == pos + 1) {
+      T *ptr = cell.data();
+      value = std::move(*ptr);
+      ptr->~T();
+      cell.seq.store(pos + capacity_, std::memory_order_release);
+      head_.store(pos + 1, std::memory_order_relaxed);
+      return true;
+    }
+    return popOverflow(value);
+  }
+
+  /**
+   * @brief The approximate number of elements in the queue.
+   */
+  size_t size() const {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t head = head_.load(std::memory_order_relaxed);
+    return (tail > head ? tail - head : 0) +
+           overflowSize_.load(std::memory_order_relaxed);
+  }
+
+  bool empty() const { return size() == 0; }
+
+  size_t capacity() const { return capacity_; }
+
+protected:
+  static constexpr size_t kCacheLine = 64;
+
+  struct Cell {
+    std::atomic<size_t> seq;
+    alignas(T) unsigned char storage[sizeof(T)];
+
+    T *data() { return reinterpret_cast<T *>(storage); }
+  };
+
+  struct Node {
+    std::atomic<Node *> next = {nullptr};
+  };
+
+  struct ValueNode : public Node {
+    explicit ValueNode(T &&v) : value(std::move(v)) {}
+    T value;
+  };
+
+  static size_t roundUp(size_t capacity) {
+    size_t n = 2;
+    while (n < capacity) {
+      n <<= 1;
+    }
+    return n;
+  }
+
+  void pushOverflow(T value) {
+    Node *node = new ValueNode(std::move(value));
+    overflowSize_.fetch_add(1, std::memory_order_relaxed);
+    Node *prev = overflowTail_.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  bool popOverflow(T &value) {
+    Node *next = overflowHead_->next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+      return false;
+    }
+    value = std::move(static_cast<ValueNode *>(next)->value);
+    if (overflowHead_ != &stub_) {
+      delete static_cast<ValueNode *>(overflowHead_);
+    }
+    // the popped node becomes the new dummy head
+    overflowHead_ = next;
+    overflowSize_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  const size_t capacity_;
+  const size_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+
+  // keep the producer and consumer indexes on separate cache lines
+  std::atomic<size_t> tail_ = {0};
+  char tailPad_[kCacheLine - sizeof(std::atomic<size_t>)];
+  std::atomic<size_t> head_ = {0};
+  char headPad_[kCacheLine - sizeof(std::atomic<size_t>)];
+
+  Node stub_;
+  // only accessed by the consumer
+  Node *overflowHead_;
+  std::atomic<Node *> overflowTail_;
+  std::atomic<size_t> overflowSize_ = {0};
+};
+
+} // namespace Lock
+} // namespace Darabonba
+
+#endif
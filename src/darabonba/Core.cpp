@@ -1,10 +1,12 @@
 #include <algorithm>
 #include <chrono>
 #include <darabonba/Core.hpp>
+#include <darabonba/http/ClientRegistry.hpp>
 #include <darabonba/http/MCurlHttpClient.hpp>
 #include <darabonba/policy/Retry.hpp>
 #include <fstream>
 #include <iomanip>
+#include <iterator>
 #include <sstream>
 #include <thread>
 #include <mutex>
@@ -36,12 +38,61 @@ namespace Darabonba {
 
 // Global SDK state management
 namespace {
+std::shared_ptr<Http::MCurlHttpClient>
+createHttpClient(const ConnectionPoolConfig &config) {
+  // all the hosts share the perform loops of a process-wide reactor instead
+  // of owning a thread each, io_threads, event_driven and http2 pick the
+  // reactor
+  auto client = std::make_shared<Http::MCurlHttpClient>(
+      Http::MCurlHttpClient::Reactor::shared(
+          config.io_threads, config.event_driven,
+          config.http2 || config.http2_prior_knowledge));
+  client->start();
+  return client;
+}
+
+// The reactor of a client is fixed when it is created, a host asking for
+// another one gets a client of its own. The clients on the default reactor
+// are keyed by the host itself, the key is only built for the others and
+// stored in key.
+const std::string &clientKey(const std::string &host,
+                             const ConnectionPoolConfig &config,
+                             std::string &key) {
+  bool http2 = config.http2 || config.http2_prior_knowledge;
+  if (config.io_threads == 0 && !config.event_driven && !http2)
+    return host;
+  key = host + "#" + std::to_string(config.io_threads) +
+        (config.event_driven ? "e" : "") + (http2 ? "h" : "");
+  return key;
+}
+
+void configureHttpClient(Http::MCurlHttpClient &client,
+                         const ConnectionPoolConfig &config) {
+  client.setConnectionPoolConfig(config);
+  // The share is opt-in, it lets a new host reuse the DNS results and TLS
+  // sessions of the others
+  client.setCurlShare(config.share_cache ? Http::CurlShare::shared()
+                                         : nullptr);
+  // With a shared budget the slow readers of one host also throttle the
+  // others, the limit is the one of the last configured client
+  if (config.share_buffer_budget) {
+    auto budget = Http::BufferBudget::shared();
+    if (config.max_buffered_bytes > 0) {
+      budget->setLimit(config.max_buffered_bytes);
+    }
+    client.setBufferBudget(budget);
+  } else {
+    client.setBufferBudget(nullptr);
+  }
+}
+
 struct SDKState {
   std::atomic<bool> initialized{false};
   std::mutex mutex;
-  // One HTTP client per host (scheme + host + port as key)
-  // Using shared_ptr to allow releasing the lock before calling makeRequest
-  std::map<std::string, std::shared_ptr<Http::MCurlHttpClient>> http_clients;
+  // One HTTP client per host, looked up without lock by doAction
+  // The clients are attached to Http::MCurlHttpClient::Reactor::shared()
+  // keyed by clientKey()
+  Http::ClientRegistry http_clients{createHttpClient, configureHttpClient};
 };
 
 SDKState& GetSDKState() {
@@ -66,34 +117,89 @@ void EnsureInitialized() {
 // Note: maxIdleConns and keepAlive are pool-level settings that should only be
 // configured at the Config level, not in RuntimeOptions. The values here come
 // from Client's Config, passed through the runtime JSON by the Client.
-ConnectionPoolConfig getConnectionPoolConfig(Http::Request &request,
-                                             const Darabonba::Json &runtime) {
-  ConnectionPoolConfig config;
+// The host is left empty, the registry keys the clients by host
+// The runtime keys of the pool config, in the order of the keys of a Json
+// object so that they are read in a single pass over the runtime
+struct PoolKey {
+  const char *name;
+  void (*read)(ConnectionPoolConfig &config, const Darabonba::Json &value);
+};
 
-  auto &url = request.getUrl();
-  auto &header = request.getHeader();
+size_t toSize(const Darabonba::Json &value) {
+  return static_cast<size_t>(value.get<int64_t>());
+}
 
-  // Extract host from URL or header
-  if (!url.getHost().empty()) {
-    config.host = url.getHost();
-  } else {
-    auto it = header.find("host");
-    if (it != header.end()) {
-      config.host = it->second;
-    }
-  }
+const PoolKey POOL_KEYS[] = {
+    {"easyHandlePoolSize",
+     [](ConnectionPoolConfig &c, const Darabonba::Json &v) {
+       c.easy_handle_pool_size = toSize(v);
+     }},
+    {"eventDriven",
+     [](ConnectionPoolConfig &c, const Darabonba::Json &v) {
+       c.event_driven = v.get<bool>();
+     }},
+    {"http2",
+     [](ConnectionPoolConfig &c, const Darabonba::Json &v) {
+       c.http2 = v.get<bool>();
+     }},
+    {"http2PriorKnowledge",
+     [](ConnectionPoolConfig &c, const Darabonba::Json &v) {
+       c.http2_prior_knowledge = v.get<bool>();
+     }},
+    {"ioThreads",
+     [](ConnectionPoolConfig &c, const Darabonba::Json &v) {
+       c.io_threads = toSize(v);
+     }},
+    {"keepAlive",
+     [](ConnectionPoolConfig &c, const Darabonba::Json &v) {
+       c.keep_alive = v.get<bool>();
+     }},
+    {"maxBufferedBytes",
+     [](ConnectionPoolConfig &c, const Darabonba::Json &v) {
+       c.max_buffered_bytes = toSize(v);
+     }},
+    {"maxConcurrentStreams",
+     [](ConnectionPoolConfig &c, const Darabonba::Json &v) {
+       c.max_concurrent_streams = toSize(v);
+     }},
+    {"maxConnections",
+     [](ConnectionPoolConfig &c, const Darabonba::Json &v) {
+       c.max_connections = toSize(v);
+     }},
+    {"maxHostConnections",
+     [](ConnectionPoolConfig &c, const Darabonba::Json &v) {
+       c.max_host_connections = toSize(v);
+     }},
+    {"shareBufferBudget",
+     [](ConnectionPoolConfig &c, const Darabonba::Json &v) {
+       c.share_buffer_budget = v.get<bool>();
+     }},
+    {"shareCache",
+     [](ConnectionPoolConfig &c, const Darabonba::Json &v) {
+       c.share_cache = v.get<bool>();
+     }},
+};
+
+ConnectionPoolConfig getConnectionPoolConfig(const Darabonba::Json &runtime) {
+  ConnectionPoolConfig config;
 
   // Read connection pool settings from runtime (these are Config-level values
-  // passed by Client, not per-request RuntimeOptions)
-  if (!runtime.is_null()) {
-    if (runtime.contains("maxConnections")) {
-      config.max_connections = static_cast<size_t>(runtime["maxConnections"].get<int64_t>());
-    }
-    if (runtime.contains("keepAlive")) {
-      config.keep_alive = runtime["keepAlive"].get<bool>();
+  // passed by Client, not per-request RuntimeOptions). The keys of a Json
+  // object are sorted, both lists are walked once side by side instead of
+  // looking every key up.
+  if (!runtime.is_object()) {
+    return config;
+  }
+  const PoolKey *key = std::begin(POOL_KEYS);
+  const PoolKey *last = std::end(POOL_KEYS);
+  for (auto it = runtime.begin(); it != runtime.end() && key != last; ++it) {
+    const std::string &name = it.key();
+    while (key != last && name.compare(key->name) > 0) {
+      ++key;
     }
-    if (runtime.contains("maxHostConnections")) {
-      config.max_host_connections = static_cast<size_t>(runtime["maxHostConnections"].get<int64_t>());
+    if (key != last && name == key->name) {
+      key->read(config, it.value());
+      ++key;
     }
   }
 
@@ -126,6 +232,12 @@ RequestConfig getRequestConfig(const Darabonba::Json &runtime) {
     if (runtime.contains("credential")) {
       config.credential = runtime["credential"].get<std::string>();
     }
+    if (runtime.contains("bufferHighWatermark")) {
+      config.buffer_high_watermark = static_cast<size_t>(runtime["bufferHighWatermark"].get<int64_t>());
+    }
+    if (runtime.contains("bufferLowWatermark")) {
+      config.buffer_low_watermark = static_cast<size_t>(runtime["bufferLowWatermark"].get<int64_t>());
+    }
   }
 
   return config;
@@ -192,83 +304,47 @@ Core::doAction(Http::Request &request, const Darabonba::Json &runtime) {
   if (url.getScheme().empty()) {
     url.setScheme("https");
   }
-  std::string hostKey = url.getHost();
+  const std::string &hostKey = url.getHost();
 
   // Extract request-level configuration from runtime (no lock needed)
   RequestConfig request_config = getRequestConfig(runtime);
 
-  // Acquire lock only for client lookup/creation, release before makeRequest
-  std::shared_ptr<Http::MCurlHttpClient> client;
-  {
-    std::lock_guard<std::mutex> lock(state.mutex);
-
-    // Extract connection pool configuration from runtime
-    ConnectionPoolConfig pool_config = getConnectionPoolConfig(request, runtime);
-
-    // Check if we have a client for this host
-    auto it = state.http_clients.find(hostKey);
-    if (it == state.http_clients.end()) {
-      // Create new client for this host
-      auto newClient = std::make_shared<Http::MCurlHttpClient>();
-      // Apply connection pool settings to the client
-      newClient->setConnectionPoolConfig(pool_config);
-      newClient->start();
-      state.http_clients[hostKey] = newClient;
-      client = std::move(newClient);
-    } else {
-      // Update connection pool settings for existing client (thread-safe)
-      it->second->setConnectionPoolConfig(pool_config);
-      client = it->second;
-    }
-  } // lock released here
-
-  // Build request-level runtime options (outside lock)
-  Darabonba::Json request_runtime = Darabonba::Json::object();
-  request_runtime["connectTimeout"] = request_config.connect_timeout_ms;
-  request_runtime["readTimeout"] = request_config.read_timeout_ms;
-  request_runtime["ignoreSSL"] = request_config.ignore_ssl;
-  request_runtime["httpProxy"] = request_config.http_proxy;
-  request_runtime["httpsProxy"] = request_config.https_proxy;
-  request_runtime["noProxy"] = request_config.no_proxy;
+  // Extract connection pool configuration from runtime
+  ConnectionPoolConfig pool_config = getConnectionPoolConfig(runtime);
+
+  // Lock-free lookup, the config is only applied when it has changed
+  std::string key;
+  auto client =
+      state.http_clients.get(clientKey(hostKey, pool_config, key), pool_config);
+  if (!client) {
+    std::promise<std::shared_ptr<Http::MCurlResponse>> promise;
+    promise.set_value(nullptr);
+    return promise.get_future();
+  }
 
   // makeRequest is now called without holding the global lock,
-  // allowing concurrent requests to different hosts
-  return client->makeRequest(request, request_runtime);
+  // allowing concurrent requests to different hosts. The typed overload
+  // skips building and parsing a Json of the request options.
+  return client->makeRequest(request, request_config);
 }
 
 // Function to clear specific client configuration by ConnectionPoolConfig
 void Core::ClearHttpClient(const ConnectionPoolConfig &config) {
-  auto &state = GetSDKState();
-  std::lock_guard<std::mutex> lock(state.mutex);
-
-  auto it = state.http_clients.find(config.host);
-  if (it != state.http_clients.end()) {
-    state.http_clients.erase(it);
-  }
+  std::string key;
+  GetSDKState().http_clients.erase(clientKey(config.host, config, key));
 }
 
 // Function to clear all clients
 void Core::ClearAllHttpClients() {
-  auto &state = GetSDKState();
-  
-  // Move clients out of the map while holding the lock
-  // After move, state.http_clients is guaranteed to be empty (C++11 standard)
-  std::map<std::string, std::shared_ptr<Http::MCurlHttpClient>> clients;
-  {
-    std::lock_guard<std::mutex> lock(state.mutex);
-    clients = std::move(state.http_clients);
-  }
-  // Lock released here - clients will be destroyed outside the lock
-  // Each MCurlHttpClient destructor will call stop() and wait for the
-  // perform thread to finish, ensuring safe shutdown
+  // The clients are destroyed outside the locks of the registry
+  // Each MCurlHttpClient destructor will call stop() and detach its
+  // transfers from the shared reactor
+  GetSDKState().http_clients.clear();
 }
 
 // Function to get client count
 size_t Core::GetHttpClientCount() {
-  auto &state = GetSDKState();
-  std::lock_guard<std::mutex> lock(state.mutex);
-
-  return state.http_clients.size();
+  return GetSDKState().http_clients.size();
 }
 
 bool shouldRetry(const RetryOptions &options, const RetryPolicyContext &ctx) {
@@ -1,9 +1,54 @@
 #include <algorithm>
+#include <cstring>
 #include <darabonba/Exception.hpp>
 #include <darabonba/Stream.hpp>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace Darabonba {
 
+namespace {
+bool seekInput(std::istream &stream, uint64_t offset) {
+  // seekg() fails once the end has been hit
+  stream.clear();
+  auto end = stream.rdbuf()->pubseekoff(0, std::ios_base::end,
+                                        std::ios_base::in);
+  if (end < 0 || offset > static_cast<uint64_t>(end))
+    return false;
+  stream.seekg(static_cast<std::streamoff>(offset));
+  return !stream.fail();
+}
+
+int64_t remainingInput(std::streambuf *buf) {
+  auto cur = buf->pubseekoff(0, std::ios_base::cur, std::ios_base::in);
+  if (cur < 0)
+    return -1;
+  auto end = buf->pubseekoff(0, std::ios_base::end, std::ios_base::in);
+  buf->pubseekpos(cur, std::ios_base::in);
+  if (end < cur)
+    return -1;
+  return static_cast<int64_t>(end - cur);
+}
+
+// The get area of an input stringbuf spans the whole string, the data left to
+// read is [gptr, egptr)
+struct GetArea : std::stringbuf {
+  static const char *next(std::stringbuf *buf) {
+    return (buf->*&GetArea::gptr)();
+  }
+  static const char *end(std::stringbuf *buf) {
+    return (buf->*&GetArea::egptr)();
+  }
+};
+} // namespace
+
 Bytes Stream::readAsBytes(std::shared_ptr<IStream> raw) {
   if (!raw)
     return Bytes();
@@ -71,6 +116,15 @@ std::shared_ptr<IStream> Stream::readFromFilePath(const std::string &path) {
   return std::shared_ptr<IStream>(stream);
 }
 
+std::shared_ptr<IStream> Stream::readFromFileMapped(const std::string &path) {
+  auto stream = std::make_shared<MMapIStream>(path);
+  if (!stream->isOpen()) {
+    throw Darabonba::DaraException("File not found or cannot be mapped: " +
+                                   path);
+  }
+  return stream;
+}
+
 std::shared_ptr<IStream> Stream::readFromBytes(Bytes &raw) {
   std::string s(raw.begin(), raw.end());
   auto p = new ISStream(std::istringstream(std::move(s)));
@@ -90,6 +144,18 @@ void Stream::reset(std::shared_ptr<Stream> raw) {
     fs->seekg(0);
     return;
   }
+  auto is = dynamic_cast<IStream *>(raw.get());
+  if (is) {
+    is->rewind();
+  }
+}
+
+ISStream::ISStream(const ISStream &other)
+    : std::basic_ios<char>(nullptr), std::istringstream() {
+  auto buf = other.std::istringstream::rdbuf();
+  std::istringstream tempStream(
+      std::string(GetArea::next(buf), GetArea::end(buf)));
+  std::istringstream::swap(tempStream);
 }
 
 size_t ISStream::read(char *buffer, size_t expectSize) {
@@ -98,6 +164,19 @@ size_t ISStream::read(char *buffer, size_t expectSize) {
   return std::istringstream::readsome(buffer, expectSize);
 }
 
+bool ISStream::seek(uint64_t offset) {
+  return seekInput(*this, offset);
+}
+
+int64_t ISStream::remainingSize() const {
+  auto buf = std::istringstream::rdbuf();
+  return static_cast<int64_t>(GetArea::end(buf) - GetArea::next(buf));
+}
+
+const char *ISStream::contiguousData() const {
+  return GetArea::next(std::istringstream::rdbuf());
+}
+
 size_t IFStream::read(char *buffer, size_t expectSize) {
   if (std::ifstream::eof() || std::ifstream::bad() || std::ifstream::fail())
     return 0;
@@ -111,9 +190,224 @@ size_t IFStream::read(char *buffer, size_t expectSize) {
   return realSize;
 }
 
+bool IFStream::seek(uint64_t offset) {
+  return isOpen() && seekInput(*this, offset);
+}
+
+int64_t IFStream::remainingSize() const {
+  if (!isOpen())
+    return -1;
+  return remainingInput(std::ifstream::rdbuf());
+}
+
 size_t OSStream::write(char *buffer, size_t expectSize) {
   std::ostringstream::write(buffer, expectSize);
   return expectSize;
 }
 
+MMapIStream::MMapIStream(const std::string &path) {
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING,
+                            FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return;
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size)) {
+    CloseHandle(file);
+    return;
+  }
+  size_ = static_cast<uint64_t>(size.QuadPart);
+  if (size_ > 0) {
+    mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_) {
+      data_ = static_cast<char *>(
+          MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    }
+  }
+  // the mapping keeps the file open
+  CloseHandle(file);
+  if (size_ > 0 && !data_) {
+    unmap();
+    return;
+  }
+#else
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    ::close(fd);
+    return;
+  }
+  size_ = static_cast<uint64_t>(st.st_size);
+  if (size_ > 0) {
+    void *addr = mmap(nullptr, static_cast<size_t>(size_), PROT_READ,
+                      MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+      ::close(fd);
+      return;
+    }
+    data_ = static_cast<char *>(addr);
+    // read ahead aggressively and drop the pages behind the reader early
+    madvise(addr, static_cast<size_t>(size_), MADV_SEQUENTIAL);
+  }
+  // the mapping keeps the file referenced
+  ::close(fd);
+#endif
+  opened_ = true;
+}
+
+MMapIStream::~MMapIStream() { unmap(); }
+
+void MMapIStream::unmap() {
+#ifdef _WIN32
+  if (data_) {
+    UnmapViewOfFile(data_);
+  }
+  if (mapping_) {
+    CloseHandle(mapping_);
+    mapping_ = nullptr;
+  }
+#else
+  if (data_) {
+    munmap(data_, static_cast<size_t>(size_));
+  }
+#endif
+  data_ = nullptr;
+}
+
+bool MMapIStream::seek(uint64_t offset) {
+  if (!opened_ || offset > size_)
+    return false;
+  position_ = offset;
+  return true;
+}
+
+size_t MMapIStream::read(char *buffer, size_t expectSize) {
+  if (position_ >= size_)
+    return 0;
+  auto realSize = static_cast<size_t>(
+      (std::min)(static_cast<uint64_t>(expectSize), size_ - position_));
+  memcpy(buffer, data_ + position_, realSize);
+  position_ += realSize;
+  return realSize;
+}
+
+ChainIStream &ChainIStream::append(std::shared_ptr<IStream> stream) {
+  if (stream) {
+    Part part;
+    part.size = stream->remainingSize();
+    part.stream = std::move(stream);
+    parts_.push_back(std::move(part));
+  }
+  return *this;
+}
+
+ChainIStream &ChainIStream::append(const char *data, size_t size) {
+  if (data && size > 0) {
+    Part part;
+    part.data = data;
+    part.size = static_cast<int64_t>(size);
+    parts_.push_back(std::move(part));
+  }
+  return *this;
+}
+
+ChainIStream &ChainIStream::append(std::string data) {
+  if (!data.empty()) {
+    Part part;
+    part.owned = std::make_shared<std::string>(std::move(data));
+    part.data = part.owned->data();
+    part.size = static_cast<int64_t>(part.owned->size());
+    parts_.push_back(std::move(part));
+  }
+  return *this;
+}
+
+size_t ChainIStream::read(char *buffer, size_t expectSize) {
+  size_t done = 0;
+  while (done < expectSize && index_ < parts_.size()) {
+    auto &part = parts_[index_];
+    size_t n;
+    if (part.stream) {
+      n = part.stream->read(buffer + done, expectSize - done);
+    } else {
+      n = (std::min)(static_cast<size_t>(part.size) - offset_,
+                     expectSize - done);
+      std::memcpy(buffer + done, part.data + offset_, n);
+      offset_ += n;
+    }
+    done += n;
+    if (part.stream ? n == 0 : offset_ == static_cast<size_t>(part.size)) {
+      ++index_;
+      offset_ = 0;
+    }
+  }
+  return done;
+}
+
+bool ChainIStream::isSeekable() const {
+  for (const auto &part : parts_) {
+    if (part.stream && (part.size < 0 || !part.stream->isSeekable()))
+      return false;
+  }
+  return true;
+}
+
+bool ChainIStream::seek(uint64_t offset) {
+  if (!isSeekable())
+    return false;
+  uint64_t total = 0;
+  for (const auto &part : parts_) {
+    total += static_cast<uint64_t>(part.size);
+  }
+  if (offset > total)
+    return false;
+  // the parts after the one sought are read again from their start
+  index_ = parts_.size();
+  offset_ = 0;
+  uint64_t start = 0;
+  for (size_t i = 0; i < parts_.size(); ++i) {
+    auto &part = parts_[i];
+    auto size = static_cast<uint64_t>(part.size);
+    if (index_ == parts_.size() && offset < start + size) {
+      index_ = i;
+      if (part.stream) {
+        if (!part.stream->seek(offset - start))
+          return false;
+      } else {
+        offset_ = static_cast<size_t>(offset - start);
+      }
+    } else if (index_ < i && part.stream && !part.stream->rewind()) {
+      return false;
+    }
+    start += size;
+  }
+  return true;
+}
+
+int64_t ChainIStream::remainingSize() const {
+  int64_t size = 0;
+  for (size_t i = index_; i < parts_.size(); ++i) {
+    const auto &part = parts_[i];
+    if (part.stream) {
+      auto n = part.stream->remainingSize();
+      if (n < 0)
+        return -1;
+      size += n;
+    } else {
+      size += part.size - static_cast<int64_t>(i == index_ ? offset_ : 0);
+    }
+  }
+  return size;
+}
+
+const char *ChainIStream::contiguousData() const {
+  // only when a single memory block is left
+  if (index_ + 1 != parts_.size() || parts_[index_].stream)
+    return nullptr;
+  return parts_[index_].data + offset_;
+}
+
 } // namespace Darabonba
@@ -0,0 +1,100 @@
+#include <darabonba/buffer/SegmentPool.hpp>
+#include <mutex>
+
+namespace Darabonba {
+namespace Buffer {
+
+SegmentPool &SegmentPool::global() {
+  // Never destroyed, buffers owned by static objects may still release their
+  // segments at exit
+  static SegmentPool *pool = new SegmentPool();
+  return *pool;
+}
+
+size_t SegmentPool::segmentSizeFor(size_t expectedSize) {
+  size_t size = MIN_SEGMENT_SIZE;
+  while (size < MAX_SEGMENT_SIZE && size * 16 < expectedSize) {
+    size <<= 1;
+  }
+  return size;
+}
+
+int SegmentPool::classOf(size_t size) {
+  size_t classSize = MIN_SEGMENT_SIZE;
+  for (int i = 0; i < CLASS_COUNT; ++i, classSize <<= 1) {
+    if (size == classSize)
+      return i;
+  }
+  return -1;
+}
+
+char *SegmentPool::acquire(size_t size) {
+  int index = classOf(size);
+  if (index >= 0) {
+    auto &list = lists_[index];
+    char *data = nullptr;
+    {
+      std::lock_guard<Lock::SpinLock> guard(list.lock);
+      if (!list.blocks.empty()) {
+        data = list.blocks.back();
+        list.blocks.pop_back();
+        idleBytes_ -= size;
+        --idleCount_;
+      }
+    }
+    if (data) {
+      ++reuses_;
+      return data;
+    }
+  }
+  ++allocations_;
+  return new char[size];
+}
+
+void SegmentPool::release(char *data, size_t size) {
+  if (data == nullptr)
+    return;
+  int index = classOf(size);
+  if (index >= 0 && idleBytes_.load(std::memory_order_relaxed) + size <=
+                        maxIdleBytes_) {
+    auto &list = lists_[index];
+    {
+      std::lock_guard<Lock::SpinLock> guard(list.lock);
+      list.blocks.push_back(data);
+      idleBytes_ += size;
+      ++idleCount_;
+    }
+    return;
+  }
+  ++frees_;
+  delete[] data;
+}
+
+void SegmentPool::trim() {
+  size_t classSize = MIN_SEGMENT_SIZE;
+  for (int i = 0; i < CLASS_COUNT; ++i, classSize <<= 1) {
+    std::vector<char *> blocks;
+    {
+      std::lock_guard<Lock::SpinLock> guard(lists_[i].lock);
+      blocks.swap(lists_[i].blocks);
+      idleBytes_ -= blocks.size() * classSize;
+      idleCount_ -= blocks.size();
+    }
+    for (auto data : blocks) {
+      delete[] data;
+    }
+  }
+}
+
+SegmentPool::Metrics SegmentPool::getMetrics() const {
+  Metrics metrics;
+  metrics.allocations = allocations_;
+  metrics.reuses = reuses_;
+  metrics.frees = frees_;
+  metrics.idleCount = idleCount_;
+  metrics.idleBytes = idleBytes_;
+  return metrics;
+}
+
+} // namespace Buffer
+} // namespace Darabonba
@@ -0,0 +1,92 @@
+#include <darabonba/http/BufferBudget.hpp>
+#include <darabonba/http/MCurlResponse.hpp>
+#include <algorithm>
+#include <mutex>
+
+namespace Darabonba {
+namespace Http {
+
+std::shared_ptr<BufferBudget> BufferBudget::shared() {
+  static std::shared_ptr<BufferBudget> budget =
+      std::make_shared<BufferBudget>();
+  return budget;
+}
+
+void BufferBudget::setLimit(size_t limit) {
+  limit_ = limit;
+  // a raised limit may leave room for the paused transfers
+  if (parkedSize_ > 0 && !exceeded()) {
+    resumeParked();
+  }
+}
+
+BufferBudget::Metrics BufferBudget::getMetrics() const {
+  Metrics metrics;
+  metrics.current = current_;
+  metrics.peak = peak_;
+  metrics.limit = limit_;
+  metrics.holders = holders_;
+  metrics.pauses = pauses_;
+  return metrics;
+}
+
+void BufferBudget::add(size_t size) {
+  auto current = current_.fetch_add(size) + size;
+  auto peak = peak_.load();
+  while (current > peak && !peak_.compare_exchange_weak(peak, current)) {
+  }
+}
+
+void BufferBudget::sub(size_t size) {
+  auto current = current_.fetch_sub(size) - size;
+  if (parkedSize_.load() == 0)
+    return;
+  auto limit = limit_.load();
+  if (limit == 0 || current <= limit / 4 * 3) {
+    resumeParked();
+  }
+}
+
+bool BufferBudget::shouldPause(size_t held) const {
+  auto limit = limit_.load();
+  auto current = current_.load();
+  if (held == 0 || limit == 0 || current < limit)
+    return false;
+  // past the headroom every body holding data is paused
+  if (current >= limit + limit / 4)
+    return true;
+  // first only the bodies holding at least the average share
+  auto holders = (std::max)(holders_.load(), size_t(1));
+  return held >= current / holders;
+}
+
+void BufferBudget::park(const std::shared_ptr<MCurlResponseBody> &body) {
+  ++pauses_;
+  {
+    std::lock_guard<Lock::SpinLock> guard(parkedLock_);
+    parked_.emplace_back(body);
+    ++parkedSize_;
+  }
+  // the readers may have drained the budget meanwhile
+  if (!exceeded()) {
+    resumeParked();
+  }
+}
+
+void BufferBudget::resumeParked() {
+  std::vector<std::weak_ptr<MCurlResponseBody>> parked;
+  {
+    std::lock_guard<Lock::SpinLock> guard(parkedLock_);
+    parked.swap(parked_);
+    parkedSize_ = 0;
+  }
+  for (auto &weak : parked) {
+    auto body = weak.lock();
+    if (body) {
+      body->resume();
+    }
+  }
+}
+
+} // namespace Http
+} // namespace Darabonba
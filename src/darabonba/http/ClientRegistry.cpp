@@ -0,0 +1,117 @@
+#include <darabonba/http/ClientRegistry.hpp>
+#include <darabonba/http/MCurlHttpClient.hpp>
+#include <thread>
+
+namespace Darabonba {
+namespace Http {
+
+ClientRegistry::ReadGuard::ReadGuard(Shard &shard) : shard_(shard) {
+  for (;;) {
+    auto epoch = shard.epoch.load();
+    shard.readers[epoch & 1].fetch_add(1);
+    if (shard.epoch.load() == epoch) {
+      index_ = epoch & 1;
+      return;
+    }
+    // a writer moved to the next epoch meanwhile, register there
+    shard.readers[epoch & 1].fetch_sub(1);
+  }
+}
+
+std::unique_ptr<const ClientRegistry::Map>
+ClientRegistry::publish(Shard &shard, std::unique_ptr<Map> map) {
+  std::unique_ptr<const Map> old(shard.map.exchange(map.release()));
+  // the new readers see the new map, wait for the ones of the old epoch
+  auto epoch = shard.epoch.fetch_add(1);
+  while (shard.readers[epoch & 1].load() != 0) {
+    std::this_thread::yield();
+  }
+  return old;
+}
+
+ClientRegistry::ClientPtr
+ClientRegistry::get(const std::string &host,
+                    const ConnectionPoolConfig &config) {
+  auto &shard = shardOf(host);
+  {
+    // fast path, the client exists and its config is unchanged
+    ReadGuard guard(shard);
+    auto &map = guard.map();
+    auto it = map.find(host);
+    if (it != map.end() && sameConfig(it->second.config, config)) {
+      return it->second.client;
+    }
+  }
+
+  ClientPtr client;
+  std::unique_ptr<const Map> oldMap;
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    // the writers are serialized, the current map can be read directly
+    auto &map = *shard.map.load();
+    auto it = map.find(host);
+    if (it != map.end() && sameConfig(it->second.config, config)) {
+      // published by another writer meanwhile
+      return it->second.client;
+    }
+
+    ConnectionPoolConfig hostConfig = config;
+    hostConfig.host = host;
+    if (it != map.end()) {
+      client = it->second.client;
+    } else {
+      client = create_(hostConfig);
+      if (!client) {
+        return nullptr;
+      }
+    }
+    configure_(*client, hostConfig);
+
+    std::unique_ptr<Map> newMap(new Map(map));
+    auto &entry = (*newMap)[host];
+    entry.client = client;
+    entry.config = config;
+    entry.config.host.clear();
+    oldMap = publish(shard, std::move(newMap));
+  }
+  return client;
+}
+
+bool ClientRegistry::erase(const std::string &host) {
+  auto &shard = shardOf(host);
+  std::unique_ptr<const Map> oldMap;
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto &map = *shard.map.load();
+    if (map.find(host) == map.end()) {
+      return false;
+    }
+    std::unique_ptr<Map> newMap(new Map(map));
+    newMap->erase(host);
+    oldMap = publish(shard, std::move(newMap));
+  }
+  // the client may be destroyed with oldMap, outside the lock
+  return true;
+}
+
+void ClientRegistry::clear() {
+  for (auto &shard : shards_) {
+    std::unique_ptr<const Map> oldMap;
+    {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      oldMap = publish(shard, std::unique_ptr<Map>(new Map()));
+    }
+  }
+}
+
+size_t ClientRegistry::size() const {
+  size_t count = 0;
+  for (auto &shard : shards_) {
+    ReadGuard guard(shard);
+    count += guard.map().size();
+  }
+  return count;
+}
+
+} // namespace Http
+} // namespace Darabonba
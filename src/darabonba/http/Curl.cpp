@@ -2,6 +2,7 @@
 #include <darabonba/http/Curl.hpp>
 #include <darabonba/http/Form.hpp>
 #include <darabonba/http/URL.hpp>
+#include <cstdio>
 #include <memory>
 
 namespace Darabonba {
@@ -75,6 +76,29 @@ void setCurlRequestBody(CURL *easyHandle,
     curl_easy_setopt(easyHandle, CURLOPT_POST, 1L);
     curl_easy_setopt(easyHandle, CURLOPT_READDATA, body.get());
     curl_easy_setopt(easyHandle, CURLOPT_READFUNCTION, readIStream);
+    if (is->isSeekable()) {
+      curl_easy_setopt(easyHandle, CURLOPT_SEEKDATA, body.get());
+      curl_easy_setopt(easyHandle, CURLOPT_SEEKFUNCTION, seekIStream);
+    }
+    auto size = is->remainingSize();
+    if (size < 0)
+      return;
+    // an exact Content-Length instead of chunked encoding, which also lets
+    // curl send a small body along with the headers without an Expect
+    curl_easy_setopt(easyHandle, CURLOPT_POSTFIELDSIZE_LARGE,
+                     static_cast<curl_off_t>(size));
+    auto data = is->contiguousData();
+    if (data && size > 0) {
+      // sent by curl straight from the memory of the body, which is kept
+      // alive by the CurlStorage of the transfer
+      curl_easy_setopt(easyHandle, CURLOPT_POSTFIELDS, data);
+    }
+#if LIBCURL_VERSION_NUM >= 0x073E00
+    if (size > static_cast<int64_t>(UPLOAD_BUFFER_SIZE)) {
+      curl_easy_setopt(easyHandle, CURLOPT_UPLOAD_BUFFERSIZE,
+                       static_cast<long>(UPLOAD_BUFFER_SIZE));
+    }
+#endif
     return;
   }
 }
@@ -96,6 +120,15 @@ size_t readIStream(char *buffer, size_t size, size_t nitems, void *userdata) {
   return f->read(buffer, size * nitems);
 }
 
+int seekIStream(void *userdata, curl_off_t offset, int origin) {
+  auto f = static_cast<IStream *>(userdata);
+  // curl only seeks from the start of the body
+  if (f == nullptr || origin != SEEK_SET || offset < 0)
+    return CURL_SEEKFUNC_CANTSEEK;
+  return f->seek(static_cast<uint64_t>(offset)) ? CURL_SEEKFUNC_OK
+                                                : CURL_SEEKFUNC_FAIL;
+}
+
 void setCurlProxy(CURL *curl, const std::string &proxy) {
   URL url(proxy);
   std::string out = url.getHost() + ":" + std::to_string(url.getPort());
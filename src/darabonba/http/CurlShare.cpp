@@ -0,0 +1,54 @@
+#include <darabonba/http/CurlShare.hpp>
+
+namespace Darabonba {
+namespace Http {
+
+CurlShare::CurlShare(int data) : share_(curl_share_init()) {
+  if (!share_)
+    return;
+  curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, &CurlShare::lock);
+  curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, &CurlShare::unlock);
+  curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+  if ((data & DNS) &&
+      curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS) ==
+          CURLSHE_OK) {
+    data_ |= DNS;
+  }
+  if ((data & SSL_SESSION) &&
+      curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION) ==
+          CURLSHE_OK) {
+    data_ |= SSL_SESSION;
+  }
+}
+
+CurlShare::~CurlShare() {
+  if (share_) {
+    curl_share_cleanup(share_);
+    share_ = nullptr;
+  }
+}
+
+std::shared_ptr<CurlShare> CurlShare::shared() {
+  static std::shared_ptr<CurlShare> share = std::make_shared<CurlShare>();
+  return share;
+}
+
+void CurlShare::lock(CURL *, curl_lock_data data, curl_lock_access,
+                     void *userptr) {
+  auto self = static_cast<CurlShare *>(userptr);
+  auto index = static_cast<int>(data);
+  if (self && index >= 0 && index < CURL_LOCK_DATA_LAST) {
+    self->mutexes_[index].lock();
+  }
+}
+
+void CurlShare::unlock(CURL *, curl_lock_data data, void *userptr) {
+  auto self = static_cast<CurlShare *>(userptr);
+  auto index = static_cast<int>(data);
+  if (self && index >= 0 && index < CURL_LOCK_DATA_LAST) {
+    self->mutexes_[index].unlock();
+  }
+}
+
+} // namespace Http
+} // namespace Darabonba
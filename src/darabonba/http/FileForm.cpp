@@ -28,5 +28,31 @@ bool isFileFiled(const nlohmann::json &jsonObject) {
   }
   return false;
 }
+
+void FileFormStream::build() {
+  body_ = std::make_shared<ChainIStream>();
+  for (const auto &name : keys_) {
+    const auto &fieldValue = form_[name];
+    auto content = contents_.find(name);
+    std::ostringstream oss;
+    if (content != contents_.end()) {
+      oss << "--" << boundary_ << "\r\n"
+          << "Content-Disposition: form-data; name=\"" << name
+          << "\"; filename=\"" << fieldValue["filename"].get<std::string>()
+          << "\"\r\n"
+          << "Content-Type: " << fieldValue["contentType"].get<std::string>()
+          << "\r\n\r\n";
+      body_->append(oss.str());
+      body_->append(content->second);
+      body_->append("\r\n", 2);
+    } else {
+      oss << "--" << boundary_ << "\r\n"
+          << "Content-Disposition: form-data; name=\"" << name << "\"\r\n\r\n"
+          << fieldValue.dump() << "\r\n";
+      body_->append(oss.str());
+    }
+  }
+  body_->append("--" + boundary_ + "--\r\n");
+}
 } // namespace Http
 } // namespace Darabonba
\ No newline at end of file
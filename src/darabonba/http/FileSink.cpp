@@ -0,0 +1,74 @@
+#include <darabonba/http/FileSink.hpp>
+#include <cerrno>
+#include <fcntl.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace Darabonba {
+namespace Http {
+
+FileSink::FileSink(const std::string &path) : path_(path) {
+#ifdef _WIN32
+  fd_ = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY,
+              _S_IREAD | _S_IWRITE);
+#else
+  fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+#endif
+}
+
+FileSink::~FileSink() { close(); }
+
+size_t FileSink::write(char *buffer, size_t expectSize) {
+  if (fd_ < 0)
+    return 0;
+  size_t done = 0;
+  while (done < expectSize) {
+#ifdef _WIN32
+    auto n = _write(fd_, buffer + done,
+                    static_cast<unsigned int>(expectSize - done));
+#else
+    auto n = ::write(fd_, buffer + done, expectSize - done);
+#endif
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+    done += static_cast<size_t>(n);
+  }
+  written_ += done;
+  return done;
+}
+
+bool FileSink::preallocate(uint64_t size) {
+  if (fd_ < 0)
+    return false;
+#if defined(__linux__) && defined(FALLOC_FL_KEEP_SIZE)
+  if (size == 0)
+    return true;
+  return ::fallocate(fd_, FALLOC_FL_KEEP_SIZE, 0,
+                     static_cast<off_t>(size)) == 0;
+#else
+  (void)size;
+  return true;
+#endif
+}
+
+void FileSink::close() {
+  if (fd_ < 0)
+    return;
+#ifdef _WIN32
+  _close(fd_);
+#else
+  ::close(fd_);
+#endif
+  fd_ = -1;
+}
+
+} // namespace Http
+} // namespace Darabonba
@@ -1,8 +1,20 @@
 #include <darabonba/Exception.hpp>
 #include <darabonba/http/Curl.hpp>
+#include <darabonba/http/FileSink.hpp>
 #include <darabonba/http/MCurlHttpClient.hpp>
 #include <darabonba/http/MCurlResponse.hpp>
+#include <algorithm>
+#include <cstring>
+#include <map>
 #include <mutex>
+#include <tuple>
+
+#ifdef __linux__
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
 
 namespace Darabonba {
 namespace Http {
@@ -10,17 +22,104 @@ namespace Http {
 std::future<std::shared_ptr<MCurlResponse>>
 MCurlHttpClient::makeRequest(const Request &request,
                              const Darabonba::Json &options) {
-  if (!running_ || !mCurl_) {
+  if (options.is_null()) {
+    return doRequest(request, nullptr);
+  }
+  // process the runtime options
+  RequestConfig config;
+  config.ignore_ssl = options.value("ignoreSSL", false);
+  config.connect_timeout_ms = options.value("connectTimeout", 5000L);
+  config.read_timeout_ms = options.value("readTimeout", 10000L);
+  config.http_proxy = options.value("httpProxy", "");
+  config.https_proxy = options.value("httpsProxy", "");
+  config.no_proxy = options.value("noProxy", "");
+  config.buffer_high_watermark =
+      options.value("bufferHighWatermark", config.buffer_high_watermark);
+  config.buffer_low_watermark =
+      options.value("bufferLowWatermark", config.buffer_low_watermark);
+  return doRequest(request, &config);
+}
+
+std::future<std::shared_ptr<MCurlResponse>>
+MCurlHttpClient::makeRequest(const Request &request,
+                             const RequestConfig &config) {
+  return doRequest(request, &config);
+}
+
+std::future<std::shared_ptr<MCurlResponse>>
+MCurlHttpClient::makeRequest(const Request &request,
+                             const RequestConfig &config,
+                             std::shared_ptr<OStream> sink) {
+  return doRequest(request, &config, std::move(sink));
+}
+
+std::future<std::shared_ptr<MCurlResponse>>
+MCurlHttpClient::makeRequest(const Request &request,
+                             const RequestConfig &config,
+                             const std::string &filePath) {
+  auto sink = std::make_shared<FileSink>(filePath);
+  if (!sink->isOpen()) {
     std::promise<std::shared_ptr<MCurlResponse>> promise;
     promise.set_value(nullptr);
     return promise.get_future();
   }
-  auto easyHandle = curl_easy_init();
-  if (!easyHandle) {
+  return doRequest(request, &config, std::move(sink));
+}
+
+void MCurlHttpClient::makeRequest(const Request &request,
+                                  const RequestConfig &config,
+                                  ResponseCallback callback,
+                                  Executor executor) {
+  if (!callback)
+    return;
+  auto curlStorage = prepareRequest(request, &config, nullptr);
+  if (!curlStorage) {
+    if (executor) {
+      executor([callback]() { callback(nullptr, nullptr); });
+    } else {
+      callback(nullptr, nullptr);
+    }
+    return;
+  }
+  curlStorage->callback = std::move(callback);
+  curlStorage->executor = std::move(executor);
+  dispatch(std::move(curlStorage));
+}
+
+std::future<std::shared_ptr<MCurlResponse>>
+MCurlHttpClient::doRequest(const Request &request,
+                           const RequestConfig *requestConfig,
+                           std::shared_ptr<OStream> sink) {
+  auto curlStorage = prepareRequest(request, requestConfig, std::move(sink));
+  if (!curlStorage) {
     std::promise<std::shared_ptr<MCurlResponse>> promise;
     promise.set_value(nullptr);
     return promise.get_future();
   }
+  curlStorage->promise.reset(
+      new std::promise<std::shared_ptr<MCurlResponse>>());
+  auto ret = curlStorage->promise->get_future();
+  dispatch(std::move(curlStorage));
+  return ret;
+}
+
+std::unique_ptr<MCurlHttpClient::CurlStorage>
+MCurlHttpClient::prepareRequest(const Request &request,
+                                const RequestConfig *requestConfig,
+                                std::shared_ptr<OStream> sink) {
+  auto reactor = std::atomic_load(&reactor_);
+  if (!running_ || !reactor)
+    return nullptr;
+  auto easyHandle = acquireEasyHandle();
+  if (!easyHandle)
+    return nullptr;
+
+  auto share = std::atomic_load(&curlShare_);
+  if (share && share->handle()) {
+    curl_easy_setopt(easyHandle, CURLOPT_SHARE, share->handle());
+  } else {
+    share = nullptr;
+  }
 
   // Atomically load config to avoid race condition with setConnectionPoolConfig
   // This ensures we use a consistent snapshot of the configuration
@@ -50,10 +149,21 @@ MCurlHttpClient::makeRequest(const Request &request,
     curl_easy_setopt(easyHandle, CURLOPT_FORBID_REUSE, 1L);
   }
 
-  if (!options.is_null()) {
-    // process the runtime options
+  // Apply the HTTP version, with http2 the handle negotiates h2 with ALPN
+  // and waits for a connection to multiplex on instead of opening a new one.
+  // Otherwise the version is left to the default of libcurl, as before
+  if (config.http2 || config.http2_prior_knowledge) {
+    curl_easy_setopt(easyHandle, CURLOPT_HTTP_VERSION,
+                     config.http2_prior_knowledge
+                         ? CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE
+                         : CURL_HTTP_VERSION_2TLS);
+    curl_easy_setopt(easyHandle, CURLOPT_SSL_ENABLE_ALPN, 1L);
+    curl_easy_setopt(easyHandle, CURLOPT_PIPEWAIT, 1L);
+  }
+
+  if (requestConfig) {
     // ssl
-    if (options.value("ignoreSSL", false)) {
+    if (requestConfig->ignore_ssl) {
       curl_easy_setopt(easyHandle, CURLOPT_SSL_VERIFYPEER, 0L);
       curl_easy_setopt(easyHandle, CURLOPT_SSL_VERIFYHOST, 0L);
     } else {
@@ -62,29 +172,34 @@ MCurlHttpClient::makeRequest(const Request &request,
                        2L); // 2L for full verification
     }
     // timeout
-    auto connectTimeout = options.value("connectTimeout", 5000L);
-    if (connectTimeout > 0) {
-      curl_easy_setopt(easyHandle, CURLOPT_CONNECTTIMEOUT_MS, connectTimeout);
+    if (requestConfig->connect_timeout_ms > 0) {
+      curl_easy_setopt(easyHandle, CURLOPT_CONNECTTIMEOUT_MS,
+                       static_cast<long>(requestConfig->connect_timeout_ms));
+    }
+    if (requestConfig->read_timeout_ms > 0) {
+      curl_easy_setopt(easyHandle, CURLOPT_TIMEOUT_MS,
+                       static_cast<long>(requestConfig->read_timeout_ms));
     }
-    long readTimeout = options.value("readTimeout", 10000L);
-    if (readTimeout > 0) {
-      curl_easy_setopt(easyHandle, CURLOPT_TIMEOUT_MS, readTimeout);
+    if (requestConfig->idle_timeout_ms > 0) {
+      // under one byte per second for the whole period
+      curl_easy_setopt(easyHandle, CURLOPT_LOW_SPEED_LIMIT, 1L);
+      curl_easy_setopt(
+          easyHandle, CURLOPT_LOW_SPEED_TIME,
+          static_cast<long>((requestConfig->idle_timeout_ms + 999) / 1000));
     }
     // set proxy
     // TODO: sock5
-    std::string httpProxy = options.value("httpProxy", "");
-    if (!httpProxy.empty()) {
+    if (!requestConfig->http_proxy.empty()) {
       curl_easy_setopt(easyHandle, CURLOPT_PROXYTYPE, CURLPROXY_HTTP);
-      Curl::setCurlProxy(easyHandle, httpProxy);
+      Curl::setCurlProxy(easyHandle, requestConfig->http_proxy);
     }
-    std::string httpsProxy = options.value("httpsProxy", "");
-    if (!httpsProxy.empty()) {
+    if (!requestConfig->https_proxy.empty()) {
       curl_easy_setopt(easyHandle, CURLOPT_PROXYTYPE, CURLPROXY_HTTPS);
-      Curl::setCurlProxy(easyHandle, httpsProxy);
+      Curl::setCurlProxy(easyHandle, requestConfig->https_proxy);
     }
-    std::string noProxy = options.value("noProxy", "");
-    if (!noProxy.empty()) {
-      curl_easy_setopt(easyHandle, CURLOPT_NOPROXY, noProxy.c_str());
+    if (!requestConfig->no_proxy.empty()) {
+      curl_easy_setopt(easyHandle, CURLOPT_NOPROXY,
+                       requestConfig->no_proxy.c_str());
     }
   }
 
@@ -106,15 +221,24 @@ MCurlHttpClient::makeRequest(const Request &request,
   // init header
   auto curlStorage = std::unique_ptr<CurlStorage>(new CurlStorage{
       easyHandle, Curl::setCurlHeader(easyHandle, request.getHeader()),
-      request.getBody(), std::make_shared<MCurlResponse>(),
-      std::unique_ptr<std::promise<std::shared_ptr<MCurlResponse>>>(
-          new std::promise<std::shared_ptr<MCurlResponse>>())});
+      request.getBody(), std::make_shared<MCurlResponse>(), nullptr, this,
+      std::move(share), nullptr, nullptr, nullptr});
 
   // set response body
   // TODO:: custom response body by user
   auto body = std::make_shared<MCurlResponseBody>();
   body->easyHandle_ = easyHandle;
   body->client_ = this;
+  body->budget_ = std::atomic_load(&bufferBudget_);
+  if (requestConfig) {
+    body->setWatermarks(requestConfig->buffer_high_watermark,
+                        requestConfig->buffer_low_watermark);
+  }
+  if (sink) {
+    // installed before the transfer starts, no data goes through the buffer
+    body->sink_ = std::move(sink);
+    body->hasSink_ = true;
+  }
   auto &resp = curlStorage->resp;
   resp->setBody(body);
 
@@ -127,152 +251,648 @@ MCurlHttpClient::makeRequest(const Request &request,
   // set how to receive response body
   curl_easy_setopt(easyHandle, CURLOPT_WRITEFUNCTION, recvBody);
 
-  auto ret = curlStorage->promise->get_future();
+  return curlStorage;
+}
+
+MCurlHttpClient::CurlStorage::~CurlStorage() {
+  if (isPending()) {
+    complete(nullptr,
+             std::make_exception_ptr(
+                 std::future_error(std::future_errc::broken_promise)));
+  }
+}
+
+void MCurlHttpClient::CurlStorage::complete(
+    std::shared_ptr<MCurlResponse> response, std::exception_ptr error) {
+  if (promise) {
+    if (error) {
+      promise->set_exception(error);
+    } else {
+      promise->set_value(std::move(response));
+    }
+    promise = nullptr;
+    return;
+  }
+  if (!callback)
+    return;
+  auto cb = std::move(callback);
+  callback = nullptr;
+  if (executor) {
+    auto exec = std::move(executor);
+    executor = nullptr;
+    exec([cb, response, error]() { cb(response, error); });
+    return;
+  }
+  // run by the perform loop after the transfers, never from a curl callback
+  // or while the loop still uses the transfer
+  if (loop && loop->post([cb, response, error]() { cb(response, error); }))
+    return;
+  try {
+    cb(std::move(response), error);
+  } catch (...) {
+    // an exception must not unwind through the perform loop
+  }
+}
+
+void MCurlHttpClient::dispatch(std::unique_ptr<CurlStorage> storage) {
+  if (sharedReactor_) {
+    auto configPtr = std::atomic_load(&poolConfig_);
+    size_t limit = configPtr ? configPtr->max_host_connections : 0;
+    if (limit > 0 &&
+        (configPtr->http2 || configPtr->http2_prior_knowledge)) {
+      // every connection carries many streams
+      limit *= (std::max)(configPtr->max_concurrent_streams, size_t(1));
+    }
+    std::lock_guard<Lock::SpinLock> guard(pendingLock_);
+    if (limit > 0 && inflight_ >= limit) {
+      pending_.emplace_back(std::move(storage));
+      ++pendingSize_;
+      return;
+    }
+    ++inflight_;
+  } else {
+    ++inflight_;
+  }
+  submit(std::move(storage));
+}
+
+void MCurlHttpClient::submit(std::unique_ptr<CurlStorage> storage) {
+  auto reactor = std::atomic_load(&reactor_);
+  auto loopIndex = reactor->selectLoop();
+  auto body = storage->resp->getBody();
+  if (body) {
+    std::lock_guard<Lock::SpinLock> guard(body->handleLock_);
+    body->loopIndex_ = loopIndex;
+  }
+  reactor->loops_[loopIndex]->submit(std::move(storage));
+}
+
+void MCurlHttpClient::onTransferDone() {
+  std::unique_ptr<CurlStorage> next;
   {
-    std::lock_guard<Lock::SpinLock> guard(reqLock_);
-    reqQueue_.emplace_back(std::move(curlStorage));
-    ++reqQueueSize_;
+    std::lock_guard<Lock::SpinLock> guard(pendingLock_);
+    if (!pending_.empty() && running_) {
+      // hand the slot of the finished transfer to the next pending one
+      next = std::move(pending_.front());
+      pending_.pop_front();
+      --pendingSize_;
+    } else {
+      --inflight_;
+    }
+  }
+  if (next) {
+    submit(std::move(next));
+  }
+}
+
+MCurlHttpClient::Reactor::Reactor(size_t loopCount,
+                                  const ConnectionPoolConfig &config)
+    : poolConfig_(std::make_shared<ConnectionPoolConfig>(config)) {
+  loopCount = (std::max)(loopCount, size_t(1));
+  for (size_t i = 0; i < loopCount; ++i) {
+    std::unique_ptr<PerformLoop> loop(new PerformLoop(this));
+    if (!loop->valid()) {
+      loops_.clear();
+      return;
+    }
+    loops_.emplace_back(std::move(loop));
   }
-  // wake the curl_multi_poll
-  curl_multi_wakeup(mCurl_);
-  return ret;
 }
 
-void MCurlHttpClient::perform() {
+MCurlHttpClient::Reactor::~Reactor() {
+  stop();
+  loops_.clear();
+}
+
+std::shared_ptr<MCurlHttpClient::Reactor>
+MCurlHttpClient::Reactor::shared(size_t loopCount, bool eventDriven,
+                                 bool http2) {
+  if (loopCount == 0) {
+    loopCount = std::thread::hardware_concurrency();
+    loopCount = (std::min)((std::max)(loopCount, size_t(1)),
+                           size_t(MAX_SHARED_LOOPS));
+  }
+  static std::mutex mutex;
+  static std::map<std::tuple<size_t, bool, bool>, std::shared_ptr<Reactor>>
+      reactors;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto &reactor = reactors[std::make_tuple(loopCount, eventDriven, http2)];
+  if (!reactor) {
+    // The limits of each host are enforced by the clients.
+    ConnectionPoolConfig config;
+    config.max_connections = 0;
+    config.max_host_connections = 0;
+    // CURLPIPE_MULTIPLEX would let the transfers without http2 negotiate h2
+    // too and turn max_host_connections into a limit of streams, they are
+    // kept on a reactor of their own
+    config.http2 = http2;
+    config.event_driven = eventDriven;
+    reactor = std::make_shared<Reactor>(loopCount, config);
+    reactor->start();
+  }
+  return reactor;
+}
+
+void MCurlHttpClient::Reactor::raiseMaxConcurrentStreams(size_t streams) {
+  auto current = std::atomic_load(&poolConfig_);
+  for (;;) {
+    if (current && current->max_concurrent_streams >= streams)
+      return;
+    auto config = std::make_shared<ConnectionPoolConfig>(
+        current ? *current : ConnectionPoolConfig());
+    config->max_concurrent_streams = streams;
+    if (std::atomic_compare_exchange_weak(&poolConfig_, &current, config)) {
+      ++configVersion_;
+      return;
+    }
+  }
+}
+
+bool MCurlHttpClient::Reactor::start() {
+  if (running_ || loops_.empty())
+    return false;
+  for (auto &loop : loops_) {
+    loop->start();
+  }
+  running_ = true;
+  return true;
+}
+
+bool MCurlHttpClient::Reactor::stop() {
+  if (!running_)
+    return false;
+  running_ = false;
+  for (auto &loop : loops_) {
+    loop->stop();
+  }
+  return true;
+}
+
+size_t MCurlHttpClient::Reactor::selectLoop() {
+  auto n = loops_.size();
+  if (n == 1)
+    return 0;
+  // Start from a rotating offset so that loops with the same load are used
+  // in turn instead of always picking the first one.
+  auto start = nextLoop_.fetch_add(1) % n;
+  auto best = start;
+  auto bestLoad = loops_[start]->getOutstanding();
+  for (size_t i = 1; i < n && bestLoad > 0; ++i) {
+    auto idx = (start + i) % n;
+    auto load = loops_[idx]->getOutstanding();
+    if (load < bestLoad) {
+      best = idx;
+      bestLoad = load;
+    }
+  }
+  return best;
+}
+
+size_t MCurlHttpClient::Reactor::getOutstandingCount() const {
+  size_t count = 0;
+  for (const auto &loop : loops_) {
+    count += loop->getOutstanding();
+  }
+  return count;
+}
+
+bool MCurlHttpClient::Reactor::isEventDriven() const {
+  if (loops_.empty())
+    return false;
+  for (const auto &loop : loops_) {
+    if (!loop->isEventDriven())
+      return false;
+  }
+  return true;
+}
+
+MCurlHttpClient::PerformLoop::~PerformLoop() {
+  stop();
+  if (performThread_.joinable()) {
+    performThread_.join();
+  }
+  clearQueue();
+  curl_multi_cleanup(mCurl_);
+  mCurl_ = nullptr;
+  // after curl_multi_cleanup, which may still report removed sockets
+  closeEventEngine();
+}
+
+void MCurlHttpClient::PerformLoop::submit(
+    std::unique_ptr<CurlStorage> storage) {
+  ++outstanding_;
+  reqQueue_.push(std::move(storage));
+  wakeup();
+}
+
+void MCurlHttpClient::PerformLoop::detach(MCurlHttpClient *client) {
+  if (std::this_thread::get_id() == performThread_.get_id()) {
+    removeTransfers(client);
+    return;
+  }
+  std::unique_lock<std::mutex> lock(detachMutex_);
+  if (!stop_) {
+    detachQueue_.emplace_back(client);
+    ++detachQueueSize_;
+    wakeup();
+    detachCV_.wait(lock, [this, client]() {
+      return stop_ || std::find(detachQueue_.begin(), detachQueue_.end(),
+                                client) == detachQueue_.end();
+    });
+  }
+  if (stop_) {
+    // no perform thread consumes the queues, do it under detachMutex_
+    removeTransfers(client);
+  }
+}
+
+void MCurlHttpClient::PerformLoop::removeTransfers(MCurlHttpClient *client) {
+  // move the queued transfers to mCurl_ first, so that only runningCurl_
+  // has to be searched
+  addQueuedTransfers();
+  for (auto it = runningCurl_.begin(); it != runningCurl_.end();) {
+    if (it->second && it->second->client == client) {
+      curl_slist_free_all(it->second->reqHeader);
+      if (auto body = it->second->resp->getBody())
+        body->detach();
+      curl_multi_remove_handle(mCurl_, it->first);
+      curl_easy_cleanup(it->first);
+      it = runningCurl_.erase(it);
+      --outstanding_;
+    } else {
+      ++it;
+    }
+  }
+}
+
+void MCurlHttpClient::PerformLoop::perform() {
   while (running_) {
     // Apply config update if needed (before curl_multi_perform)
-    if (configNeedsUpdate_.load()) {
+    auto configVersion = reactor_->configVersion_.load();
+    if (configVersion != appliedConfigVersion_) {
       applyConnectionPoolSettings();
-      configNeedsUpdate_.store(false);
+      appliedConfigVersion_ = configVersion;
     }
 
-    if (reqQueueSize_) {
-      decltype(reqQueue_) reqQueue;
-      {
-        std::lock_guard<Lock::SpinLock> guard(reqLock_);
-        reqQueue = std::move(reqQueue_);
-        reqQueueSize_ = 0;
-      }
-      while (!reqQueue.empty()) {
-        auto storage = std::move(reqQueue.front());
-        reqQueue.pop_front();
-        // add the easy_curl to multi_curl
-        curl_multi_add_handle(mCurl_, storage->easyHandle);
-        runningCurl_[storage->easyHandle] = std::move(storage);
+    // resumed before the new transfers are added, a request queued for a
+    // finished transfer must not reach the next user of its easy handle
+    CURL *easyHandle = nullptr;
+    bool resumed = false;
+    while (continueReadingQueue_.pop(easyHandle)) {
+      if (runningCurl_.count(easyHandle)) {
+        // set continue reading
+        curl_easy_pause(easyHandle, CURLPAUSE_CONT);
+        resumed = true;
       }
     }
-    if (continueReadingQueueSize_) {
-      decltype(continueReadingQueue_) continueReadingQueue;
-      {
-        std::lock_guard<Lock::SpinLock> guard(continueReadingLock_);
-        continueReadingQueue = std::move(continueReadingQueue_);
-        continueReadingQueueSize_ = 0;
-      }
-      for (auto easyHandle : continueReadingQueue) {
-        if (runningCurl_.count(easyHandle)) {
-          // set continue reading
-          curl_easy_pause(easyHandle, CURLPAUSE_CONT);
-        }
+    addQueuedTransfers();
+    if (detachQueueSize_) {
+      std::lock_guard<std::mutex> guard(detachMutex_);
+      for (auto client : detachQueue_) {
+        removeTransfers(client);
       }
+      detachQueue_.clear();
+      detachQueueSize_ = 0;
+      detachCV_.notify_all();
     }
-    auto code = curl_multi_poll(mCurl_, nullptr, 0, WAIT_MS, nullptr);
-    if (code != CURLM_OK) {
-      // TODO:: handle error
-      continue;
+    if (resumed && eventDriven_) {
+      // curl_easy_pause does not report its expire timer to the timer
+      // callback, the resumed transfers are run by a timeout action
+      timerArmed_ = true;
+      timerDeadline_ = std::chrono::steady_clock::now();
+    }
+    if (eventDriven_) {
+      socketActionOnce();
+    } else {
+      pollOnce();
     }
-    int running_handles;
-    curl_multi_perform(mCurl_, &running_handles);
+    processMessages();
+    runTasks();
+  }
+  // close the existing network connections.
+  for (auto &p : runningCurl_) {
+    if (p.second) {
+      curl_slist_free_all(p.second->reqHeader);
+      if (auto body = p.second->resp->getBody())
+        body->detach();
+    }
+    curl_multi_remove_handle(mCurl_, p.first);
+    curl_easy_cleanup(p.first);
+  }
+  outstanding_ -= runningCurl_.size();
+  runningCurl_.clear();
+  runTasks();
+  {
+    // release the clients waiting in detach(), they consume the queues
+    // themselves from now on
+    std::lock_guard<std::mutex> guard(detachMutex_);
+    detachQueue_.clear();
+    detachQueueSize_ = 0;
+    stop_ = true;
+  }
+  detachCV_.notify_all();
+  stopCV_.notify_all();
+}
 
-    int msgs_in_queue = 0;
-    CURLMsg *msg = nullptr;
+void MCurlHttpClient::PerformLoop::pollOnce() {
+  auto code = curl_multi_poll(mCurl_, nullptr, 0, WAIT_MS, nullptr);
+  if (code != CURLM_OK) {
+    // TODO:: handle error
+    return;
+  }
+  int running_handles;
+  curl_multi_perform(mCurl_, &running_handles);
+}
 
-    while ((msg = curl_multi_info_read(mCurl_, &msgs_in_queue)) != nullptr) {
-      if (msg->msg == CURLMSG_DONE) {
-        auto easyHandle = msg->easy_handle;
+void MCurlHttpClient::PerformLoop::processMessages() {
+  int msgs_in_queue = 0;
+  CURLMsg *msg = nullptr;
 
-        // Safe lookup - don't use operator[] which creates nullptr entries
-        auto it = runningCurl_.find(easyHandle);
-        if (it == runningCurl_.end()) {
-          // Handle not found - clean up and skip
-          curl_multi_remove_handle(mCurl_, easyHandle);
-          curl_easy_cleanup(easyHandle);
-          continue;
-        }
-        auto curlStorage = std::move(it->second);
-        runningCurl_.erase(it);
-
-        // Null check - but we still need to set done_ and notify even if promise is null
-        if (!curlStorage) {
-          curl_multi_remove_handle(mCurl_, easyHandle);
-          curl_easy_cleanup(easyHandle);
-          continue;
-        }
+  while ((msg = curl_multi_info_read(mCurl_, &msgs_in_queue)) != nullptr) {
+    if (msg->msg == CURLMSG_DONE) {
+      auto easyHandle = msg->easy_handle;
 
-        CURLcode curlResult = msg->data.result;
-        if (curlResult != CURLE_OK) {
-          if (curlStorage->promise) {
-            curlStorage->promise->set_exception(
-                std::make_exception_ptr(Darabonba::ResponseException(
-                    "NetworkError",
-                    std::string("Curl error: ") + curl_easy_strerror(curlResult))));
+      // Safe lookup - don't use operator[] which creates nullptr entries
+      auto it = runningCurl_.find(easyHandle);
+      if (it == runningCurl_.end()) {
+        // Handle not found - clean up and skip
+        curl_multi_remove_handle(mCurl_, easyHandle);
+        curl_easy_cleanup(easyHandle);
+        continue;
+      }
+      auto curlStorage = std::move(it->second);
+      runningCurl_.erase(it);
+      --outstanding_;
+
+      // Null check - but we still need to set done_ and notify even if promise is null
+      if (!curlStorage) {
+        curl_multi_remove_handle(mCurl_, easyHandle);
+        curl_easy_cleanup(easyHandle);
+        continue;
+      }
+      long connects = 0;
+      curl_easy_getinfo(easyHandle, CURLINFO_NUM_CONNECTS, &connects);
+      curlStorage->client->connectCount_ += static_cast<uint64_t>(connects);
+      // Release the slot before the waiters are notified
+      curlStorage->client->onTransferDone();
+
+      CURLcode curlResult = msg->data.result;
+      if (curlResult != CURLE_OK) {
+        if (!curlStorage->isPending()) {
+          // the response was already handed out, end its body so that the
+          // reader does not wait for data which will never come
+          if (auto body = curlStorage->resp->getBody())
+            body->detach();
+        }
+      } else {
+        auto body = dynamic_cast<MCurlResponseBody *>(
+            curlStorage->resp->getBody().get());
+        if (body) {
+          if (!body->getReady()) {
+            setResponseReady(curlStorage.get());
           }
+          body->finish();
         } else {
-          auto body = dynamic_cast<MCurlResponseBody *>(
-              curlStorage->resp->getBody().get());
-          if (body) {
-            if (!body->getReady()) {
-              setResponseReady(curlStorage.get());
-            }
-            body->done_ = true;
-            body->streamCV_.notify_one();
-            body->doneCV_.notify_one();
-          } else {
-            // This should never happen - log as error if DEBUG is enabled
-            if (nullptr != getenv("DEBUG")) {
-              std::cerr << "[ERROR perform] Response body is null!" << std::endl;
-            }
+          // This should never happen - log as error if DEBUG is enabled
+          if (nullptr != getenv("DEBUG")) {
+            std::cerr << "[ERROR perform] Response body is null!" << std::endl;
           }
         }
+      }
 
-        if (curlStorage->reqBody) {
-          curlStorage->reqBody.reset();
-        }
-        curl_multi_remove_handle(mCurl_, easyHandle);
-        curl_easy_cleanup(easyHandle);
-      } else {
-        // TODO: handle other case
+      if (curlStorage->reqBody) {
+        curlStorage->reqBody.reset();
       }
+      // done with the handle and the client before the request completes,
+      // its callback may release the client
+      curl_multi_remove_handle(mCurl_, easyHandle);
+      curlStorage->client->releaseEasyHandle(easyHandle);
+      curlStorage->easyHandle = nullptr;
+      if (curlResult != CURLE_OK && curlStorage->isPending()) {
+        curlStorage->complete(
+            nullptr,
+            std::make_exception_ptr(Darabonba::ResponseException(
+                "NetworkError",
+                std::string("Curl error: ") + curl_easy_strerror(curlResult))));
+      }
+    } else {
+      // TODO: handle other case
     }
   }
-  // close the existing network connections.
-  for (auto &p : runningCurl_) {
-    if (p.second) {
-      curl_slist_free_all(p.second->reqHeader);
+}
+
+void MCurlHttpClient::PerformLoop::wakeup() {
+#ifdef __linux__
+  if (eventDriven_) {
+    uint64_t one = 1;
+    // the counter only has to become non-zero, a failed write means it
+    // already is
+    ssize_t ret = write(wakeFd_, &one, sizeof(one));
+    (void)ret;
+    return;
+  }
+#endif
+  // wake the curl_multi_poll
+  curl_multi_wakeup(mCurl_);
+}
+
+bool MCurlHttpClient::PerformLoop::openEventEngine() {
+#ifdef __linux__
+  epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+  wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (epollFd_ < 0 || wakeFd_ < 0) {
+    closeEventEngine();
+    return false;
+  }
+  epoll_event event;
+  std::memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN;
+  event.data.fd = wakeFd_;
+  if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &event) != 0) {
+    closeEventEngine();
+    return false;
+  }
+  curl_multi_setopt(mCurl_, CURLMOPT_SOCKETFUNCTION,
+                    &PerformLoop::socketCallback);
+  curl_multi_setopt(mCurl_, CURLMOPT_SOCKETDATA, this);
+  curl_multi_setopt(mCurl_, CURLMOPT_TIMERFUNCTION,
+                    &PerformLoop::timerCallback);
+  curl_multi_setopt(mCurl_, CURLMOPT_TIMERDATA, this);
+  timerArmed_ = false;
+  return true;
+#else
+  return false;
+#endif
+}
+
+void MCurlHttpClient::PerformLoop::closeEventEngine() {
+#ifdef __linux__
+  if (mCurl_) {
+    curl_multi_setopt(mCurl_, CURLMOPT_SOCKETFUNCTION, nullptr);
+    curl_multi_setopt(mCurl_, CURLMOPT_SOCKETDATA, nullptr);
+    curl_multi_setopt(mCurl_, CURLMOPT_TIMERFUNCTION, nullptr);
+    curl_multi_setopt(mCurl_, CURLMOPT_TIMERDATA, nullptr);
+  }
+  if (wakeFd_ >= 0) {
+    close(wakeFd_);
+    wakeFd_ = -1;
+  }
+  if (epollFd_ >= 0) {
+    close(epollFd_);
+    epollFd_ = -1;
+  }
+#endif
+  eventDriven_ = false;
+  timerArmed_ = false;
+}
+
+void MCurlHttpClient::PerformLoop::socketActionOnce() {
+#ifdef __linux__
+  using std::chrono::steady_clock;
+  int waitMs = WAIT_MS;
+  if (timerArmed_) {
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    timerDeadline_ - steady_clock::now())
+                    .count();
+    waitMs = static_cast<int>(
+        (std::max)((std::min)(left, static_cast<decltype(left)>(WAIT_MS)),
+                   static_cast<decltype(left)>(0)));
+  }
+
+  epoll_event events[MAX_EVENTS];
+  int count = epoll_wait(epollFd_, events, MAX_EVENTS, waitMs);
+  int runningHandles = 0;
+  for (int i = 0; i < count; ++i) {
+    int fd = events[i].data.fd;
+    if (fd == wakeFd_) {
+      uint64_t value;
+      ssize_t ret = read(wakeFd_, &value, sizeof(value));
+      (void)ret;
+      continue;
     }
-    curl_multi_remove_handle(mCurl_, p.first);
-    curl_easy_cleanup(p.first);
+    int flags = 0;
+    if (events[i].events & EPOLLIN)
+      flags |= CURL_CSELECT_IN;
+    if (events[i].events & EPOLLOUT)
+      flags |= CURL_CSELECT_OUT;
+    if (events[i].events & (EPOLLERR | EPOLLHUP))
+      flags |= CURL_CSELECT_ERR;
+    curl_multi_socket_action(mCurl_, fd, flags, &runningHandles);
   }
-  runningCurl_.clear();
-  stop_ = true;
-  stopCV_.notify_all();
+  // the timer may expire while other sockets keep the loop busy
+  if (timerArmed_ && steady_clock::now() >= timerDeadline_) {
+    timerArmed_ = false;
+    curl_multi_socket_action(mCurl_, CURL_SOCKET_TIMEOUT, 0, &runningHandles);
+  }
+#else
+  pollOnce();
+#endif
+}
+
+int MCurlHttpClient::PerformLoop::socketCallback(CURL *easyHandle,
+                                                 curl_socket_t socket,
+                                                 int what, void *userp,
+                                                 void *socketp) {
+  (void)easyHandle;
+  (void)socketp;
+#ifdef __linux__
+  auto loop = static_cast<PerformLoop *>(userp);
+  if (!loop || loop->epollFd_ < 0)
+    return 0;
+  if (what == CURL_POLL_REMOVE) {
+    epoll_ctl(loop->epollFd_, EPOLL_CTL_DEL, socket, nullptr);
+    return 0;
+  }
+  epoll_event event;
+  std::memset(&event, 0, sizeof(event));
+  if (what & CURL_POLL_IN)
+    event.events |= EPOLLIN;
+  if (what & CURL_POLL_OUT)
+    event.events |= EPOLLOUT;
+  event.data.fd = socket;
+  if (epoll_ctl(loop->epollFd_, EPOLL_CTL_MOD, socket, &event) != 0 &&
+      errno == ENOENT) {
+    epoll_ctl(loop->epollFd_, EPOLL_CTL_ADD, socket, &event);
+  }
+#else
+  (void)socket;
+  (void)what;
+  (void)userp;
+#endif
+  return 0;
+}
+
+int MCurlHttpClient::PerformLoop::timerCallback(CURLM *multi, long timeoutMs,
+                                                void *userp) {
+  (void)multi;
+  auto loop = static_cast<PerformLoop *>(userp);
+  if (!loop)
+    return 0;
+  if (timeoutMs < 0) {
+    loop->timerArmed_ = false;
+  } else {
+    loop->timerArmed_ = true;
+    loop->timerDeadline_ =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+  }
+  return 0;
 }
 
 bool MCurlHttpClient::start() {
+  if (running_)
+    return false;
+  auto reactor = std::atomic_load(&reactor_);
+  if (!reactor) {
+    auto configPtr = std::atomic_load(&poolConfig_);
+    auto config = configPtr ? *configPtr : ConnectionPoolConfig();
+    reactor = std::make_shared<Reactor>(config.io_threads, config);
+    if (reactor->getLoopCount() == 0)
+      return false;
+    std::atomic_store(&reactor_, reactor);
+  }
+  if (!sharedReactor_) {
+    reactor->start();
+  } else if (!reactor->isRunning()) {
+    return false;
+  }
+  running_ = true;
+  return true;
+}
+
+bool MCurlHttpClient::PerformLoop::start() {
   if (!mCurl_ || running_)
     return false;
+  if (performThread_.joinable()) {
+    // the thread of the previous start() has already finished
+    performThread_.join();
+  }
   // Apply connection pool settings before starting
+  appliedConfigVersion_ = reactor_->configVersion_.load();
   applyConnectionPoolSettings();
+  // Pick the engine, the loop keeps it until the next start()
+  auto configPtr = std::atomic_load(&reactor_->poolConfig_);
+  bool eventDriven = configPtr && configPtr->event_driven;
+  if (eventDriven && epollFd_ < 0) {
+    eventDriven = openEventEngine();
+  } else if (!eventDriven && epollFd_ >= 0) {
+    closeEventEngine();
+  }
+  eventDriven_ = eventDriven;
+  {
+    std::lock_guard<std::mutex> guard(detachMutex_);
+    stop_ = false;
+  }
   running_ = true;
-  performThread_ = std::thread(std::bind(&MCurlHttpClient::perform, this));
+  performThread_ = std::thread(std::bind(&PerformLoop::perform, this));
   return true;
 }
 
-void MCurlHttpClient::applyConnectionPoolSettings() {
+void MCurlHttpClient::PerformLoop::applyConnectionPoolSettings() {
   if (!mCurl_)
     return;
 
   // Atomically load config for thread-safe access
-  auto configPtr = std::atomic_load(&poolConfig_);
+  auto configPtr = std::atomic_load(&reactor_->poolConfig_);
   if (!configPtr)
     return;
 
@@ -286,16 +906,109 @@ void MCurlHttpClient::applyConnectionPoolSettings() {
   curl_multi_setopt(mCurl_, CURLMOPT_MAX_HOST_CONNECTIONS,
                     static_cast<long>(config.max_host_connections));
 
-  // Enable/disable pipelining
-  curl_multi_setopt(mCurl_, CURLMOPT_PIPELINING,
-                    config.pipelining ? 1L : 0L);
+  // Enable/disable pipelining, HTTP/2 needs CURLPIPE_MULTIPLEX to run many
+  // streams over one connection
+  long pipelining = config.pipelining ? CURLPIPE_HTTP1 : CURLPIPE_NOTHING;
+  if (config.http2 || config.http2_prior_knowledge) {
+    pipelining |= CURLPIPE_MULTIPLEX;
+  }
+  curl_multi_setopt(mCurl_, CURLMOPT_PIPELINING, pipelining);
+
+  // Set maximum streams per HTTP/2 connection (curl 7.67.0+)
+#if LIBCURL_VERSION_NUM >= 0x074300
+  if (config.max_concurrent_streams > 0) {
+    curl_multi_setopt(mCurl_, CURLMOPT_MAX_CONCURRENT_STREAMS,
+                      static_cast<long>(config.max_concurrent_streams));
+  }
+#endif
 }
 
 bool MCurlHttpClient::stop() {
   if (!running_)
     return false;
   running_ = false;
-  curl_multi_wakeup(mCurl_);
+  auto reactor = std::atomic_load(&reactor_);
+  if (sharedReactor_) {
+    for (auto &loop : reactor->loops_) {
+      loop->detach(this);
+    }
+  } else {
+    reactor->stop();
+  }
+  // drop the transfers which never got a free slot
+  std::lock_guard<Lock::SpinLock> guard(pendingLock_);
+  for (auto &storage : pending_) {
+    curl_slist_free_all(storage->reqHeader);
+    curl_easy_cleanup(storage->easyHandle);
+  }
+  pending_.clear();
+  pendingSize_ = 0;
+  inflight_ = 0;
+  clearEasyHandlePool();
+  return true;
+}
+
+CURL *MCurlHttpClient::acquireEasyHandle() {
+  {
+    std::lock_guard<Lock::SpinLock> guard(handlePoolLock_);
+    if (!handlePool_.empty()) {
+      auto easyHandle = handlePool_.back();
+      handlePool_.pop_back();
+      ++handlePoolHits_;
+      return easyHandle;
+    }
+  }
+  ++handlePoolMisses_;
+  return curl_easy_init();
+}
+
+void MCurlHttpClient::releaseEasyHandle(CURL *easyHandle) {
+  auto configPtr = std::atomic_load(&poolConfig_);
+  size_t capacity = configPtr ? configPtr->easy_handle_pool_size : 0;
+  if (running_ && capacity > 0) {
+    // the share may be released with the finished request
+    curl_easy_setopt(easyHandle, CURLOPT_SHARE, nullptr);
+    // drop the options of the finished request, the caches are kept
+    curl_easy_reset(easyHandle);
+    std::lock_guard<Lock::SpinLock> guard(handlePoolLock_);
+    if (handlePool_.size() < capacity) {
+      handlePool_.emplace_back(easyHandle);
+      return;
+    }
+  }
+  curl_easy_cleanup(easyHandle);
+}
+
+void MCurlHttpClient::clearEasyHandlePool() {
+  std::vector<CURL *> handles;
+  {
+    std::lock_guard<Lock::SpinLock> guard(handlePoolLock_);
+    handles.swap(handlePool_);
+  }
+  for (auto easyHandle : handles) {
+    curl_easy_cleanup(easyHandle);
+  }
+}
+
+MCurlHttpClient::EasyHandlePoolMetrics
+MCurlHttpClient::getEasyHandlePoolMetrics() const {
+  EasyHandlePoolMetrics metrics;
+  {
+    std::lock_guard<Lock::SpinLock> guard(handlePoolLock_);
+    metrics.size = handlePool_.size();
+  }
+  auto configPtr = std::atomic_load(&poolConfig_);
+  metrics.capacity = configPtr ? configPtr->easy_handle_pool_size : 0;
+  metrics.hits = handlePoolHits_;
+  metrics.misses = handlePoolMisses_;
+  return metrics;
+}
+
+bool MCurlHttpClient::PerformLoop::stop() {
+  if (!running_)
+    return false;
+  running_ = false;
+  wakeup();
   std::unique_lock<std::mutex> lock(stopMutex_);
 #ifdef _WIN32
   // Windows: Use timeout to prevent deadlock during DLL unload
@@ -306,30 +1019,91 @@ bool MCurlHttpClient::stop() {
   return true;
 }
 
-void MCurlHttpClient::clearQueue() {
-  std::lock_guard<Lock::SpinLock> guard1(reqLock_);
-  std::lock_guard<Lock::SpinLock> guard2(continueReadingLock_);
-  while (!reqQueue_.empty()) {
-    auto storage = std::move(reqQueue_.front());
-    reqQueue_.pop_front();
+void MCurlHttpClient::PerformLoop::addQueuedTransfers() {
+  std::unique_ptr<CurlStorage> storage;
+  while (reqQueue_.pop(storage)) {
+    // add the easy_curl to multi_curl
+    curl_multi_add_handle(mCurl_, storage->easyHandle);
+    storage->loop = this;
+    runningCurl_[storage->easyHandle] = std::move(storage);
+  }
+}
+
+void MCurlHttpClient::PerformLoop::clearQueue() {
+  std::unique_ptr<CurlStorage> storage;
+  while (reqQueue_.pop(storage)) {
     if (storage) {
       curl_slist_free_all(storage->reqHeader);
       curl_easy_cleanup(storage->easyHandle);
     }
+    --outstanding_;
+  }
+  // the transfers moved to mCurl_ by a detach() after the loop exited
+  for (auto &p : runningCurl_) {
+    if (p.second) {
+      curl_slist_free_all(p.second->reqHeader);
+      if (auto body = p.second->resp->getBody())
+        body->detach();
+    }
+    curl_multi_remove_handle(mCurl_, p.first);
+    curl_easy_cleanup(p.first);
+  }
+  outstanding_ -= runningCurl_.size();
+  runningCurl_.clear();
+  CURL *easyHandle = nullptr;
+  while (continueReadingQueue_.pop(easyHandle)) {
   }
-  reqQueue_.clear();
-  continueReadingQueue_.clear();
+  // the tasks posted while the loop was stopping
+  runTasks();
 }
 
-bool MCurlHttpClient::addContinueReadingHandle(CURL *easyHandle) {
-  if (!running_ || !mCurl_ || !easyHandle)
+bool MCurlHttpClient::PerformLoop::post(std::function<void()> task) {
+  if (!running_ || !task)
     return false;
-  {
-    std::lock_guard<Lock::SpinLock> guard(continueReadingLock_);
-    continueReadingQueue_.emplace_back(easyHandle);
-    ++continueReadingQueueSize_;
+  taskQueue_.push(std::move(task));
+  wakeup();
+  return true;
+}
+
+void MCurlHttpClient::PerformLoop::runTasks() {
+  std::function<void()> task;
+  while (taskQueue_.pop(task)) {
+    try {
+      task();
+    } catch (...) {
+      // an exception must not unwind through the perform loop
+    }
   }
-  curl_multi_wakeup(mCurl_);
+}
+
+bool MCurlHttpClient::post(std::function<void()> task) {
+  auto reactor = std::atomic_load(&reactor_);
+  if (!running_ || !reactor || reactor->loops_.empty())
+    return false;
+  return reactor->loops_[reactor->selectLoop()]->post(std::move(task));
+}
+
+bool MCurlHttpClient::post(size_t loopIndex, std::function<void()> task) {
+  auto reactor = std::atomic_load(&reactor_);
+  if (!running_ || !reactor || loopIndex >= reactor->loops_.size())
+    return false;
+  return reactor->loops_[loopIndex]->post(std::move(task));
+}
+
+bool MCurlHttpClient::addContinueReadingHandle(CURL *easyHandle,
+                                               size_t loopIndex) {
+  auto reactor = std::atomic_load(&reactor_);
+  if (!running_ || !reactor || loopIndex >= reactor->loops_.size())
+    return false;
+  return reactor->loops_[loopIndex]->addContinueReadingHandle(easyHandle);
+}
+
+bool MCurlHttpClient::PerformLoop::addContinueReadingHandle(
+    CURL *easyHandle) {
+  if (!running_ || !mCurl_ || !easyHandle)
+    return false;
+  continueReadingQueue_.push(easyHandle);
+  wakeup();
   return true;
 }
 
@@ -351,11 +1125,35 @@ bool MCurlHttpClient::setResponseReady(CurlStorage *curlStorage) {
   curlStorage->resp->setStatusCode(responseCode);
   // set ready
   curlStorage->resp->getBody()->ready_ = true;
-  curlStorage->promise->set_value(curlStorage->resp);
-  curlStorage->promise = nullptr;
+  curlStorage->complete(curlStorage->resp, nullptr);
   return true;
 }
 
+void MCurlHttpClient::adaptToContentLength(CurlStorage *curlStorage) {
+#if LIBCURL_VERSION_NUM >= 0x073700
+  curl_off_t length = -1;
+  if (curl_easy_getinfo(curlStorage->easyHandle,
+                        CURLINFO_CONTENT_LENGTH_DOWNLOAD_T,
+                        &length) != CURLE_OK ||
+      length <= 0)
+    return;
+  auto body = curlStorage->resp->getBody();
+  if (body->hasSink_) {
+    // only a sink given to makeRequest is set before the first data
+    auto fileSink = dynamic_cast<FileSink *>(body->getSink().get());
+    if (fileSink) {
+      fileSink->preallocate(static_cast<uint64_t>(length));
+    }
+    return;
+  }
+  std::lock_guard<Lock::SpinLock> lock(body->writeLock_);
+  body->pipe_.setSegmentSize(Buffer::SegmentPool::segmentSizeFor(
+      static_cast<size_t>(length)));
+#else
+  (void)curlStorage;
+#endif
+}
+
 size_t MCurlHttpClient::recvBody(char *buffer, size_t size, size_t nmemb,
                                  void *userdata) {
   auto curlStorage = static_cast<CurlStorage *>(userdata);
@@ -366,10 +1164,25 @@ size_t MCurlHttpClient::recvBody(char *buffer, size_t size, size_t nmemb,
   auto body = curlStorage->resp->getBody();
   if (!body)
     return 0;
-  if (body->getReadableSize() >= body->getMaxSize()) {
-    return CURL_WRITEFUNC_PAUSE;
+  if (body->shouldPause()) {
+    // resumed by the reader once it drains the body to the low watermark,
+    // or by the budget once the readers have drained it. The flag is set
+    // before checking again, a reader which drained the body before seeing
+    // it would never resume the transfer
+    body->paused_ = true;
+    if (body->shouldPause()) {
+      if (body->budget_ && body->budget_->exceeded()) {
+        body->budget_->park(body);
+      }
+      return CURL_WRITEFUNC_PAUSE;
+    }
+    // a reader which resumed meanwhile only queued a harmless CURLPAUSE_CONT
+    body->paused_ = false;
   }
   auto expectSize = size * nmemb;
+  if (!body->getReady()) {
+    adaptToContentLength(curlStorage);
+  }
   auto realSize = body->write(buffer, expectSize);
   if (!body->getReady()) {
     setResponseReady(curlStorage);
@@ -1,6 +1,7 @@
 #include <darabonba/Type.hpp>
 #include <darabonba/http/MCurlHttpClient.hpp>
 #include <darabonba/http/MCurlResponse.hpp>
+#include <limits>
 #include <mutex>
 #include <string>
 
@@ -9,61 +10,299 @@ using std::string;
 namespace Darabonba {
 namespace Http {
 
+MCurlResponseBody::~MCurlResponseBody() {
+  if (budget_) {
+    if (holding_) {
+      --budget_->holders_;
+    }
+    budget_->sub(pipe_.readableSize());
+  }
+}
+
+void MCurlResponseBody::setWatermarks(size_t high, size_t low) {
+  if (low == 0 || low >= high) {
+    low = high / 2;
+  }
+  highWatermark_ = high;
+  lowWatermark_ = low;
+}
+
+bool MCurlResponseBody::shouldPause() {
+  auto readable = pipe_.readableSize();
+  if (budget_ && (readable > 0) != holding_) {
+    // only updated here and once the body is drained after its end
+    holding_ = readable > 0;
+    if (readable > 0) {
+      ++budget_->holders_;
+    } else {
+      --budget_->holders_;
+    }
+  }
+  if (readable == 0)
+    return false;
+  auto high = highWatermark_.load();
+  if (readable >= high)
+    return true;
+  // waitForDone() lifts every limit, nobody reads until the end
+  return budget_ && high != (std::numeric_limits<size_t>::max)() &&
+         budget_->shouldPause(readable);
+}
+
+void MCurlResponseBody::drained(size_t size) {
+  if (size == 0)
+    return;
+  if (budget_) {
+    budget_->sub(size);
+    if (done_ && pipe_.readableSize() == 0 && holding_.exchange(false)) {
+      --budget_->holders_;
+    }
+  }
+  if (!paused_.load())
+    return;
+  auto readable = pipe_.readableSize();
+  // a body throttled by the budget is resumed by the budget, or once it is
+  // empty by waitForData()
+  if (readable <= lowWatermark_ &&
+      !(budget_ && budget_->shouldPause(readable))) {
+    resume();
+  }
+}
+
 void MCurlResponseBody::waitForDone() {
   if (done_)
     return;
-  if (maxSize_ != (std::numeric_limits<size_t>::max)()) {
-    maxSize_ = (std::numeric_limits<size_t>::max)();
-    client_->addContinueReadingHandle(easyHandle_);
+  if (highWatermark_ != (std::numeric_limits<size_t>::max)()) {
+    // the perform thread sees the new watermark once resumed
+    highWatermark_ = (std::numeric_limits<size_t>::max)();
+    resume();
   }
   std::unique_lock<std::mutex> lock(doneMutex_);
   doneCV_.wait(lock, [this]() -> bool { return done_.load(); });
-  client_ = nullptr;
-  easyHandle_ = nullptr;
 }
 
-  size_t MCurlResponseBody::read(char *buffer, size_t expectSize) {
-  if (done_ && readableSize_ == 0)
+size_t MCurlResponseBody::read(char *buffer, size_t expectSize) {
+  if (expectSize == 0)
     return 0;
-  size_t realSize = 0;
-  do {
-    realSize = (std::min)({expectSize, readableSize_.load(), maxSize_.load()});
+  for (;;) {
+    size_t realSize = 0;
+    {
+      std::lock_guard<Lock::SpinLock> lock(readLock_);
+      realSize = pipe_.read(buffer, expectSize);
+    }
     if (realSize != 0) {
-      {
-        std::lock_guard<Lock::SpinLock> lock(bufferlock_);
-        realSize = buffer_.read(buffer, realSize);
-      }
-      readableSize_ -= realSize;
+      drained(realSize);
       return realSize;
     }
 
     if (done_) {
-      client_ = nullptr;
-      easyHandle_ = nullptr;
+      // the data written before the end is visible once done_ is
+      if (pipe_.readableSize() != 0)
+        continue;
+      return 0;
+    }
+    waitForData();
+  }
+}
+
+size_t MCurlResponseBody::peek(const char **data) {
+  for (;;) {
+    {
+      std::lock_guard<Lock::SpinLock> lock(readLock_);
+      auto size = pipe_.peek(data);
+      if (size != 0)
+        return size;
+    }
+
+    if (done_) {
+      if (pipe_.readableSize() != 0)
+        continue;
       return 0;
     }
-    
-    fetch();
+    waitForData();
+  }
+}
+
+void MCurlResponseBody::consume(size_t size) {
+  {
+    std::lock_guard<Lock::SpinLock> lock(readLock_);
+    size = pipe_.consume(size);
+  }
+  drained(size);
+}
+
+void MCurlResponseBody::waitForData() {
+  // the body is empty, below any watermark and budget
+  resume();
+  // announce the reader before checking the pipe, a writer which does not
+  // see it has published its data before the check
+  ++waitingReaders_;
+  {
     std::unique_lock<std::mutex> lock(streamMutex_);
-    streamCV_.wait(
-        lock, [this]() -> bool { return done_.load() || readableSize_ > 0; });
-  } while (realSize == 0);
+    streamCV_.wait(lock, [this]() -> bool {
+      return done_.load() || pipe_.readableSize() > 0;
+    });
+  }
+  --waitingReaders_;
+}
+
+bool MCurlResponseBody::notifyWhenReadable(std::function<void()> callback) {
+  {
+    std::lock_guard<std::mutex> lock(streamMutex_);
+    if (readableCallback_)
+      return false;
+    // announced before the check, like a parked reader
+    ++waitingReaders_;
+    if (isReadable()) {
+      --waitingReaders_;
+      return false;
+    }
+    readableCallback_ = std::move(callback);
+  }
+  // nothing is readable, like a parked reader
+  resume();
+  return true;
+}
 
-  return realSize;
+void MCurlResponseBody::wakeReaders() {
+  std::function<void()> callback;
+  {
+    // a reader between its check and its wait holds the mutex
+    std::lock_guard<std::mutex> lock(streamMutex_);
+    if (readableCallback_) {
+      callback = std::move(readableCallback_);
+      readableCallback_ = nullptr;
+      --waitingReaders_;
+    }
+  }
+  streamCV_.notify_all();
+  if (callback) {
+    MCurlHttpClient *client = nullptr;
+    size_t loopIndex = 0;
+    {
+      std::lock_guard<Lock::SpinLock> guard(handleLock_);
+      client = client_;
+      loopIndex = loopIndex_;
+    }
+    runReadableCallback(std::move(callback), client, loopIndex);
+  }
 }
-  
+
+void MCurlResponseBody::runReadableCallback(std::function<void()> callback,
+                                            MCurlHttpClient *client,
+                                            size_t loopIndex) {
+  // not from the curl callback which wrote the data, the reader may go on
+  // with the transfer or release the body
+  if (!client || !client->post(loopIndex, callback)) {
+    callback();
+  }
+}
+
+bool MCurlResponseBody::setSink(std::shared_ptr<OStream> sink) {
+  if (!sink)
+    return false;
+  {
+    std::lock_guard<std::mutex> guard(sinkMutex_);
+    if (sink_)
+      return false;
+    sink_ = std::move(sink);
+    flushToSink();
+    // the data written meanwhile is flushed by the next write or finish()
+    hasSink_ = true;
+  }
+  // the transfer may be paused with a full buffer, it is drained now
+  resume();
+  return true;
+}
+
+void MCurlResponseBody::flushToSink() {
+  std::lock_guard<Lock::SpinLock> lock(readLock_);
+  const char *data = nullptr;
+  size_t size = 0;
+  while ((size = pipe_.peek(&data)) > 0) {
+    sink_->write(const_cast<char *>(data), size);
+    pipe_.consume(size);
+    if (budget_) {
+      budget_->sub(size);
+    }
+  }
+}
+
+void MCurlResponseBody::finish() {
+  MCurlHttpClient *client = nullptr;
+  size_t loopIndex = 0;
+  {
+    // the easy handle is released after this, fetch() must not reach it
+    std::lock_guard<Lock::SpinLock> guard(handleLock_);
+    client = client_;
+    loopIndex = loopIndex_;
+    client_ = nullptr;
+    easyHandle_ = nullptr;
+    paused_ = false;
+  }
+  std::function<void()> callback;
+  {
+    std::lock_guard<std::mutex> sinkGuard(sinkMutex_);
+    if (sink_) {
+      flushToSink();
+    }
+    // under the mutexes, a reader between its check and its wait would miss
+    // the notification
+    std::lock_guard<std::mutex> doneGuard(doneMutex_);
+    std::lock_guard<std::mutex> streamGuard(streamMutex_);
+    done_ = true;
+    if (readableCallback_) {
+      callback = std::move(readableCallback_);
+      readableCallback_ = nullptr;
+      --waitingReaders_;
+    }
+  }
+  streamCV_.notify_all();
+  doneCV_.notify_all();
+  if (callback)
+    runReadableCallback(std::move(callback), client, loopIndex);
+}
+
+void MCurlResponseBody::detach() {
+  // the readers must not wait for data which will never come
+  aborted_ = true;
+  finish();
+}
+
+bool MCurlResponseBody::resume() {
+  // the check and the request are atomic with finish(), which clears both
+  std::lock_guard<Lock::SpinLock> guard(handleLock_);
+  if (!paused_.exchange(false) || !easyHandle_ || !client_)
+    return false;
+  client_->addContinueReadingHandle(easyHandle_, loopIndex_);
+  return true;
+}
+
 bool MCurlResponseBody::fetch() {
+  std::lock_guard<Lock::SpinLock> guard(handleLock_);
   if (!easyHandle_ || !client_)
     return false;
-  client_->addContinueReadingHandle(easyHandle_);
+  client_->addContinueReadingHandle(easyHandle_, loopIndex_);
   return true;
 }
 
 size_t MCurlResponseBody::write(char *buffer, size_t expectSize) {
-  std::lock_guard<Lock::SpinLock> lock(bufferlock_);
-  buffer_.write(buffer, expectSize);
-  readableSize_ += expectSize;
-  streamCV_.notify_one();  // 通知等待的消费者线程
+  if (hasSink_.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> guard(sinkMutex_);
+    // the data written between the flush of setSink() and now goes first
+    flushToSink();
+    return sink_->write(buffer, expectSize);
+  }
+  // counted first, the reader may drain the data before this returns
+  if (budget_) {
+    budget_->add(expectSize);
+  }
+  {
+    std::lock_guard<Lock::SpinLock> lock(writeLock_);
+    pipe_.write(buffer, expectSize);
+  }
+  if (waitingReaders_.load() > 0) {
+    wakeReaders();
+  }
   return expectSize;
 }
 
@@ -4,24 +4,61 @@
 namespace Darabonba {
 namespace Http {
 
-// void SSEEvent::validate() const {
-//     // Add any specific validation logic here
-//     if (!id_ || !event_ || !data_ || !retry_) {
-//         throw std::invalid_argument("Fields cannot be null");
-//     }
-// }
+namespace {
+// The same rules as DARABONBA_PTR_FROM_JSON: a null value unsets the field
+template <typename T>
+void fieldFromJson(const Darabonba::Json &j, const char *key, T &field,
+                   uint8_t &flags, uint8_t flag) {
+  auto it = j.find(key);
+  if (it == j.end())
+    return;
+  if (it->is_null()) {
+    field = T();
+    flags &= static_cast<uint8_t>(~flag);
+  } else {
+    field = Darabonba::detail::safe_convert<T>(*it);
+    flags |= flag;
+  }
+}
+} // namespace
 
-const std::string &SSEEvent::getId() const { return *id_; }
-void SSEEvent::setId(const std::string &id) { *id_ = id; }
+void to_json(Darabonba::Json &j, const SSEEvent &obj) {
+  if (obj.hasId())
+    j["id"] = obj.id_;
+  if (obj.hasEvent())
+    j["event"] = obj.event_;
+  if (obj.hasData())
+    j["data"] = obj.data_;
+  if (obj.hasRetry())
+    j["retry"] = obj.retry_;
+}
 
-const std::string &SSEEvent::getEvent() const { return *event_; }
-void SSEEvent::setEvent(const std::string &event) { *event_ = event; }
+void from_json(const Darabonba::Json &j, SSEEvent &obj) {
+  fieldFromJson(j, "id", obj.id_, obj.flags_, SSEEvent::HAS_ID);
+  fieldFromJson(j, "event", obj.event_, obj.flags_, SSEEvent::HAS_EVENT);
+  fieldFromJson(j, "data", obj.data_, obj.flags_, SSEEvent::HAS_DATA);
+  fieldFromJson(j, "retry", obj.retry_, obj.flags_, SSEEvent::HAS_RETRY);
+}
 
-const std::string &SSEEvent::getData() const { return *data_; }
-void SSEEvent::setData(const std::string &data) { *data_ = data; }
+SSEEvent::SSEEvent(const std::string &id, const std::string &event,
+                   const std::string &data, int retry) {
+  if (!id.empty())
+    setId(id);
+  if (!event.empty())
+    setEvent(event);
+  if (!data.empty())
+    setData(data);
+  if (retry != 0)
+    setRetry(retry);
+}
 
-// int SSEEvent::getRetry() const { return *retry_; }
-void SSEEvent::setRetry(int retry) { *retry_ = retry; }
+void SSEEvent::clear() {
+  id_.clear();
+  event_.clear();
+  data_.clear();
+  retry_ = 0;
+  flags_ = 0;
+}
 
 } // namespace Http
 } // namespace Darabonba
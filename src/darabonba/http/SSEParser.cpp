@@ -0,0 +1,232 @@
+#include <cstring>
+#include <darabonba/http/MCurlResponse.hpp>
+#include <darabonba/http/SSEParser.hpp>
+
+namespace Darabonba {
+namespace Http {
+
+namespace {
+bool equals(const char *data, size_t size, const char *literal) {
+  return size == std::strlen(literal) && std::memcmp(data, literal, size) == 0;
+}
+} // namespace
+
+size_t SSEParser::feed(const char *data, size_t size) {
+  dispatched_ = 0;
+  auto p = data;
+  auto end = data + size;
+  if (!started_ && p < end) {
+    // a UTF-8 BOM may start the stream, it can be split across chunks too
+    static const char bom[] = "\xEF\xBB\xBF";
+    while (line_.size() < 3 && p < end && *p == bom[line_.size()]) {
+      line_.push_back(*p++);
+    }
+    if (line_.size() == 3) {
+      line_.clear();
+      started_ = true;
+    } else if (p < end) {
+      started_ = true;
+    } else {
+      return 0;
+    }
+  }
+  if (skipLF_ && p < end) {
+    skipLF_ = false;
+    if (*p == '\n')
+      ++p;
+  }
+  while (p < end) {
+    auto eol = p;
+    while (eol < end && *eol != '\n' && *eol != '\r') {
+      ++eol;
+    }
+    if (eol == end) {
+      line_.append(p, static_cast<size_t>(end - p));
+      break;
+    }
+    if (line_.empty()) {
+      processLine(p, static_cast<size_t>(eol - p));
+    } else {
+      line_.append(p, static_cast<size_t>(eol - p));
+      processLine(line_.data(), line_.size());
+      line_.clear();
+    }
+    p = eol + 1;
+    if (*eol == '\r') {
+      if (p == end) {
+        skipLF_ = true;
+      } else if (*p == '\n') {
+        ++p;
+      }
+    }
+  }
+  return dispatched_;
+}
+
+void SSEParser::finish() {
+  line_.clear();
+  data_.clear();
+  eventType_.clear();
+  eventRetry_ = -1;
+  hasData_ = false;
+  hasIdField_ = false;
+  skipLF_ = false;
+}
+
+bool SSEParser::next(SSEEvent &event) {
+  if (events_.empty())
+    return false;
+  event = std::move(events_.front());
+  events_.pop_front();
+  return true;
+}
+
+void SSEParser::reset() {
+  finish();
+  events_.clear();
+  lastEventId_.clear();
+  retry_ = -1;
+  started_ = false;
+}
+
+void SSEParser::restart() {
+  finish();
+  started_ = false;
+}
+
+void SSEParser::processLine(const char *line, size_t size) {
+  if (size == 0) {
+    dispatch();
+    return;
+  }
+  if (line[0] == ':')
+    return;
+  auto colon = static_cast<const char *>(std::memchr(line, ':', size));
+  if (colon == nullptr) {
+    processField(line, size, line + size, 0);
+    return;
+  }
+  auto value = colon + 1;
+  auto valueSize = size - static_cast<size_t>(value - line);
+  if (valueSize > 0 && *value == ' ') {
+    ++value;
+    --valueSize;
+  }
+  processField(line, static_cast<size_t>(colon - line), value, valueSize);
+}
+
+void SSEParser::processField(const char *name, size_t nameSize,
+                             const char *value, size_t valueSize) {
+  if (equals(name, nameSize, "data")) {
+    if (hasData_)
+      data_.push_back('\n');
+    data_.append(value, valueSize);
+    hasData_ = true;
+  } else if (equals(name, nameSize, "event")) {
+    eventType_.assign(value, valueSize);
+  } else if (equals(name, nameSize, "id")) {
+    if (std::memchr(value, '\0', valueSize) == nullptr) {
+      lastEventId_.assign(value, valueSize);
+      hasIdField_ = true;
+    }
+  } else if (equals(name, nameSize, "retry")) {
+    if (valueSize == 0 || valueSize > 9)
+      return;
+    int retry = 0;
+    for (size_t i = 0; i < valueSize; ++i) {
+      if (value[i] < '0' || value[i] > '9')
+        return;
+      retry = retry * 10 + (value[i] - '0');
+    }
+    retry_ = retry;
+    eventRetry_ = retry;
+  }
+}
+
+void SSEParser::dispatch() {
+  if (!hasData_) {
+    eventType_.clear();
+    eventRetry_ = -1;
+    hasIdField_ = false;
+    return;
+  }
+  SSEEvent event;
+  if (!lastEventId_.empty()) {
+    event.setId(lastEventId_);
+    event.setIdFromField(hasIdField_);
+  }
+  if (!eventType_.empty())
+    event.setEvent(std::move(eventType_));
+  event.setData(std::move(data_));
+  if (eventRetry_ >= 0)
+    event.setRetry(eventRetry_);
+  data_.clear();
+  eventType_.clear();
+  eventRetry_ = -1;
+  hasData_ = false;
+  hasIdField_ = false;
+  ++dispatched_;
+  if (callback_) {
+    callback_(event);
+  } else {
+    events_.push_back(std::move(event));
+  }
+}
+
+SSEReader::SSEReader(std::shared_ptr<IStream> body) : body_(std::move(body)) {
+  if (!body_)
+    ended_ = true;
+}
+
+void SSEReader::setBody(std::shared_ptr<IStream> body) {
+  body_ = std::move(body);
+  ended_ = !body_;
+  parser_.restart();
+}
+
+bool SSEReader::next(SSEEvent &event) {
+  while (!parser_.next(event)) {
+    if (!fill())
+      return false;
+  }
+  return true;
+}
+
+size_t SSEReader::forEach(const SSEParser::Callback &callback) {
+  size_t count = 0;
+  SSEEvent event;
+  while (next(event)) {
+    callback(event);
+    ++count;
+  }
+  return count;
+}
+
+bool SSEReader::fill() {
+  if (ended_)
+    return false;
+  auto body = std::dynamic_pointer_cast<MCurlResponseBody>(body_);
+  if (body) {
+    const char *data;
+    auto size = body->peek(&data);
+    if (size > 0) {
+      parser_.feed(data, size);
+      body->consume(size);
+      return true;
+    }
+  } else {
+    if (buffer_.empty())
+      buffer_.resize(CHUNK_SIZE);
+    auto size = body_->read(buffer_.data(), buffer_.size());
+    if (size > 0) {
+      parser_.feed(buffer_.data(), size);
+      return true;
+    }
+  }
+  parser_.finish();
+  ended_ = true;
+  return false;
+}
+
+} // namespace Http
+} // namespace Darabonba
@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <chrono>
+#include <darabonba/http/SSESession.hpp>
+
+namespace Darabonba {
+namespace Http {
+
+SSESession::SSESession(std::shared_ptr<MCurlHttpClient> client,
+                       const Request &request, const RequestConfig &config)
+    : client_(std::move(client)), request_(request), config_(config),
+      defaultBackoff_(Darabonba::Json{
+          {"policy", "Fixed"}, {"period", static_cast<int>(DEFAULT_RETRY)}}),
+      reader_(nullptr) {
+  // CURLOPT_TIMEOUT_MS would cut every stream after the timeout, only a
+  // silent connection is given up
+  if (config_.read_timeout_ms > 0 && config_.idle_timeout_ms == 0) {
+    config_.idle_timeout_ms = config_.read_timeout_ms;
+  }
+  config_.read_timeout_ms = 0;
+  auto &header = request_.getHeader();
+  if (header.find("accept") == header.end() &&
+      header.find("Accept") == header.end()) {
+    header["accept"] = "text/event-stream";
+  }
+}
+
+bool SSESession::next(SSEEvent &event) {
+  for (;;) {
+    if (closed_)
+      return false;
+    if (!connected_) {
+      if (ended_)
+        return false;
+      if (failures_ > 0 || connections_ > 0) {
+        if (maxReconnects_ >= 0 && failures_ > maxReconnects_) {
+          ended_ = true;
+          return false;
+        }
+        if (!waitToReconnect())
+          return false;
+      }
+      if (!connect()) {
+        ++failures_;
+        continue;
+      }
+    }
+    if (reader_.next(event)) {
+      if (isDuplicate(event)) {
+        ++duplicates_;
+        continue;
+      }
+      if (event.isIdFromField())
+        remember(event.getId());
+      delivered_ = true;
+      failures_ = 0;
+      return true;
+    }
+    // the connection is gone, the stream goes on with a new one
+    connected_ = false;
+    if (!delivered_)
+      ++failures_;
+  }
+}
+
+void SSESession::close() {
+  {
+    std::lock_guard<std::mutex> lock(closeMutex_);
+    closed_ = true;
+  }
+  closeCV_.notify_all();
+}
+
+int SSESession::getReconnectDelay() const {
+  Policy::RetryPolicyContext ctx((std::max)(failures_, 1), nullptr);
+  const Policy::BackoffPolicy &policy =
+      backoff_ ? *backoff_ : static_cast<const Policy::BackoffPolicy &>(
+                                 defaultBackoff_);
+  auto delay = policy.getDelayTime(ctx);
+  auto retry = reader_.getParser().getRetry();
+  if (retry >= 0) {
+    delay = backoff_ ? (std::max)(delay, retry) : retry;
+  }
+  return (std::min)((std::max)(delay, 0), MaxDelayTime);
+}
+
+bool SSESession::connect() {
+  if (!client_) {
+    ended_ = true;
+    return false;
+  }
+  Request request(request_);
+  const auto &id = reader_.getParser().getLastEventId();
+  if (!id.empty()) {
+    request.getHeader()["last-event-id"] = id;
+  }
+  auto body = request.getBody();
+  if (connections_ > 0 && body && body->isSeekable()) {
+    body->rewind();
+  }
+  ++connections_;
+  if (connections_ > 1)
+    ++reconnects_;
+
+  std::shared_ptr<MCurlResponse> response;
+  try {
+    response = client_->makeRequest(request, config_).get();
+  } catch (const std::exception &) {
+    return false;
+  }
+  if (!response)
+    return false;
+  statusCode_ = response->getStatusCode();
+  if (statusCode_ >= 500 || statusCode_ == 429)
+    return false;
+  if (statusCode_ < 200 || statusCode_ >= 300 || statusCode_ == 204) {
+    // the server does not want the client to reconnect
+    ended_ = true;
+    return false;
+  }
+  reader_.setBody(response->getBody());
+  connected_ = true;
+  delivered_ = false;
+  replaying_ = !id.empty();
+  return true;
+}
+
+bool SSESession::waitToReconnect() {
+  auto delay = std::chrono::milliseconds(getReconnectDelay());
+  std::unique_lock<std::mutex> lock(closeMutex_);
+  return !closeCV_.wait_for(lock, delay, [this]() { return closed_.load(); });
+}
+
+bool SSESession::isDuplicate(const SSEEvent &event) {
+  if (!replaying_)
+    return false;
+  // an event without an id field carries the id of the one before it, it
+  // can't be told from a replay and is always delivered
+  if (!event.isIdFromField())
+    return false;
+  if (seenIds_.count(event.getId()))
+    return true;
+  replaying_ = false;
+  return false;
+}
+
+void SSESession::remember(const std::string &id) {
+  if (id.empty() || (!recentIds_.empty() && recentIds_.back() == id))
+    return;
+  if (seenIds_.insert(id).second) {
+    recentIds_.push_back(id);
+    if (recentIds_.size() > static_cast<size_t>(DEDUP_WINDOW)) {
+      seenIds_.erase(recentIds_.front());
+      recentIds_.pop_front();
+    }
+  }
+}
+
+} // namespace Http
+} // namespace Darabonba
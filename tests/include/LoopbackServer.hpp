@@ -0,0 +1,161 @@
+#ifndef DARABONBA_TESTS_LOOPBACKSERVER_H_
+#define DARABONBA_TESTS_LOOPBACKSERVER_H_
+
+#ifndef _WIN32
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace Darabonba {
+namespace Testing {
+
+/**
+ * @brief A local stand-in HTTP server listening on an ephemeral port of
+ * 127.0.0.1, shared by the tests and the benchmarks.
+ * @note The handler is the script of a connection, the server closes the
+ *       socket when it returns. The connections are served one after the
+ *       other on the accept thread, or each on a thread of its own when the
+ *       client keeps several of them open at once. POSIX only.
+ */
+class LoopbackServer {
+public:
+  using Handler = std::function<void(int fd)>;
+
+  explicit LoopbackServer(Handler handler, bool threadPerConnection = false)
+      : handler_(std::move(handler)),
+        threadPerConnection_(threadPerConnection) {
+    fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    if (bind(fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+        listen(fd_, 1024) != 0) {
+      std::perror("bind");
+      std::exit(1);
+    }
+    socklen_t len = sizeof(addr);
+    getsockname(fd_, reinterpret_cast<sockaddr *>(&addr), &len);
+    port_ = ntohs(addr.sin_port);
+    thread_ = std::thread([this]() { serve(); });
+  }
+
+  ~LoopbackServer() {
+    stop_ = true;
+    shutdown(fd_, SHUT_RDWR);
+    ::close(fd_);
+    thread_.join();
+    // the connection threads end when the client closes its connections
+    for (auto &t : connections_) {
+      t.join();
+    }
+  }
+
+  LoopbackServer(const LoopbackServer &) = delete;
+  LoopbackServer &operator=(const LoopbackServer &) = delete;
+
+  int port() const { return port_; }
+
+  std::string url(const std::string &path = "/") const {
+    return "http://127.0.0.1:" + std::to_string(port_) + path;
+  }
+
+  /**
+   * @brief Read up to the end of the next request head.
+   * @param buffer The bytes received on the connection, the ones after the
+   *        head are left in it for the next call.
+   * @param head Set to the head, including the blank line, if not null.
+   * @return false once the connection is closed before a complete head.
+   */
+  static bool readHead(int fd, std::string &buffer,
+                       std::string *head = nullptr) {
+    char chunk[16 * 1024];
+    size_t end;
+    while ((end = buffer.find("\r\n\r\n")) == std::string::npos) {
+      auto n = recv(fd, chunk, sizeof(chunk), 0);
+      if (n <= 0)
+        return false;
+      buffer.append(chunk, static_cast<size_t>(n));
+    }
+    if (head) {
+      head->assign(buffer, 0, end + 4);
+    }
+    buffer.erase(0, end + 4);
+    return true;
+  }
+
+  static bool sendAll(int fd, const char *data, size_t size) {
+    size_t sent = 0;
+    while (sent < size) {
+      auto n = send(fd, data + sent, size - sent, MSG_NOSIGNAL);
+      if (n <= 0)
+        return false;
+      sent += static_cast<size_t>(n);
+    }
+    return true;
+  }
+
+  static bool sendAll(int fd, const std::string &data) {
+    return sendAll(fd, data.data(), data.size());
+  }
+
+  /**
+   * @brief A handler answering every request of a keep-alive connection with
+   * the same response, the request bodies are not read.
+   */
+  static Handler respond(const std::string &response) {
+    return [response](int fd) {
+      std::string buffer;
+      while (readHead(fd, buffer)) {
+        if (!sendAll(fd, response))
+          return;
+      }
+    };
+  }
+
+private:
+  void serve() {
+    while (!stop_) {
+      int fd = accept(fd_, nullptr, nullptr);
+      if (fd < 0)
+        continue;
+      if (threadPerConnection_) {
+        connections_.emplace_back([this, fd]() { handle(fd); });
+      } else {
+        handle(fd);
+      }
+    }
+  }
+
+  void handle(int fd) {
+    handler_(fd);
+    ::close(fd);
+  }
+
+  Handler handler_;
+  bool threadPerConnection_;
+  int fd_ = -1;
+  int port_ = 0;
+  std::atomic<bool> stop_ = {false};
+  std::thread thread_;
+  std::vector<std::thread> connections_;
+};
+
+} // namespace Testing
+} // namespace Darabonba
+#endif
+
+#endif
@@ -0,0 +1,113 @@
+#include <darabonba/buffer/RingBuffer.hpp>
+#include <gtest/gtest.h>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Darabonba::Buffer;
+
+// ==================== RingBuffer 基础测试 ====================
+
+TEST(RingBufferTest, InitialSizes) {
+  SegmentPool pool;
+  RingBuffer buffer(1024, &pool);
+  EXPECT_EQ(buffer.readableSize(), 0u);
+  EXPECT_EQ(buffer.writableSize(), 1024u);
+}
+
+TEST(RingBufferTest, SizesFollowReadAndWrite) {
+  SegmentPool pool;
+  RingBuffer buffer(1024, &pool);
+  std::string data(3000, 'a');
+  buffer.write(&data[0], data.size());
+  EXPECT_EQ(buffer.readableSize(), 3000u);
+  // write() 之后总会留有可写空间
+  EXPECT_GT(buffer.writableSize(), 0u);
+  auto total = buffer.readableSize() + buffer.writableSize();
+
+  std::vector<char> out(1500);
+  EXPECT_EQ(buffer.read(out.data(), out.size()), 1500u);
+  EXPECT_EQ(buffer.readableSize(), 1500u);
+  // 读完的整段重新变为可写
+  EXPECT_EQ(buffer.readableSize() + buffer.writableSize(), total - 476u);
+
+  EXPECT_EQ(buffer.read(out.data(), out.size()), 1500u);
+  EXPECT_EQ(buffer.readableSize(), 0u);
+  // 读空后全部空间可写
+  EXPECT_EQ(buffer.writableSize(), total);
+}
+
+TEST(RingBufferTest, GrowWhileWrapped) {
+  SegmentPool pool;
+  RingBuffer buffer(16, &pool);
+  std::string written;
+  std::string read;
+  char out[64];
+  // 让读写位置在段数组中回绕后再扩容
+  for (int round = 0; round < 50; ++round) {
+    std::string chunk(static_cast<size_t>(round % 7 + 1) * 9,
+                      static_cast<char>('a' + round % 26));
+    buffer.write(&chunk[0], chunk.size());
+    written += chunk;
+    auto n = buffer.read(out, static_cast<size_t>(round % 5 + 1) * 8);
+    read.append(out, n);
+  }
+  size_t n = 0;
+  while ((n = buffer.read(out, sizeof(out))) > 0) {
+    read.append(out, n);
+  }
+  EXPECT_EQ(read, written);
+}
+
+TEST(RingBufferTest, MatchesDequeModel) {
+  SegmentPool pool;
+  RingBuffer buffer(64, &pool);
+  std::deque<char> model;
+  std::mt19937 rng(42);
+  std::vector<char> data(1000);
+  std::vector<char> out(1000);
+  for (int i = 0; i < 5000; ++i) {
+    if (rng() % 2 == 0) {
+      size_t size = rng() % 300;
+      for (size_t j = 0; j < size; ++j) {
+        data[j] = static_cast<char>(rng());
+      }
+      buffer.write(data.data(), size);
+      model.insert(model.end(), data.begin(), data.begin() + size);
+    } else if (rng() % 2 == 0) {
+      size_t size = rng() % 300;
+      auto n = buffer.read(out.data(), size);
+      ASSERT_EQ(n, (std::min)(size, model.size()));
+      for (size_t j = 0; j < n; ++j) {
+        ASSERT_EQ(out[j], model.front());
+        model.pop_front();
+      }
+    } else {
+      const char *span = nullptr;
+      auto n = buffer.peek(&span);
+      ASSERT_LE(n, model.size());
+      for (size_t j = 0; j < n; ++j) {
+        ASSERT_EQ(span[j], model[j]);
+      }
+      auto consumed = buffer.consume(n / 2 + 1);
+      ASSERT_EQ(consumed, (std::min)(n / 2 + 1, model.size()));
+      model.erase(model.begin(), model.begin() + consumed);
+    }
+    ASSERT_EQ(buffer.readableSize(), model.size());
+  }
+}
+
+TEST(RingBufferTest, MoveKeepsData) {
+  SegmentPool pool;
+  RingBuffer buffer(32, &pool);
+  std::string data(100, 'm');
+  buffer.write(&data[0], data.size());
+
+  RingBuffer moved(std::move(buffer));
+  EXPECT_EQ(moved.readableSize(), 100u);
+  EXPECT_EQ(buffer.readableSize(), 0u);
+  std::string out(100, '\0');
+  EXPECT_EQ(moved.read(&out[0], out.size()), 100u);
+  EXPECT_EQ(out, data);
+}
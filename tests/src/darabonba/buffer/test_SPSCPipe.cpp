@@ -0,0 +1,167 @@
+#include <darabonba/buffer/SPSCPipe.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Darabonba::Buffer;
+
+// ==================== SPSCPipe 基础测试 ====================
+
+TEST(SPSCPipeTest, EmptyPipe) {
+  SegmentPool pool;
+  SPSCPipe pipe(1024, &pool);
+  EXPECT_EQ(pipe.readableSize(), 0u);
+  const char *data = nullptr;
+  EXPECT_EQ(pipe.peek(&data), 0u);
+  EXPECT_EQ(data, nullptr);
+  char out[16];
+  EXPECT_EQ(pipe.read(out, sizeof(out)), 0u);
+  // 没有写入时不会申请段
+  EXPECT_EQ(pool.getMetrics().allocations, 0u);
+}
+
+TEST(SPSCPipeTest, WriteAndRead) {
+  SegmentPool pool;
+  SPSCPipe pipe(1024, &pool);
+  std::string data = "Hello, World!";
+  EXPECT_EQ(pipe.write(data.data(), data.size()), data.size());
+  EXPECT_EQ(pipe.readableSize(), data.size());
+
+  char out[5];
+  EXPECT_EQ(pipe.read(out, sizeof(out)), 5u);
+  EXPECT_EQ(std::string(out, 5), "Hello");
+  EXPECT_EQ(pipe.readableSize(), 8u);
+
+  const char *span = nullptr;
+  auto size = pipe.peek(&span);
+  EXPECT_EQ(std::string(span, size), ", World!");
+  EXPECT_EQ(pipe.consume(size), size);
+  EXPECT_EQ(pipe.readableSize(), 0u);
+}
+
+TEST(SPSCPipeTest, SpansSegments) {
+  SegmentPool pool;
+  SPSCPipe pipe(4096, &pool);
+  std::string data;
+  for (int i = 0; i < 50000; ++i) {
+    data.push_back(static_cast<char>('a' + i % 26));
+  }
+  pipe.write(data.data(), data.size());
+  EXPECT_GT(pool.getMetrics().allocations, 1u);
+
+  std::string result;
+  const char *span = nullptr;
+  size_t size = 0;
+  while ((size = pipe.peek(&span)) > 0) {
+    // 每段可用的容量小于段大小
+    EXPECT_LT(size, 4096u);
+    result.append(span, size);
+    pipe.consume(size);
+  }
+  EXPECT_EQ(result, data);
+  // 读完的段归还到池中
+  auto metrics = pool.getMetrics();
+  EXPECT_EQ(metrics.idleCount + 1, metrics.allocations);
+}
+
+TEST(SPSCPipeTest, SegmentSizeOnlyBeforeWrite) {
+  SegmentPool pool;
+  SPSCPipe pipe(1024, &pool);
+  EXPECT_TRUE(pipe.setSegmentSize(16384));
+  EXPECT_EQ(pipe.segmentSize(), 16384u);
+  EXPECT_FALSE(pipe.setSegmentSize(8));
+  char data[] = "x";
+  pipe.write(data, 1);
+  EXPECT_FALSE(pipe.setSegmentSize(4096));
+}
+
+TEST(SPSCPipeTest, DestroyReturnsSegments) {
+  SegmentPool pool;
+  {
+    SPSCPipe pipe(4096, &pool);
+    std::string data(20000, 'd');
+    pipe.write(data.data(), data.size());
+  }
+  auto metrics = pool.getMetrics();
+  EXPECT_EQ(metrics.idleCount, metrics.allocations);
+}
+
+// ==================== SPSCPipe 并发测试 ====================
+
+TEST(SPSCPipeTest, ProducerConsumer) {
+  SegmentPool pool;
+  SPSCPipe pipe(4096, &pool);
+  const size_t total = 8 * 1024 * 1024;
+  std::atomic<bool> finished(false);
+
+  std::thread producer([&]() {
+    std::vector<char> chunk(1500);
+    size_t sent = 0;
+    while (sent < total) {
+      auto n = (std::min)(chunk.size(), total - sent);
+      for (size_t i = 0; i < n; ++i) {
+        chunk[i] = static_cast<char>((sent + i) % 251);
+      }
+      pipe.write(chunk.data(), n);
+      sent += n;
+    }
+    finished = true;
+  });
+
+  std::vector<char> out(3000);
+  size_t received = 0;
+  bool ordered = true;
+  while (received < total) {
+    auto n = pipe.read(out.data(), out.size());
+    for (size_t i = 0; i < n; ++i) {
+      if (out[i] != static_cast<char>((received + i) % 251)) {
+        ordered = false;
+      }
+    }
+    received += n;
+    if (n == 0) {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+
+  EXPECT_TRUE(ordered);
+  EXPECT_EQ(received, total);
+  EXPECT_EQ(pipe.readableSize(), 0u);
+}
+
+TEST(SPSCPipeTest, ReadableSizeWhileWriting) {
+  SegmentPool pool;
+  SPSCPipe pipe(4096, &pool);
+  const size_t total = 8 * 1024 * 1024;
+  std::atomic<size_t> sent(0);
+
+  // 每次写入跨越多个段，消费者可能在计数前读到前面的段
+  std::thread producer([&]() {
+    std::vector<char> chunk(10000, 'x');
+    while (sent < total) {
+      auto n = (std::min)(chunk.size(), total - sent);
+      pipe.write(chunk.data(), n);
+      sent += n;
+    }
+  });
+
+  std::vector<char> out(3000);
+  size_t received = 0;
+  size_t maxReadable = 0;
+  while (received < total) {
+    auto n = pipe.read(out.data(), out.size());
+    received += n;
+    maxReadable = (std::max)(maxReadable, pipe.readableSize());
+    if (n == 0) {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+
+  EXPECT_LE(maxReadable, total);
+  EXPECT_EQ(received, total);
+  EXPECT_EQ(pipe.readableSize(), 0u);
+}
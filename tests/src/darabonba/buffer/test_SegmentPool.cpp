@@ -0,0 +1,143 @@
+#include <darabonba/buffer/RingBuffer.hpp>
+#include <darabonba/buffer/SegmentPool.hpp>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Darabonba::Buffer;
+
+// ==================== SegmentPool 基础测试 ====================
+
+TEST(SegmentPoolTest, ReleasedBlocksAreReused) {
+  SegmentPool pool;
+  char *first = pool.acquire(4096);
+  ASSERT_NE(first, nullptr);
+  pool.release(first, 4096);
+  EXPECT_EQ(pool.getMetrics().idleCount, 1u);
+  EXPECT_EQ(pool.getMetrics().idleBytes, 4096u);
+
+  char *second = pool.acquire(4096);
+  EXPECT_EQ(second, first);
+  pool.release(second, 4096);
+
+  auto metrics = pool.getMetrics();
+  EXPECT_EQ(metrics.allocations, 1u);
+  EXPECT_EQ(metrics.reuses, 1u);
+}
+
+TEST(SegmentPoolTest, SizesHaveSeparateLists) {
+  SegmentPool pool;
+  char *small = pool.acquire(4096);
+  pool.release(small, 4096);
+  // 不同大小的块不会互相复用
+  char *large = pool.acquire(64 * 1024);
+  EXPECT_EQ(pool.getMetrics().reuses, 0u);
+  EXPECT_EQ(pool.getMetrics().allocations, 2u);
+  pool.release(large, 64 * 1024);
+  EXPECT_EQ(pool.getMetrics().idleCount, 2u);
+}
+
+TEST(SegmentPoolTest, UnpooledSizeIsFreed) {
+  SegmentPool pool;
+  char *data = pool.acquire(5000);
+  pool.release(data, 5000);
+  auto metrics = pool.getMetrics();
+  EXPECT_EQ(metrics.idleCount, 0u);
+  EXPECT_EQ(metrics.frees, 1u);
+}
+
+TEST(SegmentPoolTest, IdleBytesBounded) {
+  SegmentPool pool(8192);
+  std::vector<char *> blocks;
+  for (int i = 0; i < 4; ++i) {
+    blocks.push_back(pool.acquire(4096));
+  }
+  for (auto data : blocks) {
+    pool.release(data, 4096);
+  }
+  auto metrics = pool.getMetrics();
+  EXPECT_EQ(metrics.idleBytes, 8192u);
+  EXPECT_EQ(metrics.frees, 2u);
+
+  pool.trim();
+  EXPECT_EQ(pool.getMetrics().idleCount, 0u);
+  EXPECT_EQ(pool.getMetrics().idleBytes, 0u);
+}
+
+TEST(SegmentPoolTest, SegmentSizeForExpectedSize) {
+  EXPECT_EQ(SegmentPool::segmentSizeFor(0), 4096u);
+  EXPECT_EQ(SegmentPool::segmentSizeFor(64 * 1024), 4096u);
+  EXPECT_EQ(SegmentPool::segmentSizeFor(256 * 1024), 16384u);
+  EXPECT_EQ(SegmentPool::segmentSizeFor(10 * 1024 * 1024), 65536u);
+}
+
+TEST(SegmentPoolTest, ConcurrentAcquireRelease) {
+  SegmentPool pool;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&pool]() {
+      for (int i = 0; i < 1000; ++i) {
+        char *data = pool.acquire(8192);
+        data[0] = 'x';
+        pool.release(data, 8192);
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  auto metrics = pool.getMetrics();
+  EXPECT_EQ(metrics.allocations + metrics.reuses, 4000u);
+  EXPECT_LE(metrics.allocations, 4u);
+  EXPECT_EQ(metrics.idleCount, metrics.allocations);
+}
+
+// ==================== RingBuffer 段复用测试 ====================
+
+TEST(SegmentPoolTest, RingBufferReturnsSegments) {
+  SegmentPool pool;
+  {
+    RingBuffer buffer(4096, &pool);
+    std::string data(20000, 'r');
+    buffer.write(&data[0], data.size());
+    EXPECT_EQ(pool.getMetrics().allocations, 5u);
+  }
+  EXPECT_EQ(pool.getMetrics().idleCount, 5u);
+}
+
+TEST(SegmentPoolTest, SteadyStateDownloadsAllocateNothing) {
+  SegmentPool pool;
+  std::string data(64 * 1024, 'd');
+  std::vector<char> out(1024);
+  auto download = [&]() {
+    RingBuffer buffer(4096, &pool);
+    for (int i = 0; i < 16; ++i) {
+      buffer.write(&data[0], data.size());
+      while (buffer.read(out.data(), out.size()) > 0) {
+      }
+    }
+  };
+  download();
+  auto allocations = pool.getMetrics().allocations;
+  for (int i = 0; i < 10; ++i) {
+    download();
+  }
+  EXPECT_EQ(pool.getMetrics().allocations, allocations);
+}
+
+TEST(SegmentPoolTest, RingBufferSegmentSize) {
+  SegmentPool pool;
+  RingBuffer buffer(4096, &pool);
+  EXPECT_TRUE(buffer.setSegmentSize(65536));
+  EXPECT_EQ(buffer.segmentSize(), 65536u);
+
+  std::string data(100000, 's');
+  buffer.write(&data[0], data.size());
+  // 已写入数据后不能再修改
+  EXPECT_FALSE(buffer.setSegmentSize(4096));
+
+  std::string result(data.size(), '\0');
+  EXPECT_EQ(buffer.read(&result[0], result.size()), data.size());
+  EXPECT_EQ(result, data);
+}
@@ -0,0 +1,99 @@
+#include <darabonba/http/BufferBudget.hpp>
+#include <darabonba/http/MCurlResponse.hpp>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+
+using namespace Darabonba::Http;
+
+namespace {
+// 暴露 protected 成员用于测试
+class TestableBufferBudget : public BufferBudget {
+public:
+  explicit TestableBufferBudget(size_t limit = 0) : BufferBudget(limit) {}
+  using BufferBudget::add;
+  using BufferBudget::park;
+  using BufferBudget::sub;
+};
+
+class TestableBody : public MCurlResponseBody {
+public:
+  using MCurlResponseBody::paused_;
+};
+} // namespace
+
+// ==================== BufferBudget 统计测试 ====================
+
+TEST(BufferBudgetTest, CurrentAndPeak) {
+  TestableBufferBudget budget;
+  budget.add(100);
+  budget.add(300);
+  budget.sub(250);
+  EXPECT_EQ(budget.getCurrent(), 150u);
+  EXPECT_EQ(budget.getPeak(), 400u);
+  // 没有上限时只统计
+  EXPECT_FALSE(budget.exceeded());
+
+  budget.resetPeak();
+  EXPECT_EQ(budget.getPeak(), 150u);
+  budget.sub(150);
+  auto metrics = budget.getMetrics();
+  EXPECT_EQ(metrics.current, 0u);
+  EXPECT_EQ(metrics.peak, 150u);
+  EXPECT_EQ(metrics.limit, 0u);
+  EXPECT_EQ(metrics.pauses, 0u);
+}
+
+TEST(BufferBudgetTest, Exceeded) {
+  TestableBufferBudget budget(1000);
+  budget.add(999);
+  EXPECT_FALSE(budget.exceeded());
+  budget.add(1);
+  EXPECT_TRUE(budget.exceeded());
+  budget.setLimit(2000);
+  EXPECT_FALSE(budget.exceeded());
+}
+
+TEST(BufferBudgetTest, SharedIsSingleton) {
+  EXPECT_EQ(BufferBudget::shared(), BufferBudget::shared());
+}
+
+// ==================== BufferBudget 暂停与恢复测试 ====================
+
+TEST(BufferBudgetTest, ResumeParkedWhenDrained) {
+  TestableBufferBudget budget(1000);
+  auto body = std::make_shared<TestableBody>();
+  budget.add(1200);
+  body->paused_ = true;
+  budget.park(body);
+  EXPECT_EQ(budget.getMetrics().pauses, 1u);
+
+  // 低于上限但高于 3/4 时保持暂停
+  budget.sub(300);
+  EXPECT_TRUE(body->paused_);
+  budget.sub(200);
+  EXPECT_FALSE(body->paused_);
+}
+
+TEST(BufferBudgetTest, RaisedLimitResumesParked) {
+  TestableBufferBudget budget(1000);
+  auto body = std::make_shared<TestableBody>();
+  budget.add(1000);
+  body->paused_ = true;
+  budget.park(body);
+  EXPECT_TRUE(body->paused_);
+  budget.setLimit(0);
+  EXPECT_FALSE(body->paused_);
+}
+
+TEST(BufferBudgetTest, ParkedBodyMayBeDestroyed) {
+  TestableBufferBudget budget(1000);
+  budget.add(1000);
+  {
+    auto body = std::make_shared<TestableBody>();
+    body->paused_ = true;
+    budget.park(body);
+  }
+  budget.sub(1000);
+  EXPECT_EQ(budget.getCurrent(), 0u);
+}
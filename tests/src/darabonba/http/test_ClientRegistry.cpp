@@ -0,0 +1,142 @@
+#include <darabonba/http/ClientRegistry.hpp>
+#include <darabonba/http/MCurlHttpClient.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Darabonba;
+using namespace Darabonba::Http;
+
+class ClientRegistryTest : public ::testing::Test {
+protected:
+  virtual void SetUp() override {
+    created_ = 0;
+    configured_ = 0;
+  }
+
+  std::atomic<int> created_;
+  std::atomic<int> configured_;
+};
+
+// ==================== ClientRegistry 基础测试 ====================
+
+TEST_F(ClientRegistryTest, CreateOncePerHost) {
+  ClientRegistry registry(
+      [this](const ConnectionPoolConfig &) {
+        ++created_;
+        return std::make_shared<MCurlHttpClient>();
+      },
+      [this](MCurlHttpClient &, const ConnectionPoolConfig &) {
+        ++configured_;
+      });
+  ConnectionPoolConfig config;
+  auto client1 = registry.get("a.example.com", config);
+  auto client2 = registry.get("a.example.com", config);
+  auto client3 = registry.get("b.example.com", config);
+  ASSERT_NE(client1, nullptr);
+  EXPECT_EQ(client1, client2);
+  EXPECT_NE(client1, client3);
+  EXPECT_EQ(created_, 2);
+  EXPECT_EQ(configured_, 2);
+  EXPECT_EQ(registry.size(), 2u);
+}
+
+TEST_F(ClientRegistryTest, ConfigAppliedOnlyWhenChanged) {
+  ClientRegistry registry(
+      [this](const ConnectionPoolConfig &) {
+        ++created_;
+        return std::make_shared<MCurlHttpClient>();
+      },
+      [this](MCurlHttpClient &client, const ConnectionPoolConfig &config) {
+        ++configured_;
+        client.setConnectionPoolConfig(config);
+      });
+  ConnectionPoolConfig config;
+  auto client = registry.get("host.example.com", config);
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(registry.get("host.example.com", config), client);
+  }
+  EXPECT_EQ(configured_, 1);
+
+  config.max_connections = 7;
+  EXPECT_EQ(registry.get("host.example.com", config), client);
+  EXPECT_EQ(configured_, 2);
+  EXPECT_EQ(client->getConnectionPoolConfig().max_connections, 7u);
+  // the host is filled by the registry
+  EXPECT_EQ(client->getConnectionPoolConfig().host, "host.example.com");
+  EXPECT_EQ(created_, 1);
+}
+
+TEST_F(ClientRegistryTest, EraseAndClear) {
+  ClientRegistry registry(
+      [](const ConnectionPoolConfig &) {
+        return std::make_shared<MCurlHttpClient>();
+      },
+      [](MCurlHttpClient &, const ConnectionPoolConfig &) {});
+  ConnectionPoolConfig config;
+  std::weak_ptr<MCurlHttpClient> weak = registry.get("a.example.com", config);
+  registry.get("b.example.com", config);
+  registry.get("c.example.com", config);
+  EXPECT_EQ(registry.size(), 3u);
+
+  EXPECT_TRUE(registry.erase("a.example.com"));
+  EXPECT_FALSE(registry.erase("a.example.com"));
+  EXPECT_TRUE(weak.expired());
+  EXPECT_EQ(registry.size(), 2u);
+
+  registry.clear();
+  EXPECT_EQ(registry.size(), 0u);
+}
+
+TEST_F(ClientRegistryTest, CreateFailure) {
+  ClientRegistry registry(
+      [](const ConnectionPoolConfig &) {
+        return std::shared_ptr<MCurlHttpClient>();
+      },
+      [](MCurlHttpClient &, const ConnectionPoolConfig &) {});
+  EXPECT_EQ(registry.get("a.example.com", ConnectionPoolConfig()), nullptr);
+  EXPECT_EQ(registry.size(), 0u);
+}
+
+// ==================== 并发测试 ====================
+
+TEST_F(ClientRegistryTest, ConcurrentLookups) {
+  ClientRegistry registry(
+      [this](const ConnectionPoolConfig &) {
+        ++created_;
+        return std::make_shared<MCurlHttpClient>();
+      },
+      [this](MCurlHttpClient &client, const ConnectionPoolConfig &config) {
+        ++configured_;
+        client.setConnectionPoolConfig(config);
+      });
+  const int hosts = 8;
+  std::vector<std::thread> threads;
+  std::vector<std::vector<MCurlHttpClient *>> seen(8);
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&registry, &seen, t, hosts]() {
+      ConnectionPoolConfig config;
+      for (int i = 0; i < 2000; ++i) {
+        // 部分线程会修改配置
+        config.max_connections = (t == 0 && i % 100 == 0) ? 64 + i : 128;
+        auto host = "host" + std::to_string(i % hosts) + ".example.com";
+        auto client = registry.get(host, config);
+        ASSERT_NE(client, nullptr);
+        if (i < hosts) {
+          seen[t].push_back(client.get());
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(created_, hosts);
+  EXPECT_EQ(registry.size(), static_cast<size_t>(hosts));
+  for (int t = 1; t < 8; ++t) {
+    EXPECT_EQ(seen[t], seen[0]);
+  }
+}
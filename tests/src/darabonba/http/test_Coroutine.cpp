@@ -0,0 +1,125 @@
+#include <darabonba/Exception.hpp>
+#include <darabonba/http/Coroutine.hpp>
+#include <gtest/gtest.h>
+
+#if defined(DARABONBA_HAS_COROUTINES) && !defined(_WIN32)
+
+#include <chrono>
+#include <exception>
+#include <future>
+#include <string>
+#include <thread>
+
+#include "LoopbackServer.hpp"
+
+using namespace Darabonba;
+using namespace Darabonba::Http;
+
+namespace {
+// 启动后不等待结果的协程
+struct DetachedTask {
+  struct promise_type {
+    DetachedTask get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+// 本地服务器返回的固定响应
+std::string bodyResponse(const std::string &body) {
+  return "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(body.size()) +
+         "\r\nConnection: close\r\n\r\n" + body;
+}
+
+struct Result {
+  std::string body;
+  std::thread::id thread;
+  bool failed = false;
+};
+
+DetachedTask fetch(MCurlHttpClient &client, Request request,
+                   RequestConfig config, std::promise<Result> &done) {
+  Result result;
+  try {
+    auto response = co_await asyncRequest(client, request, config);
+    if (response) {
+      auto body = response->getBody();
+      char buffer[4096];
+      size_t size;
+      while ((size = co_await asyncReadSome(*body, buffer, sizeof(buffer))) >
+             0) {
+        result.body.append(buffer, size);
+      }
+    }
+  } catch (const ResponseException &) {
+    result.failed = true;
+  }
+  result.thread = std::this_thread::get_id();
+  done.set_value(std::move(result));
+}
+} // namespace
+
+// ==================== 协程请求测试 ====================
+
+TEST(CoroutineTest, RequestAndReadBody) {
+  std::string content;
+  for (int i = 0; i < 1024 * 1024; ++i) {
+    content.push_back(static_cast<char>('a' + i % 26));
+  }
+  Testing::LoopbackServer server(
+      Testing::LoopbackServer::respond(bodyResponse(content)));
+
+  MCurlHttpClient client;
+  ASSERT_TRUE(client.start());
+
+  // 较小的水位线，读取过程中多次挂起
+  RequestConfig config;
+  config.buffer_high_watermark = 64 * 1024;
+  config.buffer_low_watermark = 16 * 1024;
+  std::promise<Result> done;
+  auto future = done.get_future();
+  fetch(client, Request(server.url()), config, done);
+  ASSERT_EQ(future.wait_for(std::chrono::seconds(10)),
+            std::future_status::ready);
+  auto result = future.get();
+  EXPECT_FALSE(result.failed);
+  EXPECT_EQ(result.body, content);
+  // 在 perform 线程上恢复
+  EXPECT_NE(result.thread, std::this_thread::get_id());
+
+  client.stop();
+}
+
+TEST(CoroutineTest, NetworkErrorIsThrown) {
+  MCurlHttpClient client;
+  ASSERT_TRUE(client.start());
+
+  RequestConfig config;
+  config.connect_timeout_ms = 2000;
+  std::promise<Result> done;
+  auto future = done.get_future();
+  fetch(client, Request(std::string("http://127.0.0.1:1/")), config, done);
+  ASSERT_EQ(future.wait_for(std::chrono::seconds(10)),
+            std::future_status::ready);
+  EXPECT_TRUE(future.get().failed);
+
+  client.stop();
+}
+
+TEST(CoroutineTest, StoppedClientResumesAtOnce) {
+  MCurlHttpClient client;
+  std::promise<Result> done;
+  auto future = done.get_future();
+  fetch(client, Request(std::string("file:///dev/null")), RequestConfig(),
+        done);
+  // 未启动的客户端直接在调用线程上恢复
+  ASSERT_EQ(future.wait_for(std::chrono::seconds(0)),
+            std::future_status::ready);
+  auto result = future.get();
+  EXPECT_FALSE(result.failed);
+  EXPECT_EQ(result.thread, std::this_thread::get_id());
+}
+
+#endif
@@ -0,0 +1,72 @@
+#include <darabonba/http/FileSink.hpp>
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <sys/stat.h>
+
+using namespace Darabonba::Http;
+
+namespace {
+std::string readFile(const std::string &path) {
+  std::ifstream ifs(path, std::ios::binary);
+  return std::string((std::istreambuf_iterator<char>(ifs)),
+                     std::istreambuf_iterator<char>());
+}
+} // namespace
+
+// ==================== FileSink 测试 ====================
+
+TEST(FileSinkTest, WriteToFile) {
+  {
+    FileSink sink("file_sink_test.txt");
+    ASSERT_TRUE(sink.isOpen());
+    EXPECT_EQ(sink.getPath(), "file_sink_test.txt");
+    char part1[] = "hello, ";
+    char part2[] = "file sink";
+    EXPECT_EQ(sink.write(part1, 7), 7u);
+    EXPECT_EQ(sink.write(part2, 9), 9u);
+    EXPECT_EQ(sink.getWrittenSize(), 16u);
+    // 没有用户态缓冲，关闭前即可读到
+    EXPECT_EQ(readFile("file_sink_test.txt"), "hello, file sink");
+  }
+  std::remove("file_sink_test.txt");
+}
+
+TEST(FileSinkTest, TruncatesExistingFile) {
+  {
+    std::ofstream ofs("file_sink_trunc.txt");
+    ofs << "old content";
+  }
+  {
+    FileSink sink("file_sink_trunc.txt");
+    char data[] = "new";
+    sink.write(data, 3);
+  }
+  EXPECT_EQ(readFile("file_sink_trunc.txt"), "new");
+  std::remove("file_sink_trunc.txt");
+}
+
+TEST(FileSinkTest, PreallocateKeepsSize) {
+  {
+    FileSink sink("file_sink_prealloc.txt");
+    EXPECT_TRUE(sink.preallocate(1024 * 1024));
+    char data[] = "short";
+    sink.write(data, 5);
+  }
+  // 预留空间不改变文件大小
+  struct stat st;
+  ASSERT_EQ(stat("file_sink_prealloc.txt", &st), 0);
+  EXPECT_EQ(st.st_size, 5);
+  std::remove("file_sink_prealloc.txt");
+}
+
+TEST(FileSinkTest, OpenFailure) {
+  FileSink sink("/nonexistent/dir/file_sink.txt");
+  EXPECT_FALSE(sink.isOpen());
+  char data[] = "x";
+  EXPECT_EQ(sink.write(data, 1), 0u);
+  EXPECT_FALSE(sink.preallocate(10));
+  sink.close();
+}
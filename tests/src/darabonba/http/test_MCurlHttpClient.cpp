@@ -1,3 +1,4 @@
+#include <darabonba/http/FileSink.hpp>
 #include <darabonba/http/MCurlHttpClient.hpp>
 #include <darabonba/http/Request.hpp>
 #include <darabonba/Core.hpp>
@@ -6,10 +7,43 @@
 #include <thread>
 #include <chrono>
 #include <memory>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <mutex>
+
+#include "LoopbackServer.hpp"
 
 using namespace Darabonba;
 using namespace Darabonba::Http;
 
+namespace {
+// 写入一个本地文件并返回 file:// URL，用于不依赖网络的请求测试
+std::string makeLocalFileUrl(const std::string &name,
+                             const std::string &content) {
+  {
+    std::ofstream ofs(name, std::ios::binary | std::ios::trunc);
+    ofs.write(content.data(), static_cast<std::streamsize>(content.size()));
+  }
+  char resolved[4096] = {0};
+#ifdef _WIN32
+  _fullpath(resolved, name.c_str(), sizeof(resolved));
+  std::string path(resolved);
+  std::replace(path.begin(), path.end(), '\\', '/');
+  return "file:///" + path;
+#else
+  if (realpath(name.c_str(), resolved) == nullptr) {
+    return "";
+  }
+  return std::string("file://") + resolved;
+#endif
+}
+} // namespace
+
 class MCurlHttpClientTest : public ::testing::Test {
 protected:
   virtual void SetUp() override {}
@@ -451,4 +485,1089 @@ TEST_F(MCurlHttpClientTest, ConcurrentResponseBodyRead) {
   }
 
   client.stop();
-}
\ No newline at end of file
+}
+
+// ==================== 多 perform loop 测试 ====================
+
+TEST_F(MCurlHttpClientTest, DefaultSinglePerformLoop) {
+  MCurlHttpClient client;
+  EXPECT_EQ(client.getPerformLoopCount(), 0u);
+  EXPECT_TRUE(client.start());
+  EXPECT_EQ(client.getPerformLoopCount(), 1u);
+  EXPECT_TRUE(client.stop());
+}
+
+TEST_F(MCurlHttpClientTest, MultiplePerformLoops) {
+  MCurlHttpClient client;
+  ConnectionPoolConfig config;
+  config.io_threads = 4;
+  client.setConnectionPoolConfig(config);
+
+  EXPECT_TRUE(client.start());
+  EXPECT_EQ(client.getPerformLoopCount(), 4u);
+  EXPECT_TRUE(client.stop());
+  // 重新启动时复用已创建的 loop
+  EXPECT_TRUE(client.start());
+  EXPECT_EQ(client.getPerformLoopCount(), 4u);
+  EXPECT_TRUE(client.stop());
+}
+
+TEST_F(MCurlHttpClientTest, RequestsShardedAcrossPerformLoops) {
+  std::string content(64 * 1024, 'x');
+  auto url = makeLocalFileUrl("perform_loop_test.txt", content);
+  ASSERT_FALSE(url.empty());
+
+  MCurlHttpClient client;
+  ConnectionPoolConfig config;
+  config.io_threads = 3;
+  client.setConnectionPoolConfig(config);
+  ASSERT_TRUE(client.start());
+
+  std::vector<std::future<std::shared_ptr<MCurlResponse>>> futures;
+  for (int i = 0; i < 30; ++i) {
+    Request request(url);
+    futures.push_back(client.makeRequest(request));
+  }
+  for (auto &f : futures) {
+    ASSERT_EQ(f.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    auto response = f.get();
+    ASSERT_NE(response, nullptr);
+    EXPECT_EQ(Stream::readAsString(response->getBody()), content);
+  }
+  EXPECT_EQ(client.getOutstandingCount(), 0u);
+
+  client.stop();
+  std::remove("perform_loop_test.txt");
+}
+
+TEST_F(MCurlHttpClientTest, FinishedBodyForgetsEasyHandle) {
+  std::string content(4 * 1024, 'f');
+  auto url = makeLocalFileUrl("finished_body_test.txt", content);
+  ASSERT_FALSE(url.empty());
+
+  MCurlHttpClient client;
+  ASSERT_TRUE(client.start());
+  Request request(url);
+  auto response = client.makeRequest(request).get();
+  ASSERT_NE(response, nullptr);
+  auto body = response->getBody();
+  body->waitForDone();
+  // 传输结束后 easy handle 可能已被其他请求复用，不能再恢复它
+  EXPECT_FALSE(body->fetch());
+  EXPECT_EQ(Stream::readAsString(body), content);
+
+  client.stop();
+  std::remove("finished_body_test.txt");
+}
+
+#ifndef _WIN32
+namespace {
+// 只发送部分响应体，然后保持连接直到客户端关闭
+void sendPartialBody(int fd) {
+  std::string buffer;
+  if (!Testing::LoopbackServer::readHead(fd, buffer))
+    return;
+  Testing::LoopbackServer::sendAll(
+      fd, "HTTP/1.1 200 OK\r\nContent-Length: 1000000\r\n\r\n" +
+              std::string(1000, 'd'));
+  char c;
+  recv(fd, &c, 1, 0);
+}
+
+// 在另一个线程中阻塞读取响应体，drop 丢弃传输后读取必须结束
+void expectDroppedBodyEnds(MCurlHttpClient &client,
+                           const std::string &url,
+                           const std::function<void()> &drop) {
+  Request request(url);
+  auto future = client.makeRequest(request);
+  ASSERT_EQ(future.wait_for(std::chrono::seconds(10)),
+            std::future_status::ready);
+  auto response = future.get();
+  ASSERT_NE(response, nullptr);
+  auto body = response->getBody();
+
+  // 分离的线程，读取卡住时测试失败而不是挂起
+  auto done = std::make_shared<std::promise<std::string>>();
+  auto reader = done->get_future();
+  std::thread([body, done]() {
+    done->set_value(Stream::readAsString(body));
+  }).detach();
+  EXPECT_EQ(reader.wait_for(std::chrono::milliseconds(200)),
+            std::future_status::timeout);
+  drop();
+  ASSERT_EQ(reader.wait_for(std::chrono::seconds(10)),
+            std::future_status::ready);
+  EXPECT_EQ(reader.get(), std::string(1000, 'd'));
+  EXPECT_TRUE(body->getDone());
+  EXPECT_TRUE(body->isAborted());
+  // waitForDone() 也不能等待
+  body->waitForDone();
+}
+} // namespace
+
+TEST_F(MCurlHttpClientTest, StopEndsDroppedBody) {
+  Testing::LoopbackServer server(sendPartialBody, true);
+  MCurlHttpClient client;
+  ASSERT_TRUE(client.start());
+  expectDroppedBodyEnds(client, server.url(), [&client]() { client.stop(); });
+}
+
+TEST_F(MCurlHttpClientTest, SharedReactorDetachEndsDroppedBody) {
+  Testing::LoopbackServer server(sendPartialBody, true);
+  auto reactor = std::make_shared<MCurlHttpClient::Reactor>(1);
+  ASSERT_TRUE(reactor->start());
+  std::unique_ptr<MCurlHttpClient> client(new MCurlHttpClient(reactor));
+  ASSERT_TRUE(client->start());
+  // 销毁客户端会从共享 reactor 上移除它的传输
+  expectDroppedBodyEnds(*client, server.url(), [&client]() { client.reset(); });
+  reactor->stop();
+}
+#endif
+
+TEST_F(MCurlHttpClientTest, CompletedBodyIsNotAborted) {
+  std::string content(4 * 1024, 'c');
+  auto url = makeLocalFileUrl("completed_body_test.txt", content);
+  ASSERT_FALSE(url.empty());
+
+  MCurlHttpClient client;
+  ASSERT_TRUE(client.start());
+  Request request(url);
+  auto response = client.makeRequest(request).get();
+  ASSERT_NE(response, nullptr);
+  EXPECT_EQ(Stream::readAsString(response->getBody()), content);
+  EXPECT_FALSE(response->getBody()->isAborted());
+
+  client.stop();
+  std::remove("completed_body_test.txt");
+}
+
+// ==================== 共享 Reactor 测试 ====================
+
+TEST_F(MCurlHttpClientTest, SharedReactorIsSingleton) {
+  auto reactor1 = MCurlHttpClient::Reactor::shared();
+  auto reactor2 = MCurlHttpClient::Reactor::shared();
+  ASSERT_NE(reactor1, nullptr);
+  EXPECT_EQ(reactor1, reactor2);
+  EXPECT_TRUE(reactor1->isRunning());
+  EXPECT_GE(reactor1->getLoopCount(), 1u);
+}
+
+TEST_F(MCurlHttpClientTest, SharedReactorPerLoopCount) {
+  auto reactor1 = MCurlHttpClient::Reactor::shared(3);
+  auto reactor2 = MCurlHttpClient::Reactor::shared(3);
+  ASSERT_NE(reactor1, nullptr);
+  EXPECT_EQ(reactor1, reactor2);
+  EXPECT_EQ(reactor1->getLoopCount(), 3u);
+  EXPECT_TRUE(reactor1->isRunning());
+  // 0 选择默认的共享 reactor
+  EXPECT_EQ(MCurlHttpClient::Reactor::shared(0),
+            MCurlHttpClient::Reactor::shared());
+}
+
+TEST_F(MCurlHttpClientTest, SharedReactorEventDriven) {
+  auto reactor = MCurlHttpClient::Reactor::shared(1, true);
+  ASSERT_NE(reactor, nullptr);
+  EXPECT_NE(reactor, MCurlHttpClient::Reactor::shared(1));
+  EXPECT_EQ(reactor, MCurlHttpClient::Reactor::shared(1, true));
+#ifdef __linux__
+  EXPECT_TRUE(reactor->isEventDriven());
+#endif
+  EXPECT_FALSE(MCurlHttpClient::Reactor::shared(1)->isEventDriven());
+}
+
+TEST_F(MCurlHttpClientTest, SharedReactorPerHttp2) {
+  // 未启用 http2 的传输不能落在多路复用的 reactor 上
+  auto reactor = MCurlHttpClient::Reactor::shared(1, false, true);
+  ASSERT_NE(reactor, nullptr);
+  EXPECT_NE(reactor, MCurlHttpClient::Reactor::shared(1));
+  EXPECT_EQ(reactor, MCurlHttpClient::Reactor::shared(1, false, true));
+  EXPECT_TRUE(reactor->getConnectionPoolConfig().http2);
+  EXPECT_FALSE(MCurlHttpClient::Reactor::shared(1)->getConnectionPoolConfig().http2);
+}
+
+TEST_F(MCurlHttpClientTest, SharedReactorTakesLargestStreams) {
+  auto reactor = std::make_shared<MCurlHttpClient::Reactor>(1);
+  MCurlHttpClient client1(reactor);
+  MCurlHttpClient client2(reactor);
+
+  ConnectionPoolConfig config;
+  config.http2 = true;
+  config.max_concurrent_streams = 300;
+  client1.setConnectionPoolConfig(config);
+  EXPECT_EQ(reactor->getConnectionPoolConfig().max_concurrent_streams, 300u);
+
+  // 较小的值不会降低其他客户端的上限
+  config.max_concurrent_streams = 50;
+  client2.setConnectionPoolConfig(config);
+  EXPECT_EQ(reactor->getConnectionPoolConfig().max_concurrent_streams, 300u);
+
+  // 未启用 http2 的客户端不影响该设置
+  config.http2 = false;
+  config.max_concurrent_streams = 500;
+  client2.setConnectionPoolConfig(config);
+  EXPECT_EQ(reactor->getConnectionPoolConfig().max_concurrent_streams, 300u);
+}
+
+TEST_F(MCurlHttpClientTest, ClientsShareReactorLoops) {
+  std::string content(16 * 1024, 'r');
+  auto url = makeLocalFileUrl("shared_reactor_test.txt", content);
+  ASSERT_FALSE(url.empty());
+
+  auto reactor = std::make_shared<MCurlHttpClient::Reactor>(2);
+  ASSERT_TRUE(reactor->start());
+
+  MCurlHttpClient client1(reactor);
+  MCurlHttpClient client2(reactor);
+  ASSERT_TRUE(client1.start());
+  ASSERT_TRUE(client2.start());
+  EXPECT_EQ(client1.getReactor(), client2.getReactor());
+  EXPECT_EQ(client1.getPerformLoopCount(), 2u);
+
+  std::vector<std::future<std::shared_ptr<MCurlResponse>>> futures;
+  for (int i = 0; i < 10; ++i) {
+    Request request(url);
+    futures.push_back((i % 2 ? client1 : client2).makeRequest(request));
+  }
+  for (auto &f : futures) {
+    ASSERT_EQ(f.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    auto response = f.get();
+    ASSERT_NE(response, nullptr);
+    EXPECT_EQ(Stream::readAsString(response->getBody()), content);
+  }
+
+  // 停止一个 client 不影响共享的 loop
+  EXPECT_TRUE(client1.stop());
+  EXPECT_TRUE(reactor->isRunning());
+  Request request(url);
+  auto response = client2.makeRequest(request).get();
+  ASSERT_NE(response, nullptr);
+  EXPECT_EQ(Stream::readAsString(response->getBody()), content);
+
+  client2.stop();
+  reactor->stop();
+  std::remove("shared_reactor_test.txt");
+}
+
+TEST_F(MCurlHttpClientTest, SharedReactorEnforcesHostLimit) {
+  std::string content(4 * 1024, 'l');
+  auto url = makeLocalFileUrl("host_limit_test.txt", content);
+  ASSERT_FALSE(url.empty());
+
+  auto reactor = std::make_shared<MCurlHttpClient::Reactor>(2);
+  ASSERT_TRUE(reactor->start());
+
+  MCurlHttpClient client(reactor);
+  ConnectionPoolConfig config;
+  config.max_host_connections = 1;
+  client.setConnectionPoolConfig(config);
+  ASSERT_TRUE(client.start());
+
+  std::vector<std::future<std::shared_ptr<MCurlResponse>>> futures;
+  for (int i = 0; i < 8; ++i) {
+    Request request(url);
+    futures.push_back(client.makeRequest(request));
+  }
+  EXPECT_LE(reactor->getOutstandingCount(), 1u);
+  for (auto &f : futures) {
+    ASSERT_EQ(f.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    auto response = f.get();
+    ASSERT_NE(response, nullptr);
+    EXPECT_EQ(Stream::readAsString(response->getBody()), content);
+  }
+  EXPECT_EQ(client.getOutstandingCount(), 0u);
+
+  client.stop();
+  reactor->stop();
+  std::remove("host_limit_test.txt");
+}
+
+TEST_F(MCurlHttpClientTest, DestroyClientOnSharedReactor) {
+  auto reactor = std::make_shared<MCurlHttpClient::Reactor>(1);
+  ASSERT_TRUE(reactor->start());
+  {
+    MCurlHttpClient client(reactor);
+    ASSERT_TRUE(client.start());
+    Request request(std::string("https://www.aliyun.com"));
+    auto future = client.makeRequest(request);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    // 析构时应从共享 loop 中移除该 client 的请求
+  }
+  EXPECT_EQ(reactor->getOutstandingCount(), 0u);
+  reactor->stop();
+}
+
+// ==================== Easy handle 复用测试 ====================
+
+namespace {
+bool waitForIdleHandles(const MCurlHttpClient &client, size_t count) {
+  for (int i = 0; i < 200; ++i) {
+    if (client.getEasyHandlePoolMetrics().size >= count)
+      return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  return false;
+}
+} // namespace
+
+TEST_F(MCurlHttpClientTest, EasyHandlesRecycledBetweenRequests) {
+  std::string content(8 * 1024, 'h');
+  auto url = makeLocalFileUrl("handle_pool_test.txt", content);
+  ASSERT_FALSE(url.empty());
+
+  MCurlHttpClient client;
+  ASSERT_TRUE(client.start());
+  EXPECT_EQ(client.getEasyHandlePoolMetrics().capacity, 16u);
+
+  for (int i = 0; i < 5; ++i) {
+    Request request(url);
+    auto future = client.makeRequest(request);
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(10)),
+              std::future_status::ready);
+    auto response = future.get();
+    ASSERT_NE(response, nullptr);
+    EXPECT_EQ(Stream::readAsString(response->getBody()), content);
+    ASSERT_TRUE(waitForIdleHandles(client, 1));
+  }
+
+  auto metrics = client.getEasyHandlePoolMetrics();
+  EXPECT_EQ(metrics.size, 1u);
+  EXPECT_EQ(metrics.misses, 1u);
+  EXPECT_EQ(metrics.hits, 4u);
+  EXPECT_DOUBLE_EQ(metrics.hitRate(), 0.8);
+
+  client.stop();
+  EXPECT_EQ(client.getEasyHandlePoolMetrics().size, 0u);
+  std::remove("handle_pool_test.txt");
+}
+
+TEST_F(MCurlHttpClientTest, EasyHandlePoolBounded) {
+  std::string content(4 * 1024, 'b');
+  auto url = makeLocalFileUrl("handle_pool_bound_test.txt", content);
+  ASSERT_FALSE(url.empty());
+
+  MCurlHttpClient client;
+  ConnectionPoolConfig config;
+  config.easy_handle_pool_size = 2;
+  client.setConnectionPoolConfig(config);
+  ASSERT_TRUE(client.start());
+
+  std::vector<std::future<std::shared_ptr<MCurlResponse>>> futures;
+  for (int i = 0; i < 6; ++i) {
+    Request request(url);
+    futures.push_back(client.makeRequest(request));
+  }
+  for (auto &f : futures) {
+    ASSERT_EQ(f.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    auto response = f.get();
+    ASSERT_NE(response, nullptr);
+    EXPECT_EQ(Stream::readAsString(response->getBody()), content);
+  }
+  ASSERT_TRUE(waitForIdleHandles(client, 2));
+  EXPECT_EQ(client.getEasyHandlePoolMetrics().size, 2u);
+
+  client.stop();
+  std::remove("handle_pool_bound_test.txt");
+}
+
+TEST_F(MCurlHttpClientTest, EasyHandlePoolDisabled) {
+  std::string content(1024, 'd');
+  auto url = makeLocalFileUrl("handle_pool_off_test.txt", content);
+  ASSERT_FALSE(url.empty());
+
+  MCurlHttpClient client;
+  ConnectionPoolConfig config;
+  config.easy_handle_pool_size = 0;
+  client.setConnectionPoolConfig(config);
+  ASSERT_TRUE(client.start());
+
+  for (int i = 0; i < 3; ++i) {
+    Request request(url);
+    auto response = client.makeRequest(request).get();
+    ASSERT_NE(response, nullptr);
+    EXPECT_EQ(Stream::readAsString(response->getBody()), content);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  auto metrics = client.getEasyHandlePoolMetrics();
+  EXPECT_EQ(metrics.size, 0u);
+  EXPECT_EQ(metrics.hits, 0u);
+  EXPECT_EQ(metrics.misses, 3u);
+
+  client.stop();
+  std::remove("handle_pool_off_test.txt");
+}
+
+// ==================== CurlShare 测试 ====================
+
+TEST_F(MCurlHttpClientTest, CurlShareDefaultData) {
+  CurlShare share;
+  ASSERT_NE(share.handle(), nullptr);
+  EXPECT_TRUE(share.shares(CurlShare::DNS));
+  EXPECT_TRUE(share.shares(CurlShare::SSL_SESSION));
+}
+
+TEST_F(MCurlHttpClientTest, CurlShareSelectedData) {
+  CurlShare share(CurlShare::DNS);
+  ASSERT_NE(share.handle(), nullptr);
+  EXPECT_TRUE(share.shares(CurlShare::DNS));
+  EXPECT_FALSE(share.shares(CurlShare::SSL_SESSION));
+}
+
+TEST_F(MCurlHttpClientTest, CurlShareIsSingleton) {
+  auto share1 = CurlShare::shared();
+  auto share2 = CurlShare::shared();
+  ASSERT_NE(share1, nullptr);
+  EXPECT_EQ(share1, share2);
+}
+
+TEST_F(MCurlHttpClientTest, ClientsShareCurlShare) {
+  std::string content(16 * 1024, 's');
+  auto url = makeLocalFileUrl("curl_share_test.txt", content);
+  ASSERT_FALSE(url.empty());
+
+  auto share = std::make_shared<CurlShare>();
+  auto reactor = std::make_shared<MCurlHttpClient::Reactor>(2);
+  ASSERT_TRUE(reactor->start());
+  {
+    MCurlHttpClient client1(reactor);
+    MCurlHttpClient client2(reactor);
+    client1.setCurlShare(share);
+    client2.setCurlShare(share);
+    EXPECT_EQ(client1.getCurlShare(), share);
+    ASSERT_TRUE(client1.start());
+    ASSERT_TRUE(client2.start());
+
+    std::vector<std::future<std::shared_ptr<MCurlResponse>>> futures;
+    for (int i = 0; i < 10; ++i) {
+      Request request(url);
+      futures.push_back((i % 2 ? client1 : client2).makeRequest(request));
+    }
+    for (auto &f : futures) {
+      ASSERT_EQ(f.wait_for(std::chrono::seconds(10)),
+                std::future_status::ready);
+      auto response = f.get();
+      ASSERT_NE(response, nullptr);
+      EXPECT_EQ(Stream::readAsString(response->getBody()), content);
+    }
+
+    // 之后的请求不再使用 share
+    client1.setCurlShare(nullptr);
+    Request request(url);
+    auto response = client1.makeRequest(request).get();
+    ASSERT_NE(response, nullptr);
+    EXPECT_EQ(Stream::readAsString(response->getBody()), content);
+  }
+  reactor->stop();
+  // 所有 easy handle 已释放，只剩本地引用
+  EXPECT_EQ(share.use_count(), 1);
+  std::remove("curl_share_test.txt");
+}
+
+// ==================== HTTP/2 测试 ====================
+
+TEST_F(MCurlHttpClientTest, Http2ModeRequests) {
+  std::string content(8 * 1024, '2');
+  auto url = makeLocalFileUrl("http2_mode_test.txt", content);
+  ASSERT_FALSE(url.empty());
+
+  MCurlHttpClient client;
+  ConnectionPoolConfig config;
+  config.http2 = true;
+  config.max_concurrent_streams = 10;
+  client.setConnectionPoolConfig(config);
+  ASSERT_TRUE(client.start());
+
+  std::vector<std::future<std::shared_ptr<MCurlResponse>>> futures;
+  for (int i = 0; i < 5; ++i) {
+    Request request(url);
+    futures.push_back(client.makeRequest(request));
+  }
+  for (auto &f : futures) {
+    ASSERT_EQ(f.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    auto response = f.get();
+    ASSERT_NE(response, nullptr);
+    EXPECT_EQ(Stream::readAsString(response->getBody()), content);
+  }
+
+  client.stop();
+  std::remove("http2_mode_test.txt");
+}
+
+TEST_F(MCurlHttpClientTest, Http2StreamsRaiseHostLimit) {
+  std::string content(4 * 1024, 'm');
+  auto url = makeLocalFileUrl("http2_limit_test.txt", content);
+  ASSERT_FALSE(url.empty());
+
+  auto reactor = std::make_shared<MCurlHttpClient::Reactor>(1);
+  ASSERT_TRUE(reactor->start());
+  MCurlHttpClient client(reactor);
+  ConnectionPoolConfig config;
+  config.max_host_connections = 1;
+  config.http2 = true;
+  config.max_concurrent_streams = 4;
+  client.setConnectionPoolConfig(config);
+  ASSERT_TRUE(client.start());
+
+  std::vector<std::future<std::shared_ptr<MCurlResponse>>> futures;
+  for (int i = 0; i < 8; ++i) {
+    Request request(url);
+    futures.push_back(client.makeRequest(request));
+  }
+  // 一个连接最多承载 4 个 stream
+  EXPECT_LE(reactor->getOutstandingCount(), 4u);
+  for (auto &f : futures) {
+    ASSERT_EQ(f.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    auto response = f.get();
+    ASSERT_NE(response, nullptr);
+    EXPECT_EQ(Stream::readAsString(response->getBody()), content);
+  }
+
+  client.stop();
+  reactor->stop();
+  std::remove("http2_limit_test.txt");
+}
+
+// ==================== RequestConfig 测试 ====================
+
+TEST_F(MCurlHttpClientTest, MakeRequestWithRequestConfig) {
+  std::string content(2 * 1024, 'c');
+  auto url = makeLocalFileUrl("request_config_test.txt", content);
+  ASSERT_FALSE(url.empty());
+
+  MCurlHttpClient client;
+  ASSERT_TRUE(client.start());
+
+  // 同一个 RequestConfig 可被多个请求复用
+  RequestConfig config;
+  config.connect_timeout_ms = 3000;
+  config.read_timeout_ms = 6000;
+  std::vector<std::future<std::shared_ptr<MCurlResponse>>> futures;
+  for (int i = 0; i < 3; ++i) {
+    Request request(url);
+    futures.push_back(client.makeRequest(request, config));
+  }
+  for (auto &f : futures) {
+    ASSERT_EQ(f.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    auto response = f.get();
+    ASSERT_NE(response, nullptr);
+    EXPECT_EQ(Stream::readAsString(response->getBody()), content);
+  }
+
+  client.stop();
+  std::remove("request_config_test.txt");
+}
+
+TEST_F(MCurlHttpClientTest, RequestConfigWatermarks) {
+  std::string content(64 * 1024, 'w');
+  auto url = makeLocalFileUrl("watermark_test.txt", content);
+  ASSERT_FALSE(url.empty());
+
+  MCurlHttpClient client;
+  ConnectionPoolConfig poolConfig;
+  poolConfig.max_buffered_bytes = 1024 * 1024;
+  client.setConnectionPoolConfig(poolConfig);
+  ASSERT_TRUE(client.start());
+
+  RequestConfig config;
+  config.buffer_high_watermark = 256 * 1024;
+  Request request(url);
+  auto future = client.makeRequest(request, config);
+  ASSERT_EQ(future.wait_for(std::chrono::seconds(10)),
+            std::future_status::ready);
+  auto body = future.get()->getBody();
+  EXPECT_EQ(body->getMaxSize(), 256u * 1024u);
+  EXPECT_EQ(body->getLowWatermark(), 128u * 1024u);
+  body->waitForDone();
+  EXPECT_EQ(client.getBufferedBytes(), content.size());
+  EXPECT_EQ(Stream::readAsString(body), content);
+  EXPECT_EQ(client.getBufferedBytes(), 0u);
+
+  // 运行时参数同样可以设置水位
+  auto optionsFuture = client.makeRequest(
+      request, Darabonba::Json{{"bufferHighWatermark", 512 * 1024},
+                               {"bufferLowWatermark", 32 * 1024}});
+  ASSERT_EQ(optionsFuture.wait_for(std::chrono::seconds(10)),
+            std::future_status::ready);
+  auto optionsBody = optionsFuture.get()->getBody();
+  EXPECT_EQ(optionsBody->getMaxSize(), 512u * 1024u);
+  EXPECT_EQ(optionsBody->getLowWatermark(), 32u * 1024u);
+  EXPECT_EQ(Stream::readAsString(optionsBody), content);
+
+  client.stop();
+  std::remove("watermark_test.txt");
+}
+
+TEST_F(MCurlHttpClientTest, SharedBufferBudget) {
+  std::string content(32 * 1024, 'b');
+  auto url = makeLocalFileUrl("buffer_budget_test.txt", content);
+  ASSERT_FALSE(url.empty());
+
+  auto budget = std::make_shared<BufferBudget>();
+  MCurlHttpClient first;
+  MCurlHttpClient second;
+  auto ownBudget = first.getBufferBudget();
+  first.setBufferBudget(budget);
+  second.setBufferBudget(budget);
+  ASSERT_TRUE(first.start());
+  ASSERT_TRUE(second.start());
+
+  Request request(url);
+  auto firstBody = first.makeRequest(request).get()->getBody();
+  auto secondBody = second.makeRequest(request).get()->getBody();
+  firstBody->waitForDone();
+  secondBody->waitForDone();
+  // 两个客户端的响应体计入同一个预算
+  EXPECT_EQ(budget->getCurrent(), 2 * content.size());
+  EXPECT_EQ(first.getBufferedBytes(), 2 * content.size());
+  EXPECT_EQ(Stream::readAsString(firstBody), content);
+  EXPECT_EQ(Stream::readAsString(secondBody), content);
+  EXPECT_EQ(budget->getCurrent(), 0u);
+  EXPECT_EQ(budget->getPeak(), 2 * content.size());
+
+  first.setBufferBudget(nullptr);
+  EXPECT_EQ(first.getBufferBudget(), ownBudget);
+
+  first.stop();
+  second.stop();
+  std::remove("buffer_budget_test.txt");
+}
+
+TEST_F(MCurlHttpClientTest, RequestConfigReadTimeout) {
+  MCurlHttpClient client;
+  ASSERT_TRUE(client.start());
+
+  // 10.255.255.1 不可路由，请求会在超时后以异常结束
+  RequestConfig config;
+  config.connect_timeout_ms = 100;
+  config.read_timeout_ms = 200;
+  Request request(std::string("http://10.255.255.1/"));
+  auto future = client.makeRequest(request, config);
+  ASSERT_EQ(future.wait_for(std::chrono::seconds(5)),
+            std::future_status::ready);
+  EXPECT_THROW(future.get(), Darabonba::ResponseException);
+
+  client.stop();
+}
+
+// ==================== 事件驱动 perform loop 测试 ====================
+
+TEST_F(MCurlHttpClientTest, EventDrivenDisabledByDefault) {
+  MCurlHttpClient client;
+  ASSERT_TRUE(client.start());
+  EXPECT_FALSE(client.getReactor()->isEventDriven());
+  client.stop();
+}
+
+TEST_F(MCurlHttpClientTest, EventDrivenRequests) {
+  std::string content(64 * 1024, 'e');
+  auto url = makeLocalFileUrl("event_driven_test.txt", content);
+  ASSERT_FALSE(url.empty());
+
+  MCurlHttpClient client;
+  ConnectionPoolConfig config;
+  config.io_threads = 2;
+  config.event_driven = true;
+  client.setConnectionPoolConfig(config);
+  ASSERT_TRUE(client.start());
+#ifdef __linux__
+  EXPECT_TRUE(client.getReactor()->isEventDriven());
+#endif
+
+  std::vector<std::future<std::shared_ptr<MCurlResponse>>> futures;
+  for (int i = 0; i < 20; ++i) {
+    Request request(url);
+    futures.push_back(client.makeRequest(request));
+  }
+  for (auto &f : futures) {
+    ASSERT_EQ(f.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    auto response = f.get();
+    ASSERT_NE(response, nullptr);
+    EXPECT_EQ(Stream::readAsString(response->getBody()), content);
+  }
+  EXPECT_EQ(client.getOutstandingCount(), 0u);
+
+  // 重新启动后仍然使用事件驱动
+  client.stop();
+  ASSERT_TRUE(client.start());
+  Request request(url);
+  auto future = client.makeRequest(request);
+  ASSERT_EQ(future.wait_for(std::chrono::seconds(10)),
+            std::future_status::ready);
+  EXPECT_EQ(Stream::readAsString(future.get()->getBody()), content);
+
+  client.stop();
+  std::remove("event_driven_test.txt");
+}
+
+#ifndef _WIN32
+TEST_F(MCurlHttpClientTest, EventDrivenSocketRequests) {
+  // 每个请求的响应体由路径决定，并发传输的数据不能串到其他请求上
+  Testing::LoopbackServer server(
+      [](int fd) {
+        std::string buffer;
+        std::string head;
+        while (Testing::LoopbackServer::readHead(fd, buffer, &head)) {
+          auto index = std::atoi(head.c_str() + head.find('/') + 1);
+          std::string body(256 * 1024, static_cast<char>('a' + index));
+          std::string response = "HTTP/1.1 200 OK\r\nContent-Length: " +
+                                 std::to_string(body.size()) + "\r\n\r\n" +
+                                 body;
+          if (!Testing::LoopbackServer::sendAll(fd, response))
+            return;
+        }
+      },
+      true);
+
+  MCurlHttpClient client;
+  ConnectionPoolConfig config;
+  config.io_threads = 2;
+  config.event_driven = true;
+  client.setConnectionPoolConfig(config);
+  ASSERT_TRUE(client.start());
+#ifdef __linux__
+  EXPECT_TRUE(client.getReactor()->isEventDriven());
+#endif
+
+  for (int round = 0; round < 2; ++round) {
+    std::vector<std::future<std::shared_ptr<MCurlResponse>>> futures;
+    for (int i = 0; i < 16; ++i) {
+      Request request(server.url("/" + std::to_string(i)));
+      futures.push_back(client.makeRequest(request));
+    }
+    for (int i = 0; i < 16; ++i) {
+      ASSERT_EQ(futures[i].wait_for(std::chrono::seconds(10)),
+                std::future_status::ready);
+      auto response = futures[i].get();
+      ASSERT_NE(response, nullptr);
+      EXPECT_EQ(response->getStatusCode(), 200);
+      EXPECT_EQ(Stream::readAsString(response->getBody()),
+                std::string(256 * 1024, static_cast<char>('a' + i)));
+    }
+  }
+  EXPECT_EQ(client.getOutstandingCount(), 0u);
+
+  client.stop();
+}
+#endif
+
+TEST_F(MCurlHttpClientTest, EventDrivenTimeout) {
+  MCurlHttpClient client;
+  ConnectionPoolConfig pool;
+  pool.event_driven = true;
+  client.setConnectionPoolConfig(pool);
+  ASSERT_TRUE(client.start());
+
+  // 超时只能由 curl 的定时器触发
+  RequestConfig config;
+  config.connect_timeout_ms = 100;
+  config.read_timeout_ms = 200;
+  Request request(std::string("http://10.255.255.1/"));
+  auto future = client.makeRequest(request, config);
+  ASSERT_EQ(future.wait_for(std::chrono::seconds(5)),
+            std::future_status::ready);
+  EXPECT_THROW(future.get(), Darabonba::ResponseException);
+
+  client.stop();
+}
+
+// ==================== 零拷贝响应体测试 ====================
+
+TEST_F(MCurlHttpClientTest, PeekResponseBody) {
+  std::string content(256 * 1024, 'p');
+  auto url = makeLocalFileUrl("peek_body_test.txt", content);
+  ASSERT_FALSE(url.empty());
+
+  MCurlHttpClient client;
+  ASSERT_TRUE(client.start());
+
+  Request request(url);
+  auto future = client.makeRequest(request);
+  ASSERT_EQ(future.wait_for(std::chrono::seconds(10)),
+            std::future_status::ready);
+  auto body = future.get()->getBody();
+  std::string result;
+  const char *data = nullptr;
+  size_t size = 0;
+  while ((size = body->peek(&data)) > 0) {
+    result.append(data, size);
+    body->consume(size);
+  }
+  EXPECT_EQ(result, content);
+
+  client.stop();
+  std::remove("peek_body_test.txt");
+}
+
+TEST_F(MCurlHttpClientTest, ResponseBodySink) {
+  std::string content(512 * 1024, 's');
+  auto url = makeLocalFileUrl("sink_body_test.txt", content);
+  ASSERT_FALSE(url.empty());
+
+  MCurlHttpClient client;
+  ASSERT_TRUE(client.start());
+
+  Request request(url);
+  auto future = client.makeRequest(request);
+  ASSERT_EQ(future.wait_for(std::chrono::seconds(10)),
+            std::future_status::ready);
+  auto body = future.get()->getBody();
+  auto sink = std::make_shared<OFStream>(
+      std::ofstream("sink_body_out.txt", std::ios::binary | std::ios::trunc));
+  ASSERT_TRUE(body->setSink(sink));
+  body->waitForDone();
+  sink->close();
+  EXPECT_EQ(body->getReadableSize(), 0u);
+
+  std::ifstream ifs("sink_body_out.txt", std::ios::binary);
+  std::string result((std::istreambuf_iterator<char>(ifs)),
+                     std::istreambuf_iterator<char>());
+  EXPECT_EQ(result, content);
+
+  client.stop();
+  std::remove("sink_body_test.txt");
+  std::remove("sink_body_out.txt");
+}
+
+TEST_F(MCurlHttpClientTest, DownloadToFile) {
+  std::string content;
+  for (int i = 0; i < 2 * 1024 * 1024; ++i) {
+    content.push_back(static_cast<char>('a' + i % 26));
+  }
+  auto url = makeLocalFileUrl("download_source.txt", content);
+  ASSERT_FALSE(url.empty());
+
+  MCurlHttpClient client;
+  ASSERT_TRUE(client.start());
+
+  Request request(url);
+  auto future =
+      client.makeRequest(request, RequestConfig(), "download_target.txt");
+  ASSERT_EQ(future.wait_for(std::chrono::seconds(10)),
+            std::future_status::ready);
+  auto response = future.get();
+  ASSERT_NE(response, nullptr);
+  auto body = response->getBody();
+  body->waitForDone();
+  // 数据由 perform 线程直接写入文件，不经过缓冲区
+  EXPECT_EQ(body->getReadableSize(), 0u);
+  EXPECT_EQ(client.getBufferedBytes(), 0u);
+  auto sink = std::dynamic_pointer_cast<FileSink>(body->getSink());
+  ASSERT_NE(sink, nullptr);
+  EXPECT_EQ(sink->getWrittenSize(), content.size());
+
+  std::ifstream ifs("download_target.txt", std::ios::binary);
+  std::string result((std::istreambuf_iterator<char>(ifs)),
+                     std::istreambuf_iterator<char>());
+  EXPECT_EQ(result, content);
+
+  client.stop();
+  std::remove("download_source.txt");
+  std::remove("download_target.txt");
+}
+
+TEST_F(MCurlHttpClientTest, DownloadToUnwritablePath) {
+  MCurlHttpClient client;
+  ASSERT_TRUE(client.start());
+  Request request(std::string("file:///dev/null"));
+  auto future = client.makeRequest(request, RequestConfig(),
+                                   "/nonexistent/dir/download.txt");
+  EXPECT_EQ(future.get(), nullptr);
+  client.stop();
+}
+
+TEST_F(MCurlHttpClientTest, DownloadToStream) {
+  std::string content(300 * 1024, 'o');
+  auto url = makeLocalFileUrl("download_stream_source.txt", content);
+  ASSERT_FALSE(url.empty());
+
+  MCurlHttpClient client;
+  ASSERT_TRUE(client.start());
+
+  auto sink = std::make_shared<OFStream>(std::ofstream(
+      "download_stream_target.txt", std::ios::binary | std::ios::trunc));
+  Request request(url);
+  auto future = client.makeRequest(request, RequestConfig(), sink);
+  ASSERT_EQ(future.wait_for(std::chrono::seconds(10)),
+            std::future_status::ready);
+  auto body = future.get()->getBody();
+  body->waitForDone();
+  sink->close();
+  EXPECT_EQ(body->getSink(), sink);
+  // 已经设置了 sink
+  EXPECT_FALSE(body->setSink(std::make_shared<OFStream>()));
+
+  std::ifstream ifs("download_stream_target.txt", std::ios::binary);
+  std::string result((std::istreambuf_iterator<char>(ifs)),
+                     std::istreambuf_iterator<char>());
+  EXPECT_EQ(result, content);
+
+  client.stop();
+  std::remove("download_stream_source.txt");
+  std::remove("download_stream_target.txt");
+}
+
+// ==================== 回调请求测试 ====================
+
+TEST_F(MCurlHttpClientTest, CallbackRunsOnPerformThread) {
+  auto url = makeLocalFileUrl("callback_test.txt", "callback");
+  ASSERT_FALSE(url.empty());
+
+  MCurlHttpClient client;
+  ASSERT_TRUE(client.start());
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool done = false;
+  std::shared_ptr<MCurlResponse> result;
+  std::thread::id callbackThread;
+  client.makeRequest(
+      Request(url), RequestConfig(),
+      [&](std::shared_ptr<MCurlResponse> response, std::exception_ptr error) {
+        std::lock_guard<std::mutex> lock(mutex);
+        EXPECT_FALSE(error);
+        result = std::move(response);
+        callbackThread = std::this_thread::get_id();
+        done = true;
+        cv.notify_all();
+      });
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(10),
+                            [&done]() { return done; }));
+  }
+  ASSERT_NE(result, nullptr);
+  EXPECT_NE(callbackThread, std::this_thread::get_id());
+  EXPECT_EQ(Stream::readAsString(result->getBody()), "callback");
+
+  client.stop();
+  std::remove("callback_test.txt");
+}
+
+TEST_F(MCurlHttpClientTest, CallbackWithExecutor) {
+  std::string content(64 * 1024, 'e');
+  auto url = makeLocalFileUrl("callback_executor_test.txt", content);
+  ASSERT_FALSE(url.empty());
+
+  MCurlHttpClient client;
+  ASSERT_TRUE(client.start());
+
+  // 测试线程作为执行器，回调中可以阻塞读取响应体
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<std::function<void()>> tasks;
+  MCurlHttpClient::Executor executor = [&](std::function<void()> task) {
+    std::lock_guard<std::mutex> lock(mutex);
+    tasks.push_back(std::move(task));
+    cv.notify_all();
+  };
+
+  const int requests = 64;
+  int completed = 0;
+  size_t totalRead = 0;
+  for (int i = 0; i < requests; ++i) {
+    client.makeRequest(
+        Request(url), RequestConfig(),
+        [&](std::shared_ptr<MCurlResponse> response, std::exception_ptr error) {
+          ASSERT_FALSE(error);
+          ASSERT_NE(response, nullptr);
+          totalRead += Stream::readAsString(response->getBody()).size();
+          ++completed;
+        },
+        executor);
+  }
+  while (completed < requests) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(10),
+                              [&tasks]() { return !tasks.empty(); }));
+      task = std::move(tasks.front());
+      tasks.pop_front();
+    }
+    task();
+  }
+  EXPECT_EQ(totalRead, content.size() * requests);
+
+  client.stop();
+  std::remove("callback_executor_test.txt");
+}
+
+TEST_F(MCurlHttpClientTest, CallbackWithoutStart) {
+  MCurlHttpClient client;
+  bool called = false;
+  client.makeRequest(
+      Request(std::string("file:///dev/null")), RequestConfig(),
+      [&called](std::shared_ptr<MCurlResponse> response,
+                std::exception_ptr error) {
+        // 与 future 相同，未启动时得到空响应
+        EXPECT_EQ(response, nullptr);
+        EXPECT_FALSE(error);
+        called = true;
+      });
+  EXPECT_TRUE(called);
+}
+
+TEST_F(MCurlHttpClientTest, CallbackNetworkError) {
+  MCurlHttpClient client;
+  ASSERT_TRUE(client.start());
+
+  std::promise<std::exception_ptr> promise;
+  auto future = promise.get_future();
+  RequestConfig config;
+  config.connect_timeout_ms = 2000;
+  client.makeRequest(
+      Request(std::string("http://127.0.0.1:1/")), config,
+      [&promise](std::shared_ptr<MCurlResponse> response,
+                 std::exception_ptr error) {
+        EXPECT_EQ(response, nullptr);
+        promise.set_value(error);
+      });
+  ASSERT_EQ(future.wait_for(std::chrono::seconds(10)),
+            std::future_status::ready);
+  auto error = future.get();
+  ASSERT_TRUE(error);
+  EXPECT_THROW(std::rethrow_exception(error), ResponseException);
+
+  client.stop();
+}
+
+TEST_F(MCurlHttpClientTest, CallbackMayReleaseClient) {
+  auto reactor = std::make_shared<MCurlHttpClient::Reactor>(1);
+  ASSERT_TRUE(reactor->start());
+  auto client = std::make_shared<MCurlHttpClient>(reactor);
+  ASSERT_TRUE(client->start());
+
+  // 回调中释放客户端的最后一个引用，perform 线程此后不再访问它
+  auto holder = std::make_shared<std::shared_ptr<MCurlHttpClient>>(client);
+  std::weak_ptr<MCurlHttpClient> weak = client;
+  client.reset();
+  std::promise<bool> promise;
+  auto future = promise.get_future();
+  RequestConfig config;
+  config.connect_timeout_ms = 2000;
+  (*holder)->makeRequest(
+      Request(std::string("http://127.0.0.1:1/")), config,
+      [holder, &promise](std::shared_ptr<MCurlResponse>,
+                         std::exception_ptr error) {
+        holder->reset();
+        promise.set_value(error != nullptr);
+      });
+  ASSERT_EQ(future.wait_for(std::chrono::seconds(10)),
+            std::future_status::ready);
+  EXPECT_TRUE(future.get());
+  EXPECT_TRUE(weak.expired());
+
+  // perform loop 仍能处理其他请求
+  std::promise<bool> next;
+  MCurlHttpClient other(reactor);
+  ASSERT_TRUE(other.start());
+  other.makeRequest(Request(std::string("http://127.0.0.1:1/")), config,
+                    [&next](std::shared_ptr<MCurlResponse>,
+                            std::exception_ptr error) {
+                      next.set_value(error != nullptr);
+                    });
+  auto nextFuture = next.get_future();
+  ASSERT_EQ(nextFuture.wait_for(std::chrono::seconds(10)),
+            std::future_status::ready);
+  other.stop();
+  reactor->stop();
+}
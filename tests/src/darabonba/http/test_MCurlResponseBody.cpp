@@ -17,6 +17,12 @@ public:
   using MCurlResponseBody::streamCV_;
   using MCurlResponseBody::doneCV_;
   using MCurlResponseBody::ready_;
+  using MCurlResponseBody::streamMutex_;
+  using MCurlResponseBody::paused_;
+  using MCurlResponseBody::budget_;
+  using MCurlResponseBody::shouldPause;
+  using MCurlResponseBody::finish;
+  using MCurlResponseBody::resume;
 };
 
 class MCurlResponseBodyTest : public ::testing::Test {
@@ -374,4 +380,264 @@ TEST_F(MCurlResponseBodyTest, MultipleWritesNotifyMultipleReads) {
 
   // 应该成功读取多次
   EXPECT_GT(readsCompleted.load(), 0);
-}
\ No newline at end of file
+}
+// ==================== 零拷贝读取测试 ====================
+
+namespace {
+// 收集写入数据的 sink
+class StringSink : public OStream {
+public:
+  virtual size_t write(char *buffer, size_t expectSize) override {
+    data.append(buffer, expectSize);
+    return expectSize;
+  }
+  std::string data;
+};
+} // namespace
+
+TEST_F(MCurlResponseBodyTest, PeekAndConsume) {
+  TestableMCurlResponseBody body;
+
+  char data[] = "Hello, World!";
+  body.write(data, strlen(data));
+
+  const char *span = nullptr;
+  size_t size = body.peek(&span);
+  ASSERT_EQ(size, strlen(data));
+  EXPECT_EQ(std::string(span, size), "Hello, World!");
+  // peek 不会移除数据
+  EXPECT_EQ(body.getReadableSize(), strlen(data));
+
+  body.consume(7);
+  EXPECT_EQ(body.getReadableSize(), 6u);
+  size = body.peek(&span);
+  EXPECT_EQ(std::string(span, size), "World!");
+  body.consume(size);
+  EXPECT_EQ(body.getReadableSize(), 0u);
+
+  body.done_ = true;
+  EXPECT_EQ(body.peek(&span), 0u);
+  EXPECT_EQ(span, nullptr);
+}
+
+TEST_F(MCurlResponseBodyTest, PeekAcrossSegments) {
+  TestableMCurlResponseBody body;
+
+  // 跨越多个 4KB 段的数据，peek 每次只返回一段连续的数据
+  std::string content;
+  for (int i = 0; i < 20000; ++i) {
+    content.push_back(static_cast<char>('a' + i % 26));
+  }
+  body.write(&content[0], content.size());
+  body.done_ = true;
+
+  std::string result;
+  const char *span = nullptr;
+  size_t size = 0;
+  while ((size = body.peek(&span)) > 0) {
+    EXPECT_LE(size, 4096u);
+    result.append(span, size);
+    body.consume(size);
+  }
+  EXPECT_EQ(result, content);
+  EXPECT_TRUE(body.isFinished());
+}
+
+TEST_F(MCurlResponseBodyTest, PeekWaitsForData) {
+  TestableMCurlResponseBody body;
+  std::string result;
+
+  std::thread readThread([&]() {
+    const char *span = nullptr;
+    size_t size = 0;
+    while ((size = body.peek(&span)) > 0) {
+      result.append(span, size);
+      body.consume(size);
+    }
+  });
+
+  char data1[] = "first";
+  char data2[] = "second";
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  body.write(data1, strlen(data1));
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  body.write(data2, strlen(data2));
+  {
+    std::lock_guard<std::mutex> lock(body.streamMutex_);
+    body.done_ = true;
+  }
+  body.streamCV_.notify_one();
+  readThread.join();
+
+  EXPECT_EQ(result, "firstsecond");
+}
+
+TEST_F(MCurlResponseBodyTest, SinkReceivesBufferedAndLaterData) {
+  TestableMCurlResponseBody body;
+  auto sink = std::make_shared<StringSink>();
+
+  char data1[] = "buffered,";
+  body.write(data1, strlen(data1));
+  EXPECT_TRUE(body.setSink(sink));
+  // 已缓冲的数据转移到 sink
+  EXPECT_EQ(sink->data, "buffered,");
+  EXPECT_EQ(body.getReadableSize(), 0u);
+
+  // 之后的数据直接写入 sink，不经过缓冲区
+  char data2[] = "direct";
+  EXPECT_EQ(body.write(data2, strlen(data2)), strlen(data2));
+  EXPECT_EQ(sink->data, "buffered,direct");
+  EXPECT_EQ(body.getReadableSize(), 0u);
+  EXPECT_EQ(body.getSink(), sink);
+
+  // 只能设置一次
+  EXPECT_FALSE(body.setSink(std::make_shared<StringSink>()));
+  EXPECT_FALSE(body.setSink(nullptr));
+}
+
+// ==================== 可读通知测试 ====================
+
+TEST_F(MCurlResponseBodyTest, NotifyWhenReadableOnWrite) {
+  TestableMCurlResponseBody body;
+  int calls = 0;
+  EXPECT_FALSE(body.isReadable());
+  EXPECT_TRUE(body.notifyWhenReadable([&calls]() { ++calls; }));
+  // 已有等待中的回调
+  EXPECT_FALSE(body.notifyWhenReadable([]() {}));
+
+  char data[] = "data";
+  body.write(data, strlen(data));
+  // 没有 client 时在写入线程上调用，只调用一次
+  EXPECT_EQ(calls, 1);
+  body.write(data, strlen(data));
+  EXPECT_EQ(calls, 1);
+  EXPECT_TRUE(body.isReadable());
+}
+
+TEST_F(MCurlResponseBodyTest, NotifyWhenReadableAlreadyReadable) {
+  TestableMCurlResponseBody body;
+  char data[] = "data";
+  body.write(data, strlen(data));
+  bool called = false;
+  EXPECT_FALSE(body.notifyWhenReadable([&called]() { called = true; }));
+  EXPECT_FALSE(called);
+}
+
+TEST_F(MCurlResponseBodyTest, NotifyWhenReadableOnFinish) {
+  TestableMCurlResponseBody body;
+  bool called = false;
+  EXPECT_TRUE(body.notifyWhenReadable([&called]() { called = true; }));
+  body.finish();
+  EXPECT_TRUE(called);
+  EXPECT_TRUE(body.isReadable());
+  char buffer[8];
+  EXPECT_EQ(body.read(buffer, sizeof(buffer)), 0u);
+}
+
+// ==================== 流量控制测试 ====================
+
+TEST_F(MCurlResponseBodyTest, SetWatermarks) {
+  TestableMCurlResponseBody body;
+  EXPECT_EQ(body.getLowWatermark(), 5u * 1024u * 1024u);
+
+  body.setWatermarks(256 * 1024, 64 * 1024);
+  EXPECT_EQ(body.getMaxSize(), 256u * 1024u);
+  EXPECT_EQ(body.getLowWatermark(), 64u * 1024u);
+
+  // 低水位为 0 或不低于高水位时取高水位的一半
+  body.setWatermarks(1000, 0);
+  EXPECT_EQ(body.getLowWatermark(), 500u);
+  body.setWatermarks(1000, 2000);
+  EXPECT_EQ(body.getLowWatermark(), 500u);
+  body.setMaxSize(4000);
+  EXPECT_EQ(body.getMaxSize(), 4000u);
+  EXPECT_EQ(body.getLowWatermark(), 2000u);
+}
+
+TEST_F(MCurlResponseBodyTest, PauseAtHighWatermark) {
+  TestableMCurlResponseBody body;
+  body.setWatermarks(100, 40);
+  std::string data(60, 'w');
+  EXPECT_FALSE(body.shouldPause());
+  body.write(&data[0], data.size());
+  EXPECT_FALSE(body.shouldPause());
+  body.write(&data[0], data.size());
+  EXPECT_TRUE(body.shouldPause());
+}
+
+TEST_F(MCurlResponseBodyTest, ResumeBelowLowWatermark) {
+  TestableMCurlResponseBody body;
+  body.setWatermarks(100, 40);
+  std::string data(120, 'h');
+  body.write(&data[0], data.size());
+  body.paused_ = true;
+
+  // 高于低水位时保持暂停
+  char out[50];
+  EXPECT_EQ(body.read(out, sizeof(out)), 50u);
+  EXPECT_TRUE(body.paused_);
+  EXPECT_EQ(body.read(out, sizeof(out)), 50u);
+  EXPECT_FALSE(body.paused_);
+}
+
+TEST_F(MCurlResponseBodyTest, FinishClearsPause) {
+  TestableMCurlResponseBody body;
+  body.paused_ = true;
+  body.finish();
+  EXPECT_FALSE(body.paused_);
+  // 结束后的 body 不再恢复传输
+  body.paused_ = true;
+  EXPECT_FALSE(body.resume());
+  EXPECT_FALSE(body.paused_);
+}
+
+TEST_F(MCurlResponseBodyTest, BudgetAccounting) {
+  auto budget = std::make_shared<BufferBudget>();
+  {
+    TestableMCurlResponseBody body;
+    body.budget_ = budget;
+    std::string data(300, 'a');
+    body.write(&data[0], data.size());
+    EXPECT_EQ(budget->getCurrent(), 300u);
+
+    char out[100];
+    body.read(out, sizeof(out));
+    EXPECT_EQ(budget->getCurrent(), 200u);
+    const char *span = nullptr;
+    auto size = body.peek(&span);
+    body.consume(size);
+    EXPECT_EQ(budget->getCurrent(), 200u - size);
+    EXPECT_EQ(budget->getPeak(), 300u);
+  }
+  // 未读取的数据在析构时归还
+  EXPECT_EQ(budget->getCurrent(), 0u);
+}
+
+TEST_F(MCurlResponseBodyTest, BudgetPausesLargestHolder) {
+  auto budget = std::make_shared<BufferBudget>(900);
+  TestableMCurlResponseBody large;
+  TestableMCurlResponseBody small;
+  TestableMCurlResponseBody empty;
+  large.budget_ = budget;
+  small.budget_ = budget;
+  empty.budget_ = budget;
+  std::string data(1000, 'c');
+  large.write(&data[0], data.size());
+  small.write(&data[0], 10);
+  // 每个数据块到来前统计持有数据的响应体，只暂停持有超过平均份额的
+  EXPECT_FALSE(small.shouldPause());
+  EXPECT_TRUE(large.shouldPause());
+  EXPECT_EQ(budget->getMetrics().holders, 2u);
+
+  // 空的响应体总能接收下一块数据
+  EXPECT_FALSE(empty.shouldPause());
+  EXPECT_EQ(budget->getMetrics().holders, 2u);
+
+  // 超出上限的 1/4 后所有持有数据的响应体都暂停
+  small.write(&data[0], 200);
+  EXPECT_TRUE(small.shouldPause());
+  EXPECT_FALSE(empty.shouldPause());
+
+  budget->setLimit(0);
+  EXPECT_FALSE(large.shouldPause());
+}
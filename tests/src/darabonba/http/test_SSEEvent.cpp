@@ -0,0 +1,84 @@
+#include <darabonba/http/SSEEvent.hpp>
+#include <gtest/gtest.h>
+#include <string>
+#include <utility>
+
+using namespace Darabonba;
+using namespace Darabonba::Http;
+
+// ==================== SSEEvent 测试 ====================
+
+TEST(SSEEventTest, DefaultIsEmpty) {
+  SSEEvent event;
+  EXPECT_TRUE(event.empty());
+  EXPECT_FALSE(event.hasId());
+  EXPECT_EQ(event.getId(), "");
+  EXPECT_EQ(event.getData(), "");
+  EXPECT_EQ(event.getRetry(), 0);
+  EXPECT_TRUE(event.toMap().is_null());
+}
+
+TEST(SSEEventTest, SettersMarkFields) {
+  SSEEvent event;
+  event.setData(std::string("hello"));
+  event.setRetry(0);
+  EXPECT_FALSE(event.empty());
+  EXPECT_TRUE(event.hasData());
+  // retry 为 0 也是已设置
+  EXPECT_TRUE(event.hasRetry());
+  EXPECT_FALSE(event.hasEvent());
+
+  auto map = event.toMap();
+  EXPECT_EQ(map["data"], "hello");
+  EXPECT_EQ(map["retry"], 0);
+  EXPECT_FALSE(map.contains("id"));
+  EXPECT_FALSE(map.contains("event"));
+
+  event.clear();
+  EXPECT_TRUE(event.empty());
+  EXPECT_EQ(event.getData(), "");
+}
+
+TEST(SSEEventTest, ConstructorLeavesDefaultsUnset) {
+  SSEEvent event("1", "", "data");
+  EXPECT_TRUE(event.hasId());
+  EXPECT_FALSE(event.hasEvent());
+  EXPECT_TRUE(event.hasData());
+  EXPECT_FALSE(event.hasRetry());
+}
+
+TEST(SSEEventTest, FromMap) {
+  Json map;
+  map["id"] = "7";
+  map["event"] = "update";
+  map["data"] = "payload";
+  map["retry"] = 1000;
+  SSEEvent event(map);
+  EXPECT_EQ(event.getId(), "7");
+  EXPECT_EQ(event.getEvent(), "update");
+  EXPECT_EQ(event.getData(), "payload");
+  EXPECT_EQ(event.getRetry(), 1000);
+  EXPECT_EQ(event.toMap(), map);
+
+  // null 清除字段，缺少的字段保持不变
+  Json update;
+  update["id"] = nullptr;
+  update["data"] = 42;
+  event.fromMap(update);
+  EXPECT_FALSE(event.hasId());
+  EXPECT_EQ(event.getData(), "42");
+  EXPECT_EQ(event.getEvent(), "update");
+}
+
+TEST(SSEEventTest, CopyAndMove) {
+  SSEEvent event;
+  event.setId("1");
+  event.setData(std::string(100, 'x'));
+  SSEEvent copy(event);
+  EXPECT_EQ(copy.getData(), event.getData());
+  EXPECT_TRUE(copy.hasId());
+
+  SSEEvent moved(std::move(event));
+  EXPECT_EQ(moved.getData().size(), 100u);
+  EXPECT_TRUE(moved.hasData());
+}
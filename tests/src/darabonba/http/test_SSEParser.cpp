@@ -0,0 +1,169 @@
+#include <darabonba/http/MCurlResponse.hpp>
+#include <darabonba/http/SSEParser.hpp>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Darabonba;
+using namespace Darabonba::Http;
+
+namespace {
+class TestableMCurlResponseBody : public MCurlResponseBody {
+public:
+  using MCurlResponseBody::done_;
+  using MCurlResponseBody::streamCV_;
+};
+
+std::vector<SSEEvent> parseAll(SSEParser &parser) {
+  std::vector<SSEEvent> events;
+  SSEEvent event;
+  while (parser.next(event)) {
+    events.push_back(event);
+  }
+  return events;
+}
+} // namespace
+
+// ==================== SSEParser 测试 ====================
+
+TEST(SSEParserTest, ParsesFields) {
+  SSEParser parser;
+  auto count =
+      parser.feed("id: 1\nevent: update\nretry: 3000\ndata: hello\n\n");
+  EXPECT_EQ(count, 1u);
+  auto events = parseAll(parser);
+  ASSERT_EQ(events.size(), 1u);
+  EXPECT_EQ(events[0].getId(), "1");
+  EXPECT_EQ(events[0].getEvent(), "update");
+  EXPECT_EQ(events[0].getData(), "hello");
+  EXPECT_EQ(events[0].getRetry(), 3000);
+  EXPECT_EQ(parser.getRetry(), 3000);
+  EXPECT_EQ(parser.getLastEventId(), "1");
+}
+
+TEST(SSEParserTest, JoinsMultiLineData) {
+  SSEParser parser;
+  parser.feed("data: first\ndata:second\ndata\n\n");
+  auto events = parseAll(parser);
+  ASSERT_EQ(events.size(), 1u);
+  // 只去掉冒号后的一个空格，多行之间以 \n 连接
+  EXPECT_EQ(events[0].getData(), "first\nsecond\n");
+}
+
+TEST(SSEParserTest, IgnoresCommentsAndUnknownFields) {
+  SSEParser parser;
+  parser.feed(": keep-alive\nfoo: bar\nretry: 1x\ndata: x\n\n");
+  auto events = parseAll(parser);
+  ASSERT_EQ(events.size(), 1u);
+  EXPECT_EQ(events[0].getData(), "x");
+  EXPECT_EQ(events[0].getRetry(), 0);
+  EXPECT_EQ(parser.getRetry(), -1);
+}
+
+TEST(SSEParserTest, EventWithoutDataIsNotDispatched) {
+  SSEParser parser;
+  EXPECT_EQ(parser.feed("event: ping\n\nid: 7\n\ndata: a\n\n"), 1u);
+  auto events = parseAll(parser);
+  ASSERT_EQ(events.size(), 1u);
+  // 类型不会带到下一个事件，id 会保留
+  EXPECT_EQ(events[0].getEvent(), "");
+  EXPECT_EQ(events[0].getId(), "7");
+  EXPECT_FALSE(events[0].isIdFromField());
+}
+
+TEST(SSEParserTest, InheritedIdIsNotFromField) {
+  SSEParser parser;
+  parser.feed("id: 1\ndata: a\n\ndata: b\n\n");
+  parser.restart();
+  parser.feed("data: c\n\n");
+  auto events = parseAll(parser);
+  ASSERT_EQ(events.size(), 3u);
+  EXPECT_TRUE(events[0].isIdFromField());
+  // 后续事件继承 id，但并未携带 id 字段
+  EXPECT_EQ(events[1].getId(), "1");
+  EXPECT_FALSE(events[1].isIdFromField());
+  EXPECT_EQ(events[2].getId(), "1");
+  EXPECT_FALSE(events[2].isIdFromField());
+}
+
+TEST(SSEParserTest, LineEndings) {
+  SSEParser parser;
+  parser.feed("data: crlf\r\n\r\ndata: cr\r\rdata: lf\n\n");
+  auto events = parseAll(parser);
+  ASSERT_EQ(events.size(), 3u);
+  EXPECT_EQ(events[0].getData(), "crlf");
+  EXPECT_EQ(events[1].getData(), "cr");
+  EXPECT_EQ(events[2].getData(), "lf");
+}
+
+TEST(SSEParserTest, ChunksSplitAnywhere) {
+  std::string stream = "\xEF\xBB\xBF"
+                       "id: 42\r\ndata: hello\r\ndata: world\r\n\r\n"
+                       "event: done\r\ndata: bye\r\n\r\n";
+  // 每个字节单独输入，行和 CRLF 都被拆开
+  SSEParser parser;
+  for (char c : stream) {
+    parser.feed(&c, 1);
+  }
+  auto events = parseAll(parser);
+  ASSERT_EQ(events.size(), 2u);
+  EXPECT_EQ(events[0].getId(), "42");
+  EXPECT_EQ(events[0].getData(), "hello\nworld");
+  EXPECT_EQ(events[1].getEvent(), "done");
+  EXPECT_EQ(events[1].getData(), "bye");
+}
+
+TEST(SSEParserTest, CallbackAndFinish) {
+  std::vector<std::string> data;
+  SSEParser parser(
+      [&data](const SSEEvent &event) { data.push_back(event.getData()); });
+  parser.feed("data: 1\n\ndata: 2\n\ndata: incomplete\n");
+  parser.finish();
+  EXPECT_EQ(parser.pendingEvents(), 0u);
+  ASSERT_EQ(data.size(), 2u);
+  EXPECT_EQ(data[1], "2");
+
+  // 未结束的事件被丢弃，之后的流重新开始
+  parser.feed("data: 3\n\n");
+  ASSERT_EQ(data.size(), 3u);
+  EXPECT_EQ(data[2], "3");
+}
+
+// ==================== SSEReader 测试 ====================
+
+TEST(SSEReaderTest, IteratesStream) {
+  auto body = std::make_shared<ISStream>(
+      std::string("data: a\n\ndata: b\n\nid: 3\ndata: c\n\n"));
+  std::vector<std::string> data;
+  for (auto &event : SSEReader(body)) {
+    data.push_back(event.getData());
+  }
+  ASSERT_EQ(data.size(), 3u);
+  EXPECT_EQ(data[0], "a");
+  EXPECT_EQ(data[2], "c");
+}
+
+TEST(SSEReaderTest, ReadsResponseBody) {
+  auto body = std::make_shared<TestableMCurlResponseBody>();
+  std::thread writer([body]() {
+    std::string chunks[] = {"data: fir", "st\n\nda", "ta: second\n", "\n"};
+    for (auto &chunk : chunks) {
+      body->write(&chunk[0], chunk.size());
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    body->done_ = true;
+    body->streamCV_.notify_all();
+  });
+
+  SSEReader reader(body);
+  std::vector<std::string> data;
+  auto count = reader.forEach(
+      [&data](const SSEEvent &event) { data.push_back(event.getData()); });
+  writer.join();
+  EXPECT_EQ(count, 2u);
+  ASSERT_EQ(data.size(), 2u);
+  EXPECT_EQ(data[0], "first");
+  EXPECT_EQ(data[1], "second");
+  EXPECT_EQ(body->getReadableSize(), 0u);
+}
@@ -0,0 +1,248 @@
+#include <darabonba/http/MCurlHttpClient.hpp>
+#include <darabonba/http/Request.hpp>
+#include <darabonba/http/SSESession.hpp>
+#include <darabonba/policy/Retry.hpp>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LoopbackServer.hpp"
+
+using namespace Darabonba;
+using namespace Darabonba::Http;
+
+namespace {
+std::shared_ptr<Policy::BackoffPolicy> fixedBackoff(int period) {
+  Json option;
+  option["policy"] = "Fixed";
+  option["period"] = period;
+  return std::make_shared<Policy::FixedBackoffPolicy>(option);
+}
+
+#ifndef _WIN32
+// 按连接顺序返回预设响应的本地服务器，每个连接只处理一个请求
+class ScriptedServer {
+public:
+  // gapMs > 0 时逐个事件发送，事件之间间隔 gapMs 毫秒
+  explicit ScriptedServer(std::vector<std::string> responses, int gapMs = 0)
+      : responses_(std::move(responses)), gapMs_(gapMs),
+        server_([this](int fd) { handle(fd); }) {}
+
+  std::string url() const { return server_.url("/events"); }
+
+  std::vector<std::string> requests() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return requests_;
+  }
+
+private:
+  void handle(int fd) {
+    std::string buffer;
+    std::string head;
+    Testing::LoopbackServer::readHead(fd, buffer, &head);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      requests_.push_back(head);
+    }
+    const auto &response =
+        index_ < responses_.size() ? responses_[index_] : responses_.back();
+    ++index_;
+    size_t sent = 0;
+    while (sent < response.size()) {
+      auto end = gapMs_ > 0 ? response.find("\n\n", sent) : std::string::npos;
+      end = end == std::string::npos ? response.size() : end + 2;
+      if (sent > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(gapMs_));
+      }
+      Testing::LoopbackServer::sendAll(fd, response.data() + sent, end - sent);
+      sent = end;
+    }
+  }
+
+  std::vector<std::string> responses_;
+  std::vector<std::string> requests_;
+  int gapMs_ = 0;
+  size_t index_ = 0;
+  std::mutex mutex_;
+  // 最后构造，服务线程启动时其他成员已就绪
+  Testing::LoopbackServer server_;
+};
+
+std::string eventStream(const std::string &payload) {
+  return "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n"
+         "Connection: close\r\n\r\n" +
+         payload;
+}
+
+const char *const noContent =
+    "HTTP/1.1 204 No Content\r\nConnection: close\r\n\r\n";
+#endif
+} // namespace
+
+// ==================== SSESession 重连间隔测试 ====================
+
+TEST(SSESessionTest, DefaultReconnectDelay) {
+  SSESession session(nullptr, Request(std::string("http://127.0.0.1/")));
+  EXPECT_EQ(session.getReconnectDelay(), SSESession::DEFAULT_RETRY);
+}
+
+TEST(SSESessionTest, BackoffPolicyReconnectDelay) {
+  SSESession session(nullptr, Request(std::string("http://127.0.0.1/")));
+  session.setBackoffPolicy(fixedBackoff(100));
+  EXPECT_EQ(session.getReconnectDelay(), 100);
+}
+
+TEST(SSESessionTest, DefaultConfigHasNoReadTimeout) {
+  EXPECT_EQ(SSESession::defaultConfig().read_timeout_ms, 0);
+  EXPECT_EQ(SSESession::defaultConfig().idle_timeout_ms, 0);
+}
+
+TEST(SSESessionTest, NoClientEndsStream) {
+  SSESession session(nullptr, Request(std::string("http://127.0.0.1/")));
+  session.setLastEventId("5");
+  SSEEvent event;
+  EXPECT_FALSE(session.next(event));
+  EXPECT_EQ(session.getLastEventId(), "5");
+  EXPECT_EQ(session.getReconnects(), 0u);
+}
+
+#ifndef _WIN32
+
+// ==================== SSESession 断线重连测试 ====================
+
+TEST(SSESessionTest, ResumesWithLastEventId) {
+  // 第二个连接重放 id 2，应被去重
+  ScriptedServer server({eventStream("retry: 20\nid: 1\ndata: a\n\n"
+                                     "id: 2\ndata: b\n\n"),
+                         eventStream("id: 2\ndata: b\n\nid: 3\ndata: c\n\n"),
+                         noContent});
+  auto client = std::make_shared<MCurlHttpClient>();
+  client->start();
+
+  SSESession session(client, Request(server.url()));
+  std::vector<std::string> data;
+  SSEEvent event;
+  while (session.next(event)) {
+    data.push_back(event.getData());
+  }
+  EXPECT_EQ(data, (std::vector<std::string>{"a", "b", "c"}));
+  EXPECT_EQ(session.getDuplicates(), 1u);
+  EXPECT_EQ(session.getReconnects(), 2u);
+  EXPECT_EQ(session.getStatusCode(), 204);
+  EXPECT_EQ(session.getLastEventId(), "3");
+  // 服务器的 retry 覆盖默认间隔
+  EXPECT_EQ(session.getReconnectDelay(), 20);
+
+  auto requests = server.requests();
+  ASSERT_EQ(requests.size(), 3u);
+  EXPECT_EQ(requests[0].find("last-event-id"), std::string::npos);
+  EXPECT_NE(requests[0].find("text/event-stream"), std::string::npos);
+  EXPECT_NE(requests[1].find("last-event-id: 2"), std::string::npos);
+  EXPECT_NE(requests[2].find("last-event-id: 3"), std::string::npos);
+  client->stop();
+}
+
+TEST(SSESessionTest, EventWithoutIdIsNotDropped) {
+  // 重连后不带 id 的事件继承了 id 1，但不是重放
+  ScriptedServer server({eventStream("retry: 20\nid: 1\ndata: a\n\n"),
+                         eventStream("data: b\n\nid: 2\ndata: c\n\n"),
+                         noContent});
+  auto client = std::make_shared<MCurlHttpClient>();
+  client->start();
+
+  SSESession session(client, Request(server.url()));
+  std::vector<std::string> data;
+  SSEEvent event;
+  while (session.next(event)) {
+    data.push_back(event.getData());
+  }
+  EXPECT_EQ(data, (std::vector<std::string>{"a", "b", "c"}));
+  EXPECT_EQ(session.getDuplicates(), 0u);
+  EXPECT_EQ(session.getLastEventId(), "2");
+  client->stop();
+}
+
+TEST(SSESessionTest, StreamOutlivesReadTimeout) {
+  // 事件间隔 150ms，整个流持续时间超过 read timeout
+  ScriptedServer server({eventStream("retry: 20\nid: 1\ndata: a\n\n"
+                                     "id: 2\ndata: b\n\nid: 3\ndata: c\n\n"
+                                     "id: 4\ndata: d\n\nid: 5\ndata: e\n\n"),
+                         noContent},
+                        150);
+  auto client = std::make_shared<MCurlHttpClient>();
+  client->start();
+
+  RequestConfig config;
+  config.read_timeout_ms = 300;
+  SSESession session(client, Request(server.url()), config);
+  std::vector<std::string> data;
+  SSEEvent event;
+  while (session.next(event)) {
+    data.push_back(event.getData());
+  }
+  EXPECT_EQ(data, (std::vector<std::string>{"a", "b", "c", "d", "e"}));
+  // 只有流结束后的一次重连
+  EXPECT_EQ(session.getReconnects(), 1u);
+  EXPECT_EQ(server.requests().size(), 2u);
+  client->stop();
+}
+
+TEST(SSESessionTest, StopsAfterMaxReconnects) {
+  // 服务器一直返回 503
+  ScriptedServer server({"HTTP/1.1 503 Service Unavailable\r\n"
+                         "Content-Length: 0\r\nConnection: close\r\n\r\n"});
+  auto client = std::make_shared<MCurlHttpClient>();
+  client->start();
+
+  SSESession session(client, Request(server.url()));
+  session.setBackoffPolicy(fixedBackoff(10));
+  session.setMaxReconnects(2);
+  SSEEvent event;
+  EXPECT_FALSE(session.next(event));
+  EXPECT_EQ(session.getStatusCode(), 503);
+  EXPECT_EQ(server.requests().size(), 3u);
+  client->stop();
+}
+
+TEST(SSESessionTest, ClientErrorEndsStream) {
+  ScriptedServer server({"HTTP/1.1 404 Not Found\r\n"
+                         "Content-Length: 0\r\nConnection: close\r\n\r\n"});
+  auto client = std::make_shared<MCurlHttpClient>();
+  client->start();
+
+  SSESession session(client, Request(server.url()));
+  SSEEvent event;
+  EXPECT_FALSE(session.next(event));
+  EXPECT_EQ(session.getStatusCode(), 404);
+  EXPECT_EQ(session.getReconnects(), 0u);
+  client->stop();
+}
+
+TEST(SSESessionTest, CloseInterruptsReconnectDelay) {
+  ScriptedServer server({eventStream("retry: 60000\nid: 1\ndata: a\n\n")});
+  auto client = std::make_shared<MCurlHttpClient>();
+  client->start();
+
+  SSESession session(client, Request(server.url()));
+  SSEEvent event;
+  ASSERT_TRUE(session.next(event));
+  EXPECT_EQ(event.getData(), "a");
+
+  std::thread closer([&session]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    session.close();
+  });
+  auto start = std::chrono::steady_clock::now();
+  // 等待 60 秒重连的过程中被 close 唤醒
+  EXPECT_FALSE(session.next(event));
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  closer.join();
+  EXPECT_LT(elapsed, std::chrono::seconds(10));
+  client->stop();
+}
+
+#endif
@@ -0,0 +1,137 @@
+#include <darabonba/lock/MPSCQueue.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace Darabonba::Lock;
+
+// ==================== MPSCQueue 基础测试 ====================
+
+TEST(MPSCQueueTest, CapacityRoundedToPowerOfTwo) {
+  MPSCQueue<int> queue(100);
+  EXPECT_EQ(queue.capacity(), 128u);
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(MPSCQueueTest, PopFromEmptyQueue) {
+  MPSCQueue<int> queue(4);
+  int value = -1;
+  EXPECT_FALSE(queue.pop(value));
+  EXPECT_EQ(value, -1);
+}
+
+TEST(MPSCQueueTest, FifoOrder) {
+  MPSCQueue<int> queue(8);
+  for (int i = 0; i < 5; ++i) {
+    queue.push(i);
+  }
+  EXPECT_EQ(queue.size(), 5u);
+  int value = 0;
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_TRUE(queue.pop(value));
+    EXPECT_EQ(value, i);
+  }
+  EXPECT_FALSE(queue.pop(value));
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(MPSCQueueTest, WrapAround) {
+  MPSCQueue<int> queue(4);
+  int value = 0;
+  for (int i = 0; i < 100; ++i) {
+    queue.push(i);
+    queue.push(i + 1000);
+    ASSERT_TRUE(queue.pop(value));
+    EXPECT_EQ(value, i);
+    ASSERT_TRUE(queue.pop(value));
+    EXPECT_EQ(value, i + 1000);
+  }
+  EXPECT_TRUE(queue.empty());
+}
+
+// ==================== 溢出测试 ====================
+
+TEST(MPSCQueueTest, OverflowWhenRingIsFull) {
+  MPSCQueue<int> queue(4);
+  for (int i = 0; i < 10; ++i) {
+    queue.push(i);
+  }
+  EXPECT_EQ(queue.size(), 10u);
+  // the ring is drained first, then the overflow list
+  int value = 0;
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(queue.pop(value));
+    EXPECT_EQ(value, i);
+  }
+  EXPECT_FALSE(queue.pop(value));
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(MPSCQueueTest, MoveOnlyElements) {
+  MPSCQueue<std::unique_ptr<int>> queue(2);
+  for (int i = 0; i < 5; ++i) {
+    queue.push(std::unique_ptr<int>(new int(i)));
+  }
+  std::unique_ptr<int> value;
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_TRUE(queue.pop(value));
+    ASSERT_NE(value, nullptr);
+    EXPECT_EQ(*value, i);
+  }
+}
+
+TEST(MPSCQueueTest, DestructorReleasesElements) {
+  auto tracker = std::make_shared<int>(0);
+  {
+    MPSCQueue<std::shared_ptr<int>> queue(2);
+    for (int i = 0; i < 5; ++i) {
+      queue.push(tracker);
+    }
+    EXPECT_EQ(tracker.use_count(), 6);
+  }
+  EXPECT_EQ(tracker.use_count(), 1);
+}
+
+// ==================== 并发测试 ====================
+
+TEST(MPSCQueueTest, MultipleProducers) {
+  const int producers = 8;
+  const int perProducer = 20000;
+  MPSCQueue<int> queue(64);
+
+  std::atomic<bool> go(false);
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p) {
+    threads.emplace_back([&queue, &go, p, perProducer]() {
+      while (!go) {
+        std::this_thread::yield();
+      }
+      for (int i = 0; i < perProducer; ++i) {
+        queue.push(p * perProducer + i);
+      }
+    });
+  }
+
+  std::vector<bool> seen(producers * perProducer, false);
+  int received = 0;
+  go = true;
+  int value = 0;
+  while (received < producers * perProducer) {
+    if (!queue.pop(value)) {
+      std::this_thread::yield();
+      continue;
+    }
+    ASSERT_GE(value, 0);
+    ASSERT_LT(value, producers * perProducer);
+    EXPECT_FALSE(seen[value]);
+    seen[value] = true;
+    ++received;
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  EXPECT_FALSE(queue.pop(value));
+  EXPECT_TRUE(queue.empty());
+}
@@ -446,6 +446,18 @@ TEST_F(CoreTest, ConnectionPoolConfigAllFields) {
   EXPECT_FALSE(config.keep_alive);
 }
 
+TEST_F(CoreTest, ConnectionPoolConfigHttp2Defaults) {
+  ConnectionPoolConfig config;
+  EXPECT_FALSE(config.http2);
+  EXPECT_FALSE(config.http2_prior_knowledge);
+  EXPECT_EQ(config.max_concurrent_streams, 100UL);
+
+  ConnectionPoolConfig http2 = config;
+  http2.http2 = true;
+  EXPECT_TRUE(config < http2);
+  EXPECT_FALSE(http2 < config);
+}
+
 TEST_F(CoreTest, ConnectionPoolConfigCopy) {
   ConnectionPoolConfig config1;
   config1.host = "original.com";
@@ -607,6 +619,53 @@ TEST_F(CoreTest, SameHostReusesClient) {
   }
 }
 
+TEST_F(CoreTest, ReactorKeysSelectClient) {
+  Core::ClearAllHttpClients();
+
+  try {
+    Json runtime;
+    runtime["connectTimeout"] = 1000;
+    Http::Request request1(std::string("http://127.0.0.1:1/"));
+    core.doAction(request1, runtime).wait_for(std::chrono::seconds(10));
+
+    // 另一个 reactor 上的同一 host 使用单独的客户端
+    runtime["ioThreads"] = 2;
+    Http::Request request2(std::string("http://127.0.0.1:1/"));
+    core.doAction(request2, runtime).wait_for(std::chrono::seconds(10));
+    EXPECT_EQ(Core::GetHttpClientCount(), 2UL);
+
+    runtime["eventDriven"] = true;
+    Http::Request request3(std::string("http://127.0.0.1:1/"));
+    core.doAction(request3, runtime).wait_for(std::chrono::seconds(10));
+    EXPECT_EQ(Core::GetHttpClientCount(), 3UL);
+
+    // http2 的传输在多路复用的 reactor 上
+    runtime["http2"] = true;
+    Http::Request request4(std::string("http://127.0.0.1:1/"));
+    core.doAction(request4, runtime).wait_for(std::chrono::seconds(10));
+    EXPECT_EQ(Core::GetHttpClientCount(), 4UL);
+
+    ConnectionPoolConfig config;
+    config.host = "127.0.0.1";
+    config.io_threads = 2;
+    config.event_driven = true;
+    config.http2 = true;
+    Core::ClearHttpClient(config);
+    EXPECT_EQ(Core::GetHttpClientCount(), 3UL);
+    config.http2 = false;
+    Core::ClearHttpClient(config);
+    EXPECT_EQ(Core::GetHttpClientCount(), 2UL);
+    config.event_driven = false;
+    Core::ClearHttpClient(config);
+    EXPECT_EQ(Core::GetHttpClientCount(), 1UL);
+
+    Core::ClearAllHttpClients();
+
+  } catch (const std::exception &e) {
+    std::cerr << "Network test skipped: " << e.what() << std::endl;
+  }
+}
+
 // ==================== ClearHttpClient 测试 ====================
 TEST_F(CoreTest, ClearSpecificHttpClient) {
   Core::ClearAllHttpClients();
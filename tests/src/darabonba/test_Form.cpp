@@ -131,6 +131,45 @@ TEST_F(FormTest, ToFileFormWithEmptyForm) {
   EXPECT_NE(stream, nullptr);
 }
 
+TEST_F(FormTest, ToFileFormStreamsFileContent) {
+  // Json 中只保存指针，内容流需要保持存活
+  std::shared_ptr<IStream> fileContent =
+      std::make_shared<ISStream>(std::string("file content"));
+  Json file;
+  file["filename"] = "a.txt";
+  file["contentType"] = "text/plain";
+  file["content"] = fileContent;
+  Json form;
+  form["file"] = file;
+  form["key"] = "value";
+
+  auto stream = Form::toFileForm(form, "boundary");
+  std::string expected = "--boundary\r\n"
+                         "Content-Disposition: form-data; name=\"file\"; "
+                         "filename=\"a.txt\"\r\n"
+                         "Content-Type: text/plain\r\n\r\n"
+                         "file content\r\n"
+                         "--boundary\r\n"
+                         "Content-Disposition: form-data; name=\"key\"\r\n\r\n"
+                         "\"value\"\r\n"
+                         "--boundary--\r\n";
+  // 长度已知，可以带 Content-Length 上传
+  EXPECT_EQ(stream->remainingSize(), static_cast<int64_t>(expected.size()));
+
+  // 小缓冲区逐段读取时内容不丢失
+  std::string content;
+  char buffer[7];
+  size_t n;
+  while ((n = stream->read(buffer, sizeof(buffer))) > 0) {
+    content.append(buffer, n);
+  }
+  EXPECT_EQ(content, expected);
+  EXPECT_TRUE(stream->isFinished());
+
+  EXPECT_TRUE(stream->rewind());
+  EXPECT_EQ(Stream::readAsString(stream), expected);
+}
+
 // ==================== encode 测试 ====================
 TEST_F(FormTest, EncodeEmptyString) {
   std::string result = Form::encode("");
@@ -1,7 +1,10 @@
 #include <darabonba/Exception.hpp>
 #include <darabonba/Stream.hpp>
 #include <darabonba/Type.hpp>
+#include <darabonba/http/Curl.hpp>
 #include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
 #include <memory>
 #include <sstream>
 #include <vector>
@@ -169,6 +172,54 @@ TEST_F(StreamTest, ReadFromFilePathWithNonExistentFile) {
   EXPECT_THROW(Stream::readFromFilePath("/non/existent/path/file.txt"), Darabonba::DaraException);
 }
 
+// ==================== readFromFileMapped 测试 ====================
+TEST_F(StreamTest, ReadFromFileMappedWithNonExistentFile) {
+  EXPECT_THROW(Stream::readFromFileMapped("/non/existent/path/file.txt"),
+               Darabonba::DaraException);
+}
+
+TEST_F(StreamTest, MMapIStreamReadsFile) {
+  std::string content;
+  for (int i = 0; i < 100000; ++i) {
+    content.push_back(static_cast<char>(i % 251));
+  }
+  {
+    std::ofstream ofs("mmap_stream_test.bin", std::ios::binary);
+    ofs.write(content.data(), static_cast<std::streamsize>(content.size()));
+  }
+  auto stream = Stream::readFromFileMapped("mmap_stream_test.bin");
+  auto mapped = std::dynamic_pointer_cast<MMapIStream>(stream);
+  ASSERT_NE(mapped, nullptr);
+  EXPECT_EQ(mapped->size(), content.size());
+  EXPECT_EQ(std::string(mapped->data(), content.size()), content);
+
+  // 按调用方给出的大小读取
+  std::vector<char> buffer(70000);
+  EXPECT_EQ(stream->read(buffer.data(), buffer.size()), 70000u);
+  EXPECT_FALSE(stream->isFinished());
+  EXPECT_EQ(stream->read(buffer.data(), buffer.size()), 30000u);
+  EXPECT_TRUE(stream->isFinished());
+  EXPECT_EQ(stream->read(buffer.data(), buffer.size()), 0u);
+
+  // reset 之后从头读取
+  Stream::reset(stream);
+  EXPECT_EQ(mapped->position(), 0u);
+  EXPECT_EQ(Stream::readAsString(stream), content);
+  std::remove("mmap_stream_test.bin");
+}
+
+TEST_F(StreamTest, MMapIStreamEmptyFile) {
+  { std::ofstream ofs("mmap_stream_empty.bin", std::ios::binary); }
+  MMapIStream stream("mmap_stream_empty.bin");
+  EXPECT_TRUE(stream.isOpen());
+  EXPECT_EQ(stream.size(), 0u);
+  EXPECT_EQ(stream.data(), nullptr);
+  EXPECT_TRUE(stream.isFinished());
+  char buffer[16];
+  EXPECT_EQ(stream.read(buffer, sizeof(buffer)), 0u);
+  std::remove("mmap_stream_empty.bin");
+}
+
 // ==================== readFromBytes 测试 ====================
 TEST_F(StreamTest, ReadFromBytesCreatesValidStream) {
   std::vector<uint8_t> vec = {0x01, 0x02, 0x03, 0x04, 0x05};
@@ -216,6 +267,212 @@ TEST_F(StreamTest, ISStreamReadWithEOF) {
   EXPECT_EQ(bytesRead, 0u);
 }
 
+TEST_F(StreamTest, ISStreamCopyKeepsSource) {
+  ISStream source(std::string("0123456789"));
+  char buffer[4];
+  source.read(buffer, sizeof(buffer));
+
+  // 拷贝未读的部分，原流的读取位置不变
+  ISStream copy(source);
+  EXPECT_EQ(copy.remainingSize(), 6);
+  EXPECT_EQ(source.remainingSize(), 6);
+  auto n = source.read(buffer, sizeof(buffer));
+  EXPECT_EQ(std::string(buffer, n), "4567");
+}
+
+// ==================== seek 测试 ====================
+TEST_F(StreamTest, ISStreamSeek) {
+  ISStream stream(std::string("0123456789"));
+  EXPECT_TRUE(stream.isSeekable());
+  EXPECT_EQ(Stream::readAsString(std::shared_ptr<IStream>(
+                &stream, [](IStream *) {})),
+            "0123456789");
+
+  // 读到末尾后仍可回到任意位置
+  EXPECT_TRUE(stream.seek(4));
+  char buffer[16];
+  auto n = stream.read(buffer, sizeof(buffer));
+  EXPECT_EQ(std::string(buffer, n), "456789");
+  EXPECT_TRUE(stream.rewind());
+  n = stream.read(buffer, 3);
+  EXPECT_EQ(std::string(buffer, n), "012");
+
+  EXPECT_TRUE(stream.seek(10));
+  EXPECT_FALSE(stream.seek(11));
+}
+
+TEST_F(StreamTest, IFStreamSeek) {
+  {
+    std::ofstream ofs("ifstream_seek_test.txt", std::ios::binary);
+    ofs << "abcdefghij";
+  }
+  auto stream = Stream::readFromFilePath("ifstream_seek_test.txt");
+  EXPECT_TRUE(stream->isSeekable());
+  EXPECT_EQ(Stream::readAsString(stream), "abcdefghij");
+  EXPECT_TRUE(stream->seek(7));
+  EXPECT_EQ(Stream::readAsString(stream), "hij");
+  EXPECT_FALSE(stream->seek(100));
+  Stream::reset(stream);
+  EXPECT_EQ(Stream::readAsString(stream), "abcdefghij");
+  std::remove("ifstream_seek_test.txt");
+}
+
+TEST_F(StreamTest, MMapIStreamSeek) {
+  {
+    std::ofstream ofs("mmap_seek_test.txt", std::ios::binary);
+    ofs << "abcdefghij";
+  }
+  MMapIStream stream("mmap_seek_test.txt");
+  EXPECT_TRUE(stream.isSeekable());
+  EXPECT_TRUE(stream.seek(5));
+  EXPECT_EQ(stream.position(), 5u);
+  char buffer[16];
+  auto n = stream.read(buffer, sizeof(buffer));
+  EXPECT_EQ(std::string(buffer, n), "fghij");
+  EXPECT_FALSE(stream.seek(11));
+  EXPECT_TRUE(stream.rewind());
+  EXPECT_EQ(stream.position(), 0u);
+  std::remove("mmap_seek_test.txt");
+}
+
+TEST_F(StreamTest, CurlSeekCallbackReplaysBody) {
+  ISStream seekable(std::string("payload"));
+  char buffer[16];
+  EXPECT_EQ(Http::Curl::readIStream(buffer, 1, sizeof(buffer), &seekable), 7u);
+  // curl 重发请求体前回到开头
+  EXPECT_EQ(Http::Curl::seekIStream(&seekable, 0, SEEK_SET), CURL_SEEKFUNC_OK);
+  auto n = Http::Curl::readIStream(buffer, 1, sizeof(buffer), &seekable);
+  EXPECT_EQ(std::string(buffer, n), "payload");
+  EXPECT_EQ(Http::Curl::seekIStream(&seekable, 100, SEEK_SET),
+            CURL_SEEKFUNC_FAIL);
+  EXPECT_EQ(Http::Curl::seekIStream(&seekable, 0, SEEK_END),
+            CURL_SEEKFUNC_CANTSEEK);
+}
+
+// ==================== 长度已知的流测试 ====================
+TEST_F(StreamTest, ISStreamRemainingSize) {
+  ISStream stream(std::string("0123456789"));
+  EXPECT_EQ(stream.remainingSize(), 10);
+  ASSERT_NE(stream.contiguousData(), nullptr);
+  EXPECT_EQ(std::string(stream.contiguousData(), 10), "0123456789");
+
+  // 读取后只剩下未读的部分
+  char buffer[4];
+  EXPECT_EQ(stream.read(buffer, sizeof(buffer)), 4u);
+  EXPECT_EQ(stream.remainingSize(), 6);
+  EXPECT_EQ(std::string(stream.contiguousData(), 6), "456789");
+  stream.rewind();
+  EXPECT_EQ(stream.remainingSize(), 10);
+}
+
+TEST_F(StreamTest, IFStreamRemainingSize) {
+  {
+    std::ofstream ofs("ifstream_size_test.txt", std::ios::binary);
+    ofs << "abcdefghij";
+  }
+  IFStream stream("ifstream_size_test.txt", std::ios::binary);
+  EXPECT_EQ(stream.remainingSize(), 10);
+  EXPECT_EQ(stream.contiguousData(), nullptr);
+  ASSERT_TRUE(stream.seek(3));
+  EXPECT_EQ(stream.remainingSize(), 7);
+  // 查询长度不改变读取位置
+  char buffer[16];
+  auto n = stream.read(buffer, 3);
+  EXPECT_EQ(std::string(buffer, n), "def");
+  std::remove("ifstream_size_test.txt");
+
+  IFStream missing("non_existent_size_test.txt");
+  EXPECT_EQ(missing.remainingSize(), -1);
+}
+
+TEST_F(StreamTest, MMapIStreamRemainingSize) {
+  {
+    std::ofstream ofs("mmap_size_test.txt", std::ios::binary);
+    ofs << "abcdefghij";
+  }
+  MMapIStream stream("mmap_size_test.txt");
+  EXPECT_EQ(stream.remainingSize(), 10);
+  EXPECT_EQ(stream.contiguousData(), stream.data());
+  stream.seek(8);
+  EXPECT_EQ(stream.remainingSize(), 2);
+  EXPECT_EQ(std::string(stream.contiguousData(), 2), "ij");
+  std::remove("mmap_size_test.txt");
+
+  MMapIStream missing("non_existent_size_test.txt");
+  EXPECT_EQ(missing.remainingSize(), -1);
+  EXPECT_EQ(missing.contiguousData(), nullptr);
+}
+
+// ==================== ChainIStream 测试 ====================
+TEST_F(StreamTest, ChainIStreamConcatenatesParts) {
+  static const char header[] = "HEAD:";
+  auto chain = std::make_shared<ChainIStream>();
+  chain->append(header, sizeof(header) - 1)
+      .append(std::make_shared<ISStream>(std::string("{\"a\":1}")))
+      .append(std::string(":TAIL"))
+      .append(std::string())
+      .append(std::shared_ptr<IStream>());
+  // 空的部分被忽略
+  EXPECT_EQ(chain->partCount(), 3u);
+  EXPECT_EQ(chain->remainingSize(), 17);
+  EXPECT_TRUE(chain->isSeekable());
+  EXPECT_EQ(chain->contiguousData(), nullptr);
+
+  // 一次读取可以跨越多个部分
+  char buffer[8];
+  auto n = chain->read(buffer, sizeof(buffer));
+  EXPECT_EQ(std::string(buffer, n), "HEAD:{\"a");
+  EXPECT_EQ(chain->remainingSize(), 9);
+  EXPECT_EQ(Stream::readAsString(chain), "\":1}:TAIL");
+  EXPECT_TRUE(chain->isFinished());
+  EXPECT_EQ(chain->remainingSize(), 0);
+}
+
+TEST_F(StreamTest, ChainIStreamSeek) {
+  auto chain = std::make_shared<ChainIStream>();
+  chain->append(std::string("0123"))
+      .append(std::make_shared<ISStream>(std::string("4567")))
+      .append(std::string("89"));
+  EXPECT_EQ(Stream::readAsString(chain), "0123456789");
+
+  // 回到中间的流，之后的部分重新读取
+  EXPECT_TRUE(chain->seek(5));
+  EXPECT_EQ(Stream::readAsString(chain), "56789");
+  // 只剩一个内存块时可以直接交给 curl
+  EXPECT_TRUE(chain->seek(9));
+  ASSERT_NE(chain->contiguousData(), nullptr);
+  EXPECT_EQ(std::string(chain->contiguousData(), 1), "9");
+  EXPECT_TRUE(chain->rewind());
+  EXPECT_EQ(Stream::readAsString(chain), "0123456789");
+  EXPECT_TRUE(chain->seek(10));
+  EXPECT_TRUE(chain->isFinished());
+  EXPECT_FALSE(chain->seek(11));
+}
+
+TEST_F(StreamTest, ChainIStreamWithUnknownSize) {
+  // 长度未知的部分使整个流长度未知且不可 seek
+  class UnsizedStream : public IStream {
+  public:
+    virtual size_t read(char *buffer, size_t expectSize) override {
+      if (done_ || expectSize == 0)
+        return 0;
+      buffer[0] = 'x';
+      done_ = true;
+      return 1;
+    }
+    virtual bool isFinished() const override { return done_; }
+
+  private:
+    bool done_ = false;
+  };
+  auto chain = std::make_shared<ChainIStream>();
+  chain->append(std::string("a")).append(std::make_shared<UnsizedStream>());
+  EXPECT_EQ(chain->remainingSize(), -1);
+  EXPECT_FALSE(chain->isSeekable());
+  EXPECT_FALSE(chain->rewind());
+  EXPECT_EQ(Stream::readAsString(chain), "ax");
+}
+
 // ==================== OSStream 测试 ====================
 TEST_F(StreamTest, OSStreamWriteWorks) {
   std::ostringstream oss;